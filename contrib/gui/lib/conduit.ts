@@ -15,15 +15,19 @@
 //  along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 
+enum ClientOpcode {
+  C2S_DELTA_VALUES = 0x02,
+}
+
 enum ServerOpcode {
   S2C_ADD_WAVE = 0x00,
-  S2C_SIGNAL_UPDATE = 0x01,
   S2C_INIT_CMD = 0x02,
   S2C_START_SIM = 0x03,
   S2C_RESTART_SIM = 0x04,
   S2C_QUIT_SIM = 0x05,
   S2C_NEXT_TIME_STEP = 0x06,
   S2C_BACKCHANNEL = 0x07,
+  S2C_SIGNAL_BATCH = 0x09,
 }
 
 class PacketBuffer {
@@ -40,6 +44,12 @@ class PacketBuffer {
     return this.data.getUint8(this.pos++);
   }
 
+  public unpackU16(): number {
+    const value = this.data.getUint16(this.pos);
+    this.pos += 2;
+    return value;
+  }
+
   public unpackU32(): number {
     const value = this.data.getUint32(this.pos);
     this.pos += 4;
@@ -70,7 +80,7 @@ class PacketBuffer {
 }
 
 interface IWebSocket {
-  send(text: string): void;
+  send(data: string | ArrayBuffer): void;
   close(): void;
   onmessage: ((ev: MessageEvent) => any) | null;
   onclose: ((ev: CloseEvent) => any) | null;
@@ -80,6 +90,8 @@ interface IWebSocket {
 class Conduit {
   private socket: IWebSocket;
   private jsonBuffer: string = "";
+  private waveIds: Map<string, number> = new Map();
+  private waves: { path: string, value: string }[] = [];
 
   onConsoleOutput: (data: string) => void = console.log;
   onAddWave: (path: string, value: string) => void = () => {};
@@ -108,6 +120,9 @@ class Conduit {
     };
 
     this.socket.onopen = () => {
+      // Signal batches only carry the changed suffix of each value
+      // once the server is told this client can decode them
+      this.socket.send(new Uint8Array([ClientOpcode.C2S_DELTA_VALUES]).buffer);
       this.onOpen?.();
     };
   }
@@ -120,13 +135,15 @@ class Conduit {
       case ServerOpcode.S2C_ADD_WAVE:
         this.parseAddWave(packet);
         break;
-      case ServerOpcode.S2C_SIGNAL_UPDATE:
-        this.parseSignalUpdate(packet);
+      case ServerOpcode.S2C_SIGNAL_BATCH:
+        this.parseSignalBatch(packet);
         break;
       case ServerOpcode.S2C_INIT_CMD:
         this.parseInitCommand(packet);
         break;
       case ServerOpcode.S2C_START_SIM:
+        this.waveIds.clear();
+        this.waves = [];
         this.parseStartSim(packet);
         break;
       case ServerOpcode.S2C_RESTART_SIM:
@@ -150,6 +167,17 @@ class Conduit {
   private parseAddWave(packet: PacketBuffer) {
     const path = packet.unpackString();
     const value = packet.unpackString();
+
+    // The server numbers signals in the order they are first added
+    // and batched updates refer to them by this index
+    const id = this.waveIds.get(path);
+    if (id === undefined) {
+      this.waveIds.set(path, this.waves.length);
+      this.waves.push({ path, value });
+    }
+    else
+      this.waves[id].value = value;
+
     this.onAddWave(path, value);
   }
 
@@ -165,10 +193,27 @@ class Conduit {
     this.onStartSim?.(packet.unpackString());
   }
 
-  private parseSignalUpdate(packet: PacketBuffer) {
-    const path = packet.unpackString();
-    const value = packet.unpackString();
-    this.onSignalUpdate(path, value);
+  private parseSignalBatch(packet: PacketBuffer) {
+    packet.unpackU64();   // Time of the changes
+    const count = packet.unpackU32();
+    const decoder = new TextDecoder();
+
+    for (let i = 0; i < count; i++) {
+      const id = packet.unpackU32();
+      const prefix = packet.unpackU16();
+      const suffix = decoder.decode(packet.unpackRaw(packet.unpackU16()));
+
+      // Each value is sent as the length of the prefix shared with the
+      // previous value for that signal followed by the new characters
+      const wave = this.waves[id];
+      if (wave === undefined) {
+        console.log("signal update for unknown wave " + id);
+        continue;
+      }
+
+      wave.value = wave.value.slice(0, prefix) + suffix;
+      this.onSignalUpdate(wave.path, wave.value);
+    }
   }
 
   private parseBackchannel(packet: PacketBuffer) {
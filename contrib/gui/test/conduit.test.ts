@@ -46,8 +46,8 @@ class BrowserWebSocket {
     });
   }
 
-  send(text: string) {
-    this.socket.send(text);
+  send(data: string | ArrayBuffer) {
+    this.socket.send(data);
   }
 
   close() {
@@ -96,3 +96,35 @@ test("backchannel", (done) => {
 
   c.onClose = done;
 });
+
+test("signal batch", (done) => {
+  const ws = new BrowserWebSocket("ws://localhost:8888");
+  const c = new Conduit(ws);
+
+  c.onConsoleOutput = () => {};
+  c.onInitCommand = () => {};
+
+  const values: string[] = [];
+
+  c.onStartSim = () => {
+    c.onAddWave = (path, value) => {
+      expect(path).toBe("/clk");
+      values.push(value);
+    };
+
+    c.onSignalUpdate = (path, value) => {
+      expect(path).toBe("/clk");
+      values.push(value);
+
+      if (values.length == 3) {
+        expect(values).toStrictEqual(["b0", "b1", "b0"]);
+        c.close();
+      }
+    };
+
+    c.evalTcl("add wave /clk");
+    c.evalTcl("run 10 ns");
+  };
+
+  c.onClose = done;
+});
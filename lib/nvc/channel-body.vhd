@@ -0,0 +1,57 @@
+-------------------------------------------------------------------------------
+--  Copyright (C) 2025  Nick Gasson
+--
+--  Licensed under the Apache License, Version 2.0 (the "License");
+--  you may not use this file except in compliance with the License.
+--  You may obtain a copy of the License at
+--
+--     http://www.apache.org/licenses/LICENSE-2.0
+--
+--  Unless required by applicable law or agreed to in writing, software
+--  distributed under the License is distributed on an "AS IS" BASIS,
+--  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+--  See the License for the specific language governing permissions and
+--  limitations under the License.
+-------------------------------------------------------------------------------
+
+package body channel is
+
+    impure function channel_open (path  : string;
+                                  depth : positive := 1024;
+                                  width : positive := 16) return t_channel is
+    begin
+        assert false severity failure;
+    end function;
+
+    procedure channel_close (ch : in t_channel) is
+    begin
+        assert false severity failure;
+    end procedure;
+
+    impure function channel_try_send (ch   : t_channel;
+                                      data : t_word_vector) return boolean is
+    begin
+        assert false severity failure;
+    end function;
+
+    procedure channel_send (ch : in t_channel; data : in t_word_vector) is
+    begin
+        assert false severity failure;
+    end procedure;
+
+    procedure channel_try_recv (ch     : in t_channel;
+                                data   : out t_word_vector;
+                                length : out natural;
+                                valid  : out boolean) is
+    begin
+        assert false severity failure;
+    end procedure;
+
+    procedure channel_recv (ch     : in t_channel;
+                            data   : out t_word_vector;
+                            length : out natural) is
+    begin
+        assert false severity failure;
+    end procedure;
+
+end package body;
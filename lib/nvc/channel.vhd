@@ -0,0 +1,75 @@
+-------------------------------------------------------------------------------
+--  Copyright (C) 2025  Nick Gasson
+--
+--  Licensed under the Apache License, Version 2.0 (the "License");
+--  you may not use this file except in compliance with the License.
+--  You may obtain a copy of the License at
+--
+--     http://www.apache.org/licenses/LICENSE-2.0
+--
+--  Unless required by applicable law or agreed to in writing, software
+--  distributed under the License is distributed on an "AS IS" BASIS,
+--  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+--  See the License for the specific language governing permissions and
+--  limitations under the License.
+-------------------------------------------------------------------------------
+
+-------------------------------------------------------------------------------
+-- Shared memory channel for exchanging transactions with a foreign model
+-- written in C or C++ which may run in a separate process.  The layout of
+-- the shared file is described in the installed nvc_channel.h header.
+-------------------------------------------------------------------------------
+
+package channel is
+
+    type t_channel is range -1 to 2147483647;
+
+    type t_word_vector is array (natural range <>) of integer;
+
+    -- Create the file PATH containing a pair of queues each holding up to
+    -- DEPTH messages of at most WIDTH words
+    impure function channel_open (path  : string;
+                                  depth : positive := 1024;
+                                  width : positive := 16) return t_channel;
+
+    procedure channel_close (ch : in t_channel);
+
+    -- Queue a message for the foreign model returning false if the queue
+    -- is full
+    impure function channel_try_send (ch   : t_channel;
+                                      data : t_word_vector) return boolean;
+
+    -- Queue a message for the foreign model waiting for space if the
+    -- queue is full.  The simulation does not advance while waiting so
+    -- a model that runs in the same process at the end of a time step
+    -- must use CHANNEL_TRY_SEND instead.
+    procedure channel_send (ch : in t_channel; data : in t_word_vector);
+
+    -- Copy the next message from the foreign model into DATA setting
+    -- VALID to false if there is none
+    procedure channel_try_recv (ch     : in t_channel;
+                                data   : out t_word_vector;
+                                length : out natural;
+                                valid  : out boolean);
+
+    -- Copy the next message from the foreign model into DATA waiting for
+    -- one to arrive if the queue is empty.  As for CHANNEL_SEND a model
+    -- in the same process must use CHANNEL_TRY_RECV instead.
+    procedure channel_recv (ch     : in t_channel;
+                            data   : out t_word_vector;
+                            length : out natural);
+
+    attribute foreign of channel_open : function
+        is "INTERNAL _nvc_channel_open";
+    attribute foreign of channel_close : procedure
+        is "INTERNAL _nvc_channel_close";
+    attribute foreign of channel_try_send : function
+        is "INTERNAL _nvc_channel_try_send";
+    attribute foreign of channel_send : procedure
+        is "INTERNAL _nvc_channel_send";
+    attribute foreign of channel_try_recv : procedure
+        is "INTERNAL _nvc_channel_try_recv";
+    attribute foreign of channel_recv : procedure
+        is "INTERNAL _nvc_channel_recv";
+
+end package;
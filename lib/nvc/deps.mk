@@ -1,5 +1,9 @@
 # Generated by nvc 1.16-devel
 
+lib/nvc/NVC.CHANNEL-body: lib/std/STD.STANDARD lib/nvc/NVC.CHANNEL $(top_srcdir)/lib/nvc/channel-body.vhd
+
+lib/nvc/NVC.CHANNEL: lib/std/STD.STANDARD $(top_srcdir)/lib/nvc/channel.vhd
+
 lib/nvc/NVC.COVER_PKG-body: lib/std/STD.STANDARD lib/nvc/NVC.COVER_PKG $(top_srcdir)/lib/nvc/cover_pkg-body.vhd
 
 lib/nvc/NVC.COVER_PKG: lib/std/STD.STANDARD $(top_srcdir)/lib/nvc/cover_pkg.vhd
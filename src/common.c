@@ -16,12 +16,15 @@
 //
 
 #include "util.h"
+#include "array.h"
 #include "common.h"
 #include "diag.h"
 #include "hash.h"
 #include "ident.h"
 #include "lib.h"
 #include "lower.h"
+#include "mask.h"
+#include "object.h"
 #include "option.h"
 #include "phase.h"
 #include "scan.h"
@@ -36,6 +39,8 @@
 #include <string.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 static vhdl_standard_t  current_std  = STD_08;
 static bool             have_set_std = false;
@@ -475,6 +480,12 @@ void set_standard(vhdl_standard_t s)
    have_set_std = true;
 }
 
+void reset_standard(void)
+{
+   current_std = STD_08;
+   have_set_std = false;
+}
+
 void set_default_standard(vhdl_standard_t s)
 {
    if (!have_set_std)
@@ -1307,8 +1318,9 @@ static tree_t search_type_decls(tree_t container, ident_t name)
 
 type_t std_type(tree_t std, std_type_t which)
 {
-   static type_t cache[STD_FILE_OPEN_STATE + 1] = {};
-   assert(which < ARRAY_LEN(cache));
+   static type_t cache_by_std[STD_19 + 1][STD_FILE_OPEN_STATE + 1] = {};
+   type_t *cache = cache_by_std[standard()];
+   assert(which < ARRAY_LEN(cache_by_std[0]));
 
    if (cache[which] == NULL) {
       const char *names[] = {
@@ -1349,8 +1361,9 @@ type_t std_type(tree_t std, std_type_t which)
 
 type_t ieee_type(ieee_type_t which)
 {
-   static type_t cache[IEEE_STD_LOGIC_VECTOR + 1] = {};
-   assert(which < ARRAY_LEN(cache));
+   static type_t cache_by_std[STD_19 + 1][IEEE_STD_LOGIC_VECTOR + 1] = {};
+   type_t *cache = cache_by_std[standard()];
+   assert(which < ARRAY_LEN(cache_by_std[0]));
 
    if (cache[which] == NULL) {
       static const char *const names[] = {
@@ -1384,8 +1397,9 @@ static tree_t cached_verilog(void)
 
 type_t verilog_type(verilog_type_t which)
 {
-   static type_t cache[VERILOG_WIRE_ARRAY + 1] = {};
-   assert(which < ARRAY_LEN(cache));
+   static type_t cache_by_std[STD_19 + 1][VERILOG_WIRE_ARRAY + 1] = {};
+   type_t *cache = cache_by_std[standard()];
+   assert(which < ARRAY_LEN(cache_by_std[0]));
 
    if (cache[which] == NULL) {
       static const char *const names[] = {
@@ -1413,8 +1427,9 @@ type_t verilog_type(verilog_type_t which)
 
 type_t reflection_type(reflect_type_t which)
 {
-   static type_t cache[REFLECT_SUBTYPE_MIRROR + 1] = {};
-   assert(which < ARRAY_LEN(cache));
+   static type_t cache_by_std[STD_19 + 1][REFLECT_SUBTYPE_MIRROR + 1] = {};
+   type_t *cache = cache_by_std[standard()];
+   assert(which < ARRAY_LEN(cache_by_std[0]));
 
    if (cache[which] == NULL) {
       static const char *const names[] = {
@@ -2636,6 +2651,128 @@ void analyse_file(const char *file, jit_t *jit, unit_registry_t *ur,
    }
 }
 
+typedef struct {
+   const char *file;
+   uint64_t    hash;
+   bool        hashed;
+} source_hash_t;
+
+static uint64_t fnv1a_64(uint64_t hash, const void *data, size_t size)
+{
+   const uint8_t *p = data;
+   for (size_t i = 0; i < size; i++)
+      hash = (hash ^ p[i]) * UINT64_C(0x100000001b3);
+   return hash;
+}
+
+static void fingerprint_define(const char *name, const char *value, void *ctx)
+{
+   uint64_t *sum = ctx, hash = UINT64_C(0xcbf29ce484222325);
+   hash = fnv1a_64(hash, name, strlen(name) + 1);
+   hash = fnv1a_64(hash, value, strlen(value));
+
+   *sum += hash;   // Independent of iteration order
+}
+
+static uint64_t analysis_fingerprint(void)
+{
+   // Everything other than the source text that affects the result of
+   // analysing a file
+   const uint32_t opts[] = {
+      object_format_digest(),
+      standard(),
+      opt_get_int(OPT_RELAXED),
+      opt_get_int(OPT_PSL_COMMENTS),
+      opt_get_int(OPT_CHECK_SYNTHESIS),
+      opt_get_int(OPT_PRESERVE_CASE),
+      opt_get_int(OPT_SINGLE_UNIT),
+      opt_get_int(OPT_BOOTSTRAP),
+   };
+
+   uint64_t defines = 0;
+   pp_defines_iter(fingerprint_define, &defines);
+
+   uint64_t hash = UINT64_C(0xcbf29ce484222325);
+   hash = fnv1a_64(hash, opts, sizeof(opts));
+   hash = fnv1a_64(hash, &defines, sizeof(defines));
+   return hash;
+}
+
+static void hash_source_job(void *context, void *arg)
+{
+   source_hash_t *sh = arg;
+   const uint64_t *fingerprint = context;
+
+   file_info_t info;
+   if (!get_file_info(sh->file, &info) || info.type != FILE_REGULAR
+       || info.size == 0)
+      return;   // Errors are reported during analysis
+
+   int fd = open(sh->file, O_RDONLY);
+   if (fd < 0)
+      return;
+
+   void *map = map_file(fd, info.size);
+   close(fd);
+
+   sh->hash = fnv1a_64(*fingerprint, map, info.size);
+   sh->hashed = true;
+
+   unmap_file(map, info.size);
+}
+
+static bool hash_source_wanted(const char *file)
+{
+   if (strcmp(file, "-") == 0)
+      return false;
+
+   const char *ext = strrchr(file, '.');
+   if (ext == NULL)
+      return true;
+
+   return strcmp(ext, ".v") != 0 && strcmp(ext, ".sv") != 0
+      && strcmp(ext, ".sdf") != 0;
+}
+
+void analyse_files(const char **files, int nfiles, jit_t *jit,
+                   unit_registry_t *ur, mir_context_t *mc)
+{
+   // Hash the VHDL source files concurrently so files that have not
+   // changed since they were last analysed can be skipped and then
+   // analyse the rest in the order given on the command line
+
+   source_hash_t *sh LOCAL = xcalloc_array(nfiles, sizeof(source_hash_t));
+   lib_t work = lib_work();
+   uint64_t fingerprint = analysis_fingerprint();
+
+   workq_t *wq = workq_new(&fingerprint);
+
+   for (int i = 0; i < nfiles; i++) {
+      sh[i].file = files[i];
+
+      if (hash_source_wanted(files[i]))
+         workq_do(wq, hash_source_job, &(sh[i]));
+   }
+
+   workq_start(wq);
+   workq_drain(wq);
+   workq_free(wq);
+
+   for (int i = 0; i < nfiles; i++) {
+      if (!sh[i].hashed)
+         analyse_file(files[i], jit, ur, mc);
+      else if (opt_get_int(OPT_INCREMENTAL)
+               && lib_source_unchanged(work, files[i], sh[i].hash))
+         progress("skipped unchanged file: %s", files[i]);
+      else {
+         lib_begin_source(work, files[i], sh[i].hash);
+         analyse_file(files[i], jit, ur, mc);
+         lib_begin_source(work, NULL, 0);
+         progress("analysed file: %s", files[i]);
+      }
+   }
+}
+
 bool all_character_literals(type_t type)
 {
    assert(type_is_enum(type));
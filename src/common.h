@@ -96,6 +96,8 @@ type_t merge_constraints(type_t to, type_t from);
 
 void analyse_file(const char *file, jit_t *jit, unit_registry_t *ur,
                   mir_context_t *mc);
+void analyse_files(const char **files, int nfiles, jit_t *jit,
+                   unit_registry_t *ur, mir_context_t *mc);
 
 void print_syntax(const char *fmt, ...)
    __attribute__((format(printf, 1, 2)));
@@ -142,6 +144,7 @@ typedef enum {
 vhdl_standard_t standard(void);
 void set_standard(vhdl_standard_t s);
 void set_default_standard(vhdl_standard_t s);
+void reset_standard(void);
 const char *standard_text(vhdl_standard_t s);
 
 //
@@ -226,6 +226,11 @@ bool cover_enabled(cover_data_t *data, cover_mask_t mask);
 void cover_dump_items(cover_data_t *data, fbuf_t *f, cover_dump_t dt);
 cover_data_t *cover_read_items(fbuf_t *f, uint32_t pre_mask);
 void cover_merge_items(fbuf_t *f, cover_data_t *data, merge_mode_t mode);
+cover_data_t *cover_merge_files(const char **files, int nfiles,
+                                uint32_t pre_mask, merge_mode_t mode,
+                                ident_t scope);
+cover_data_t *cover_read_file(const char *file, uint32_t pre_mask);
+void cover_write_file(cover_data_t *data, const char *file, cover_dump_t dt);
 
 int32_t *cover_get_counters(cover_data_t *db, ident_t name);
 cover_scope_t *cover_get_scope(cover_data_t *db, ident_t name);
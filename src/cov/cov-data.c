@@ -28,6 +28,7 @@
 #include "option.h"
 #include "tree.h"
 #include "psl/psl-node.h"
+#include "thread.h"
 #include "type.h"
 
 #include <assert.h>
@@ -67,6 +68,8 @@ static const struct {
 #define COVER_FILE_MAGIC   0x6e636462   // ASCII "ncdb"
 #define COVER_FILE_VERSION 4
 
+#define MERGE_MIN_FILES_PER_JOB 4
+
 static inline unsigned get_next_tag(cover_block_t *b)
 {
    assert(b->data == NULL);
@@ -732,16 +735,15 @@ cover_item_t *cover_add_items_for(cover_data_t *data, cover_scope_t *cs,
 // Coverage data write/read to covdb, covdb merging and coverage scope handling
 ///////////////////////////////////////////////////////////////////////////////
 
-void cover_merge_one_item(cover_item_t *item, int32_t data)
+int32_t cover_merge_counter(cover_item_kind_t kind, int32_t dst, int32_t src)
 {
-   switch (item->kind) {
+   switch (kind) {
    case COV_ITEM_STMT:
    case COV_ITEM_FUNCTIONAL:
    case COV_ITEM_BRANCH:
    case COV_ITEM_STATE:
    case COV_ITEM_EXPRESSION:
-      item->data = saturate_add(item->data, data);
-      break;
+      return saturate_add(dst, src);
 
    // Highest bit of run-time data for COV_ITEM_TOGGLE is used to track
    // unreachability due to being constant driven. If multiple designs
@@ -751,18 +753,21 @@ void cover_merge_one_item(cover_item_t *item, int32_t data)
    // the other was driven. So, If the unreachability is detected, enforce
    // its propagation further to the merged database
    case COV_ITEM_TOGGLE:
-
-      if ((item->data & COV_FLAG_UNREACHABLE) || (data & COV_FLAG_UNREACHABLE))
-         item->data = COV_FLAG_UNREACHABLE;
+      if ((dst & COV_FLAG_UNREACHABLE) || (src & COV_FLAG_UNREACHABLE))
+         return COV_FLAG_UNREACHABLE;
       else
-         item->data = saturate_add(item->data, data);
-      break;
+         return saturate_add(dst, src);
 
    default:
-      break;
+      return dst;
    }
 }
 
+void cover_merge_one_item(cover_item_t *item, int32_t data)
+{
+   item->data = cover_merge_counter(item->kind, item->data, data);
+}
+
 static void cover_update_counts(cover_scope_t *s)
 {
    if (s->block != NULL && s->block->data != NULL) {
@@ -901,6 +906,10 @@ void cover_data_free(cover_data_t *db)
              alloc, npages);
 #endif
 
+   for (int i = 0; i < db->adopted.count; i++)
+      pool_free(db->adopted.items[i]);
+   ACLEAR(db->adopted);
+
    hash_free(db->blocks);
    pool_free(db->pool);
    free(db);
@@ -1120,6 +1129,10 @@ static void cover_read_one_item(fbuf_t *f, loc_rd_ctx_t *loc_rd,
       item->func_name = ident_read(ident_ctx);
 }
 
+static void cover_read_scope_body(cover_data_t *db, fbuf_t *f,
+                                  ident_rd_ctx_t ident_ctx,
+                                  loc_rd_ctx_t *loc_ctx, cover_scope_t *s);
+
 static cover_scope_t *cover_read_scope(cover_data_t *db, fbuf_t *f,
                                        ident_rd_ctx_t ident_ctx,
                                        loc_rd_ctx_t *loc_ctx,
@@ -1127,14 +1140,38 @@ static cover_scope_t *cover_read_scope(cover_data_t *db, fbuf_t *f,
 {
    cover_scope_t *s = pool_calloc(db->pool, sizeof(cover_scope_t));
    s->name  = ident_read(ident_ctx);
-   s->hier  = ident_read(ident_ctx);
    s->block = b;
 
+   cover_read_scope_body(db, f, ident_ctx, loc_ctx, s);
+   return s;
+}
+
+static cover_block_t *cover_read_block(cover_data_t *db, fbuf_t *f,
+                                       ident_rd_ctx_t ident_ctx,
+                                       loc_rd_ctx_t *loc_ctx, ident_t name)
+{
+   cover_block_t *b = xcalloc(sizeof(cover_block_t));
+   b->name = name;
+   b->block_name = ident_read(ident_ctx);
+   b->kind = fbuf_get_uint(f);
+   b->next_tag = fbuf_get_uint(f);
+   b->self = cover_read_scope(db, f, ident_ctx, loc_ctx, b);
+
+   hash_put(db->blocks, b->name, b);
+   return b;
+}
+
+static void cover_read_scope_body(cover_data_t *db, fbuf_t *f,
+                                  ident_rd_ctx_t ident_ctx,
+                                  loc_rd_ctx_t *loc_ctx, cover_scope_t *s)
+{
+   s->hier = ident_read(ident_ctx);
+
    loc_read(&s->loc, loc_ctx);
 
    const int nitems = fbuf_get_uint(f);
    for (int i = 0; i < nitems; i++) {
-      cover_item_t new;
+      cover_item_t new = {};
       cover_read_one_item(f, loc_ctx, ident_ctx, &new);
 
       APUSH(s->items, new);
@@ -1149,15 +1186,7 @@ static cover_scope_t *cover_read_scope(cover_data_t *db, fbuf_t *f,
             ident_t name = ident_read(ident_ctx);
             cover_block_t *b = hash_get(db->blocks, name);
             if (b == NULL) {
-               b = xcalloc(sizeof(cover_block_t));
-               b->name = name;
-               b->block_name = ident_read(ident_ctx);
-               b->kind = fbuf_get_uint(f);
-               b->next_tag = fbuf_get_uint(f);
-               b->self = cover_read_scope(db, f, ident_ctx, loc_ctx, b);
-
-               hash_put(db->blocks, b->name, b);
-
+               b = cover_read_block(db, f, ident_ctx, loc_ctx, name);
                APUSH(s->children, b->self);
             }
             else {
@@ -1174,12 +1203,12 @@ static cover_scope_t *cover_read_scope(cover_data_t *db, fbuf_t *f,
       case CTRL_PUSH_SCOPE:
          {
             cover_scope_t *child =
-               cover_read_scope(db, f, ident_ctx, loc_ctx, b);
+               cover_read_scope(db, f, ident_ctx, loc_ctx, s->block);
             APUSH(s->children, child);
          }
          break;
       case CTRL_POP_SCOPE:
-         return s;
+         return;
       default:
          fatal_trace("invalid control word %x in cover db", ctrl);
       }
@@ -1218,45 +1247,62 @@ cover_data_t *cover_read_items(fbuf_t *f, uint32_t pre_mask)
    return data;
 }
 
-static void cover_merge_scope(cover_scope_t *old_s, cover_scope_t *new_s,
-                              merge_mode_t mode)
+static cover_item_t *cover_match_item(cover_scope_t *s,
+                                      const cover_item_t *item, int hint)
 {
-   // Most merged cover scopes have equal items.
-   // Start from equal item index in old and new scope instead of iterating
-   // for each items.
-   // If new scope has extra item in the middle (e.g. due to generic sized array)
-   // account for offset. Then there is no reiteration upon added items.
-   int n_added = 0;
-   for (int i = 0; i < new_s->items.count; i++) {
-      cover_item_t *new = AREF(new_s->items, i);
-      cover_item_t *old = AREF(old_s->items, i - n_added);
+   // Most merged cover scopes have equal items so start from the same
+   // index in the old scope rather than iterating over every item
+   const int count = s->items.count;
+   const int start = hint < count ? hint : 0;
+
+   for (int i = 0; i < count; i++) {
+      cover_item_t *old = AREF(s->items, (start + i) % count);
+      if (old->hier == item->hier && old->flags == item->flags) {
+         assert(old->kind == item->kind);
+#ifdef COVER_DEBUG_MERGE
+         printf("Merging coverage item: %s\n", istr(old->hier));
+#endif
+         return old;
+      }
+   }
 
-      bool found = false;
-      int n_old_visits = 0;
+   return NULL;
+}
 
-      do {
-         if (n_old_visits == old_s->items.count)
-            break;
+static cover_scope_t *cover_match_child(cover_scope_t *s, ident_t name)
+{
+   for (int i = 0; i < s->children.count; i++) {
+      if (s->children.items[i]->name == name)
+         return s->children.items[i];
+   }
 
-         if ((new->hier == old->hier) && (new->flags == old->flags)) {
-            assert(new->kind == old->kind);
-#ifdef COVER_DEBUG_MERGE
-            printf("Merging coverage item: %s\n", istr(old->hier));
-#endif
-            cover_merge_one_item(old, new->data);
-            found = true;
-            break;
-         }
+   return NULL;
+}
 
-         if (old == AREF(old_s->items, old_s->items.count - 1))
-            old = AREF(old_s->items, 0);
-         else
-            old++;
+static void cover_adopt_scope(cover_data_t *data, cover_scope_t *s)
+{
+   // Register blocks in a subtree moved from another database
+   if (s->block != NULL && s->block->self == s
+       && hash_get(data->blocks, s->block->name) == NULL)
+      hash_put(data->blocks, s->block->name, s->block);
 
-         n_old_visits++;
-      } while (true);
+   for (int i = 0; i < s->children.count; i++)
+      cover_adopt_scope(data, s->children.items[i]);
+}
 
-      if (!found && mode == MERGE_UNION) {
+static void cover_merge_scope(cover_data_t *data, cover_scope_t *old_s,
+                              cover_scope_t *new_s, merge_mode_t mode)
+{
+   // If new scope has extra item in the middle (e.g. due to generic
+   // sized array) account for offset. Then there is no reiteration upon
+   // added items.
+   int n_added = 0;
+   for (int i = 0; i < new_s->items.count; i++) {
+      cover_item_t *new = AREF(new_s->items, i);
+      cover_item_t *old = cover_match_item(old_s, new, i - n_added);
+      if (old != NULL)
+         cover_merge_one_item(old, new->data);
+      else if (mode == MERGE_UNION) {
          APUSH(old_s->items, *new);
          n_added++;
       }
@@ -1264,18 +1310,104 @@ static void cover_merge_scope(cover_scope_t *old_s, cover_scope_t *new_s,
 
    for (int i = 0; i < new_s->children.count; i++) {
       cover_scope_t *new_c = new_s->children.items[i];
-      bool found = false;
-      for (int j = 0; j < old_s->children.count; j++) {
-         cover_scope_t *old_c = old_s->children.items[j];
-         if (new_c->name == old_c->name) {
-            cover_merge_scope(old_c, new_c, mode);
-            found = true;
-            break;
-         }
+      cover_scope_t *old_c = cover_match_child(old_s, new_c->name);
+      if (old_c != NULL)
+         cover_merge_scope(data, old_c, new_c, mode);
+      else if (mode == MERGE_UNION) {
+         cover_adopt_scope(data, new_c);
+         APUSH(old_s->children, new_c);
       }
+   }
+}
 
-      if (!found && mode == MERGE_UNION)
-         APUSH(old_s->children, new_c);
+static void cover_stream_scope(cover_data_t *db, fbuf_t *f,
+                               ident_rd_ctx_t ident_ctx, loc_rd_ctx_t *loc_ctx,
+                               cover_scope_t *old_s, merge_mode_t mode)
+{
+   // Merge the scope being read directly into an existing scope without
+   // first building a tree for the new database
+
+   (void)ident_read(ident_ctx);   // Hierarchical name
+
+   loc_t loc;
+   loc_read(&loc, loc_ctx);
+
+   int n_added = 0;
+   const int nitems = fbuf_get_uint(f);
+   for (int i = 0; i < nitems; i++) {
+      cover_item_t new = {};
+      cover_read_one_item(f, loc_ctx, ident_ctx, &new);
+
+      cover_item_t *old = cover_match_item(old_s, &new, i - n_added);
+      if (old != NULL) {
+         cover_merge_one_item(old, new.data);
+         free(new.ranges);
+      }
+      else if (mode == MERGE_UNION) {
+         APUSH(old_s->items, new);
+         n_added++;
+      }
+      else
+         free(new.ranges);
+   }
+
+   for (;;) {
+      const uint8_t ctrl = read_u8(f);
+      switch (ctrl) {
+      case CTRL_PUSH_UNIT:
+         {
+            ident_t name = ident_read(ident_ctx);
+            cover_block_t *b = hash_get(db->blocks, name);
+            if (b == NULL) {
+               b = cover_read_block(db, f, ident_ctx, loc_ctx, name);
+               if (mode == MERGE_UNION)
+                  APUSH(old_s->children, b->self);
+               break;
+            }
+
+            (void)ident_read(ident_ctx);
+            (void)fbuf_get_uint(f);
+            (void)fbuf_get_uint(f);
+
+            ident_t child = ident_read(ident_ctx);
+            cover_scope_t *old_c = cover_match_child(old_s, child);
+            if (old_c != NULL)
+               cover_stream_scope(db, f, ident_ctx, loc_ctx, old_c, mode);
+            else {
+               cover_scope_t *new_c =
+                  pool_calloc(db->pool, sizeof(cover_scope_t));
+               new_c->name  = child;
+               new_c->block = b;
+               cover_read_scope_body(db, f, ident_ctx, loc_ctx, new_c);
+
+               if (mode == MERGE_UNION)
+                  APUSH(old_s->children, new_c);
+            }
+         }
+         break;
+      case CTRL_PUSH_SCOPE:
+         {
+            ident_t child = ident_read(ident_ctx);
+            cover_scope_t *old_c = cover_match_child(old_s, child);
+            if (old_c != NULL)
+               cover_stream_scope(db, f, ident_ctx, loc_ctx, old_c, mode);
+            else {
+               cover_scope_t *new_c =
+                  pool_calloc(db->pool, sizeof(cover_scope_t));
+               new_c->name  = child;
+               new_c->block = old_s->block;
+               cover_read_scope_body(db, f, ident_ctx, loc_ctx, new_c);
+
+               if (mode == MERGE_UNION)
+                  APUSH(old_s->children, new_c);
+            }
+         }
+         break;
+      case CTRL_POP_SCOPE:
+         return;
+      default:
+         fatal_trace("invalid control word %x in cover db", ctrl);
+      }
    }
 }
 
@@ -1294,9 +1426,10 @@ void cover_merge_items(fbuf_t *f, cover_data_t *data, merge_mode_t mode)
       switch (ctrl) {
       case CTRL_PUSH_SCOPE:
          {
-            cover_scope_t *new =
-               cover_read_scope(data, f, ident_ctx, loc_rd, NULL);
-            cover_merge_scope(data->root_scope, new, mode);
+            (void)ident_read(ident_ctx);   // Root scope name
+
+            cover_stream_scope(data, f, ident_ctx, loc_rd,
+                               data->root_scope, mode);
          }
          break;
       case CTRL_END_OF_FILE:
@@ -1311,6 +1444,201 @@ void cover_merge_items(fbuf_t *f, cover_data_t *data, merge_mode_t mode)
    loc_read_end(loc_rd);
 }
 
+typedef struct {
+   const char   **files;
+   int            nfiles;
+   uint32_t       pre_mask;
+   merge_mode_t   mode;
+   cover_data_t  *result;
+} merge_job_t;
+
+typedef struct {
+   cover_data_t *dst;
+   cover_data_t *src;
+   merge_mode_t  mode;
+} reduce_job_t;
+
+static void cover_merge_data(cover_data_t *dst, cover_data_t *src,
+                             merge_mode_t mode)
+{
+   cover_merge_scope(dst, dst->root_scope, src->root_scope, mode);
+
+   // Scopes and items from the source database may now be referenced
+   // by the destination so its memory must live as long as that
+   APUSH(dst->adopted, src->pool);
+   for (int i = 0; i < src->adopted.count; i++)
+      APUSH(dst->adopted, src->adopted.items[i]);
+
+   ACLEAR(src->adopted);
+   hash_free(src->blocks);
+   free(src);
+}
+
+static void cover_merge_file_job(void *context, void *arg)
+{
+   merge_job_t *job = arg;
+
+   job->result = cover_read_file(job->files[0], job->pre_mask);
+
+   for (int i = 1; i < job->nfiles; i++) {
+      cover_index_t *idx = cover_index_open(job->files[i]);
+      if (idx != NULL) {
+         cover_data_t *db = cover_index_read(idx, job->pre_mask, NULL);
+         cover_index_close(idx);
+
+         cover_merge_data(job->result, db, job->mode);
+         continue;
+      }
+
+      fbuf_t *f = fbuf_open(job->files[i], FBUF_IN, FBUF_CS_NONE);
+      if (f == NULL)
+         fatal_errno("could not open %s", job->files[i]);
+
+      cover_merge_items(f, job->result, job->mode);
+      fbuf_close(f, NULL);
+   }
+}
+
+static void cover_reduce_job(void *context, void *arg)
+{
+   reduce_job_t *job = arg;
+   cover_merge_data(job->dst, job->src, job->mode);
+}
+
+static cover_scope_t *cover_find_hier(cover_scope_t *s, ident_t hier)
+{
+   if (s->hier == hier)
+      return s;
+
+   for (int i = 0; i < s->children.count; i++) {
+      cover_scope_t *it = cover_find_hier(s->children.items[i], hier);
+      if (it != NULL)
+         return it;
+   }
+
+   return NULL;
+}
+
+static void cover_select_scope(cover_data_t *data, ident_t hier)
+{
+   cover_scope_t *s = cover_find_hier(data->root_scope, hier);
+   if (s == NULL)
+      fatal("coverage database does not contain scope %s", istr(hier));
+   else if (s != data->root_scope) {
+      ATRIM(data->root_scope->children, 0);
+      APUSH(data->root_scope->children, s);
+   }
+}
+
+cover_data_t *cover_merge_files(const char **files, int nfiles,
+                                uint32_t pre_mask, merge_mode_t mode,
+                                ident_t scope)
+{
+   assert(nfiles > 0);
+
+   // Indexed databases with identical layout are merged by summing
+   // their counters without building any intermediate scope trees
+   cover_data_t *fast = cover_index_merge(files, nfiles, pre_mask, scope);
+   if (fast != NULL)
+      return fast;
+
+   // Each job streams a contiguous run of input files into its own
+   // database and then the partial results are combined pairwise: at
+   // least two runs are used when there are enough files so the
+   // reduction step behaves the same regardless of the number of CPUs
+   const int njobs = MAX(1, MIN(MAX(nvc_nprocs(), 2),
+                                nfiles / MERGE_MIN_FILES_PER_JOB));
+   const int per_job = (nfiles + njobs - 1) / njobs;
+
+   merge_job_t *jobs LOCAL = xcalloc_array(njobs, sizeof(merge_job_t));
+   workq_t *wq = workq_new(NULL);
+
+   int nparts = 0;
+   for (int i = 0; i < nfiles; i += per_job, nparts++) {
+      merge_job_t *job = &(jobs[nparts]);
+      job->files    = files + i;
+      job->nfiles   = MIN(per_job, nfiles - i);
+      job->pre_mask = pre_mask;
+
+      // Only the first database determines which items are kept when
+      // intersecting so any other partial result must retain all items
+      // until it is merged into that
+      job->mode = nparts == 0 ? mode : MERGE_UNION;
+
+      workq_do(wq, cover_merge_file_job, job);
+   }
+
+   workq_start(wq);
+   workq_drain(wq);
+
+   reduce_job_t *reduce LOCAL = xcalloc_array(nparts, sizeof(reduce_job_t));
+
+   for (int step = 1; step < nparts; step *= 2) {
+      int nreduce = 0;
+      for (int i = 0; i + step < nparts; i += step * 2) {
+         reduce_job_t *job = &(reduce[nreduce++]);
+         job->dst  = jobs[i].result;
+         job->src  = jobs[i + step].result;
+         job->mode = i == 0 ? mode : MERGE_UNION;
+
+         workq_do(wq, cover_reduce_job, job);
+      }
+
+      workq_start(wq);
+      workq_drain(wq);
+   }
+
+   workq_free(wq);
+
+   if (scope != NULL)
+      cover_select_scope(jobs[0].result, scope);
+
+   return jobs[0].result;
+}
+
+static bool cover_is_index_name(const char *file)
+{
+   const char *ext = strrchr(file, '.');
+   return ext != NULL && strcmp(ext, ".ncdx") == 0;
+}
+
+cover_data_t *cover_read_file(const char *file, uint32_t pre_mask)
+{
+   cover_index_t *idx = cover_index_open(file);
+   if (idx != NULL) {
+      cover_data_t *db = cover_index_read(idx, pre_mask, NULL);
+      cover_index_close(idx);
+      return db;
+   }
+
+   fbuf_t *f = fbuf_open(file, FBUF_IN, FBUF_CS_NONE);
+   if (f == NULL)
+      fatal_errno("failed to open coverage database: %s", file);
+
+   cover_data_t *db = cover_read_items(f, pre_mask);
+
+   fbuf_close(f, NULL);
+   return db;
+}
+
+void cover_write_file(cover_data_t *data, const char *file, cover_dump_t dt)
+{
+   if (cover_is_index_name(file)) {
+      if (dt == COV_DUMP_RUNTIME)
+         cover_update_counts(data->root_scope);
+
+      cover_index_write(data, file);
+   }
+   else {
+      fbuf_t *f = fbuf_open(file, FBUF_OUT, FBUF_CS_NONE);
+      if (f == NULL)
+         fatal_errno("failed to open coverage database: %s", file);
+
+      cover_dump_items(data, f, dt);
+      fbuf_close(f, NULL);
+   }
+}
+
 int32_t *cover_get_counters(cover_data_t *db, ident_t name)
 {
    if (db == NULL)
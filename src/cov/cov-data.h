@@ -72,6 +72,7 @@ struct _cover_data {
    cover_scope_t   *root_scope;
    hash_t          *blocks;
    mem_pool_t      *pool;
+   A(mem_pool_t *)  adopted;
 };
 
 typedef struct {
@@ -107,6 +108,17 @@ void cover_bmask_to_bin_list(uint32_t bmask, text_buf_t *tb);
 uint32_t cover_bin_str_to_bmask(const char *bin);
 const char *cover_item_kind_str(cover_item_kind_t kind);
 const char *cover_bmask_to_bin_str(uint32_t bmask);
+int32_t cover_merge_counter(cover_item_kind_t kind, int32_t dst, int32_t src);
 void cover_merge_one_item(cover_item_t *item, int32_t data);
 
+typedef struct _cover_index cover_index_t;
+
+cover_index_t *cover_index_open(const char *file);
+void cover_index_close(cover_index_t *idx);
+cover_data_t *cover_index_read(cover_index_t *idx, uint32_t pre_mask,
+                               ident_t scope);
+cover_data_t *cover_index_merge(const char **files, int nfiles,
+                                uint32_t pre_mask, ident_t scope);
+void cover_index_write(cover_data_t *data, const char *file);
+
 #endif   // _COV_DATA_H
@@ -0,0 +1,824 @@
+//
+//  Copyright (C) 2025  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "util.h"
+#include "array.h"
+#include "cov/cov-api.h"
+#include "cov/cov-data.h"
+#include "cov/cov-structs.h"
+#include "hash.h"
+#include "ident.h"
+#include "thread.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef ARCH_X86_64
+#include <x86intrin.h>
+#endif
+
+// The indexed coverage database is laid out so it can be mapped directly
+// into memory: a header followed by fixed size scope and item tables, a
+// table of functional coverage ranges, the counter for each item, a
+// table of scope indexes sorted by hierarchical path, and finally the
+// string table.  Scopes are stored in pre-order so the descendants of a
+// scope are contiguous.  All sections are in host byte order.
+
+#define INDEX_MAGIC   0x6e636478   // ASCII "ncdx"
+#define INDEX_VERSION 1
+#define INDEX_ENDIAN  0x0102
+#define INDEX_ALIGN   8
+
+#define SCOPE_F_UNIT (1 << 0)
+
+#define NO_PARENT UINT32_MAX
+
+typedef struct {
+   uint32_t magic;
+   uint16_t version;
+   uint16_t endian;
+   uint32_t mask;
+   uint32_t array_limit;
+   uint32_t nscopes;
+   uint32_t nitems;
+   uint32_t nranges;
+   uint32_t strsize;
+   uint64_t layout;
+   uint64_t scopes;
+   uint64_t items;
+   uint64_t ranges;
+   uint64_t counters;
+   uint64_t byhier;
+   uint64_t strings;
+} index_header_t;
+
+typedef struct {
+   uint32_t file;
+   uint32_t first_line;
+   uint16_t first_column;
+   uint8_t  line_delta;
+   uint8_t  column_delta;
+} index_loc_t;
+
+typedef struct {
+   uint32_t    name;
+   uint32_t    hier;
+   uint32_t    block;
+   uint32_t    block_name;
+   uint32_t    next_tag;
+   uint16_t    block_kind;
+   uint16_t    flags;
+   uint32_t    parent;
+   uint32_t    end;
+   uint32_t    first_item;
+   uint32_t    nitems;
+   index_loc_t loc;
+} index_scope_t;
+
+typedef struct {
+   uint8_t     kind;
+   uint8_t     source;
+   uint16_t    reserved;
+   int32_t     tag;
+   int32_t     flags;
+   int32_t     consecutive;
+   int32_t     atleast;
+   uint32_t    hier;
+   uint32_t    func_name;
+   uint32_t    first_range;
+   uint32_t    n_ranges;
+   uint32_t    reserved2;
+   int64_t     metadata;
+   index_loc_t loc;
+   index_loc_t loc_lhs;
+   index_loc_t loc_rhs;
+   uint32_t    reserved3;
+} index_item_t;
+
+STATIC_ASSERT(sizeof(index_header_t) % INDEX_ALIGN == 0);
+STATIC_ASSERT(sizeof(index_scope_t) % 4 == 0);
+STATIC_ASSERT(sizeof(index_item_t) % INDEX_ALIGN == 0);
+
+struct _cover_index {
+   char                 *file;
+   void                 *map;
+   size_t                mapsz;
+   const index_header_t *header;
+   const index_scope_t  *scopes;
+   const index_item_t   *items;
+   const cover_range_t  *ranges;
+   const int32_t        *counters;
+   const uint32_t       *byhier;
+   const char           *strings;
+};
+
+typedef struct {
+   A(index_scope_t) scopes;
+   A(index_item_t)  items;
+   A(cover_range_t) ranges;
+   A(int32_t)       counters;
+   hash_t          *strtab;
+   char            *strings;
+   size_t           strsize;
+   size_t           strmax;
+} index_wr_ctx_t;
+
+typedef struct {
+   cover_index_t *idx;
+   cover_data_t  *db;
+   const int32_t *counters;
+   hash_t        *files;
+} index_rd_ctx_t;
+
+typedef struct {
+   cover_index_t **idx;
+   int             count;
+   int32_t        *sum;
+   size_t          start;
+   size_t          end;
+} index_sum_job_t;
+
+#define INDEX_SUM_CHUNK 65536
+
+static uint64_t index_hash_bytes(uint64_t hash, const void *data, size_t size)
+{
+   // FNV-1a
+   const uint8_t *bytes = data;
+   for (size_t i = 0; i < size; i++)
+      hash = (hash ^ bytes[i]) * UINT64_C(0x100000001b3);
+
+   return hash;
+}
+
+static uint32_t index_put_string(index_wr_ctx_t *ctx, const void *key,
+                                 const char *str)
+{
+   if (str == NULL)
+      return 0;
+
+   void *cached = hash_get(ctx->strtab, key);
+   if (cached != NULL)
+      return (uintptr_t)cached;
+
+   const size_t len = strlen(str) + 1;
+   if (ctx->strsize + len > ctx->strmax) {
+      ctx->strmax = MAX(ctx->strmax * 2, ctx->strsize + len);
+      ctx->strings = xrealloc(ctx->strings, ctx->strmax);
+   }
+
+   const uint32_t off = ctx->strsize;
+   memcpy(ctx->strings + off, str, len);
+   ctx->strsize += len;
+
+   hash_put(ctx->strtab, key, (void *)(uintptr_t)off);
+   return off;
+}
+
+static uint32_t index_put_ident(index_wr_ctx_t *ctx, ident_t id)
+{
+   return id == NULL ? 0 : index_put_string(ctx, id, istr(id));
+}
+
+static void index_put_loc(index_wr_ctx_t *ctx, const loc_t *loc,
+                          index_loc_t *out)
+{
+   const char *file = loc_file_str(loc);
+
+   out->file         = index_put_string(ctx, file, file);
+   out->first_line   = loc->first_line;
+   out->first_column = loc->first_column;
+   out->line_delta   = loc->line_delta;
+   out->column_delta = loc->column_delta;
+}
+
+static void index_put_scope(index_wr_ctx_t *ctx, cover_scope_t *s,
+                            uint32_t parent)
+{
+   const uint32_t index = ctx->scopes.count;
+
+   index_scope_t is = {
+      .name       = index_put_ident(ctx, s->name),
+      .hier       = index_put_ident(ctx, s->hier),
+      .parent     = parent,
+      .first_item = ctx->items.count,
+      .nitems     = s->items.count,
+   };
+
+   if (s->block != NULL && s == s->block->self) {
+      is.flags      |= SCOPE_F_UNIT;
+      is.block       = index_put_ident(ctx, s->block->name);
+      is.block_name  = index_put_ident(ctx, s->block->block_name);
+      is.block_kind  = s->block->kind;
+      is.next_tag    = s->block->next_tag;
+   }
+
+   index_put_loc(ctx, &s->loc, &is.loc);
+
+   for (int i = 0; i < s->items.count; i++) {
+      const cover_item_t *item = &(s->items.items[i]);
+
+      index_item_t ii = {
+         .kind        = item->kind,
+         .source      = item->source,
+         .tag         = item->tag,
+         .flags       = item->flags,
+         .consecutive = item->consecutive,
+         .atleast     = item->atleast,
+         .hier        = index_put_ident(ctx, item->hier),
+         .first_range = ctx->ranges.count,
+         .n_ranges    = item->n_ranges,
+         .metadata    = item->metadata,
+      };
+
+      if (item->kind == COV_ITEM_EXPRESSION ||
+          item->kind == COV_ITEM_STATE ||
+          item->kind == COV_ITEM_FUNCTIONAL)
+         ii.func_name = index_put_ident(ctx, item->func_name);
+
+      index_put_loc(ctx, &item->loc, &ii.loc);
+      if (item->flags & COVER_FLAGS_LHS_RHS_BINS) {
+         index_put_loc(ctx, &item->loc_lhs, &ii.loc_lhs);
+         index_put_loc(ctx, &item->loc_rhs, &ii.loc_rhs);
+      }
+
+      for (int j = 0; j < item->n_ranges; j++)
+         APUSH(ctx->ranges, item->ranges[j]);
+
+      APUSH(ctx->items, ii);
+      APUSH(ctx->counters, item->data);
+   }
+
+   APUSH(ctx->scopes, is);
+
+   for (int i = 0; i < s->children.count; i++)
+      index_put_scope(ctx, s->children.items[i], index);
+
+   ctx->scopes.items[index].end = ctx->scopes.count;
+}
+
+static const char *index_sort_strings;
+
+static int index_hier_cmp(const void *a, const void *b)
+{
+   const index_scope_t *sa = *(const index_scope_t **)a;
+   const index_scope_t *sb = *(const index_scope_t **)b;
+
+   return strcmp(index_sort_strings + sa->hier,
+                 index_sort_strings + sb->hier);
+}
+
+static void index_write_section(FILE *f, const void *data, size_t size,
+                                uint64_t *offset, const char *file)
+{
+   static const uint8_t zeros[INDEX_ALIGN] = {};
+
+   long pos = ftell(f);
+   const size_t pad = ALIGN_UP(pos, INDEX_ALIGN) - pos;
+   if (pad > 0 && fwrite(zeros, pad, 1, f) != 1)
+      fatal_errno("failed writing %s", file);
+
+   *offset = pos + pad;
+
+   if (size > 0 && fwrite(data, size, 1, f) != 1)
+      fatal_errno("failed writing %s", file);
+}
+
+void cover_index_write(cover_data_t *data, const char *file)
+{
+   index_wr_ctx_t ctx = {
+      .strtab  = hash_new(256),
+      .strsize = 1,
+      .strmax  = 4096,
+   };
+
+   ctx.strings = xmalloc(ctx.strmax);
+   ctx.strings[0] = '\0';   // Offset zero is the null string
+
+   index_put_scope(&ctx, data->root_scope, NO_PARENT);
+
+   // Build the path index used to find a single scope without walking
+   // the whole tree
+   const index_scope_t **sorted LOCAL =
+      xmalloc_array(ctx.scopes.count, sizeof(index_scope_t *));
+   for (int i = 0; i < ctx.scopes.count; i++)
+      sorted[i] = &(ctx.scopes.items[i]);
+
+   index_sort_strings = ctx.strings;
+   qsort(sorted, ctx.scopes.count, sizeof(index_scope_t *), index_hier_cmp);
+   index_sort_strings = NULL;
+
+   uint32_t *byhier LOCAL = xmalloc_array(ctx.scopes.count, sizeof(uint32_t));
+   for (int i = 0; i < ctx.scopes.count; i++)
+      byhier[i] = sorted[i] - ctx.scopes.items;
+
+   index_header_t header = {
+      .magic       = INDEX_MAGIC,
+      .version     = INDEX_VERSION,
+      .endian      = INDEX_ENDIAN,
+      .mask        = data->mask,
+      .array_limit = data->array_limit,
+      .nscopes     = ctx.scopes.count,
+      .nitems      = ctx.items.count,
+      .nranges     = ctx.ranges.count,
+      .strsize     = ctx.strsize,
+   };
+
+   // Databases with the same layout can be merged by just summing the
+   // counter arrays
+   uint64_t layout = UINT64_C(0xcbf29ce484222325);
+   layout = index_hash_bytes(layout, ctx.scopes.items,
+                             ctx.scopes.count * sizeof(index_scope_t));
+   layout = index_hash_bytes(layout, ctx.items.items,
+                             ctx.items.count * sizeof(index_item_t));
+   layout = index_hash_bytes(layout, ctx.ranges.items,
+                             ctx.ranges.count * sizeof(cover_range_t));
+   layout = index_hash_bytes(layout, ctx.strings, ctx.strsize);
+   header.layout = layout;
+
+   FILE *f = fopen(file, "wb");
+   if (f == NULL)
+      fatal_errno("failed to open coverage database: %s", file);
+
+   if (fwrite(&header, sizeof(header), 1, f) != 1)
+      fatal_errno("failed writing %s", file);
+
+   index_write_section(f, ctx.scopes.items,
+                       ctx.scopes.count * sizeof(index_scope_t),
+                       &header.scopes, file);
+   index_write_section(f, ctx.items.items,
+                       ctx.items.count * sizeof(index_item_t),
+                       &header.items, file);
+   index_write_section(f, ctx.ranges.items,
+                       ctx.ranges.count * sizeof(cover_range_t),
+                       &header.ranges, file);
+   index_write_section(f, ctx.counters.items,
+                       ctx.counters.count * sizeof(int32_t),
+                       &header.counters, file);
+   index_write_section(f, byhier, ctx.scopes.count * sizeof(uint32_t),
+                       &header.byhier, file);
+   index_write_section(f, ctx.strings, ctx.strsize, &header.strings, file);
+
+   // Rewrite the header now the section offsets are known
+   if (fseek(f, 0, SEEK_SET) != 0)
+      fatal_errno("seek failed on %s", file);
+
+   if (fwrite(&header, sizeof(header), 1, f) != 1)
+      fatal_errno("failed writing %s", file);
+
+   if (fclose(f) != 0)
+      fatal_errno("failed writing %s", file);
+
+   ACLEAR(ctx.scopes);
+   ACLEAR(ctx.items);
+   ACLEAR(ctx.ranges);
+   ACLEAR(ctx.counters);
+   hash_free(ctx.strtab);
+   free(ctx.strings);
+}
+
+static void index_check_section(cover_index_t *idx, uint64_t offset,
+                                size_t count, size_t size)
+{
+   if (offset % INDEX_ALIGN != 0 || offset > idx->mapsz
+       || count > (idx->mapsz - offset) / size)
+      fatal("coverage database %s is corrupt", idx->file);
+}
+
+cover_index_t *cover_index_open(const char *file)
+{
+   int fd = open(file, O_RDONLY);
+   if (fd < 0)
+      return NULL;
+
+   uint32_t magic;
+   if (read(fd, &magic, sizeof(magic)) != sizeof(magic)
+       || magic != INDEX_MAGIC) {
+      close(fd);
+      return NULL;
+   }
+
+   file_info_t info;
+   if (!get_handle_info(fd, &info))
+      fatal_errno("%s: cannot get file info", file);
+
+   if (info.size < sizeof(index_header_t))
+      fatal("coverage database %s is truncated", file);
+
+   cover_index_t *idx = xcalloc(sizeof(cover_index_t));
+   idx->file   = xstrdup(file);
+   idx->mapsz  = info.size;
+   idx->map    = map_file(fd, info.size);
+   idx->header = idx->map;
+
+   close(fd);
+
+   const index_header_t *h = idx->header;
+
+   if (h->version != INDEX_VERSION)
+      fatal("coverage database %s format version %d is not the expected %d",
+            file, h->version, INDEX_VERSION);
+   else if (h->endian != INDEX_ENDIAN)
+      fatal("coverage database %s was written on a host with different "
+            "byte order", file);
+
+   index_check_section(idx, h->scopes, h->nscopes, sizeof(index_scope_t));
+   index_check_section(idx, h->items, h->nitems, sizeof(index_item_t));
+   index_check_section(idx, h->ranges, h->nranges, sizeof(cover_range_t));
+   index_check_section(idx, h->counters, h->nitems, sizeof(int32_t));
+   index_check_section(idx, h->byhier, h->nscopes, sizeof(uint32_t));
+   index_check_section(idx, h->strings, h->strsize, 1);
+
+   if (h->nscopes == 0 || h->strsize == 0)
+      fatal("coverage database %s is corrupt", file);
+
+   idx->scopes   = idx->map + h->scopes;
+   idx->items    = idx->map + h->items;
+   idx->ranges   = idx->map + h->ranges;
+   idx->counters = idx->map + h->counters;
+   idx->byhier   = idx->map + h->byhier;
+   idx->strings  = idx->map + h->strings;
+
+   if (idx->strings[h->strsize - 1] != '\0')
+      fatal("coverage database %s is corrupt", file);
+
+   return idx;
+}
+
+void cover_index_close(cover_index_t *idx)
+{
+   unmap_file(idx->map, idx->mapsz);
+   free(idx->file);
+   free(idx);
+}
+
+static const char *index_get_string(cover_index_t *idx, uint32_t off)
+{
+   if (off == 0)
+      return NULL;
+   else if (off >= idx->header->strsize)
+      fatal("coverage database %s is corrupt", idx->file);
+
+   return idx->strings + off;
+}
+
+static ident_t index_get_ident(cover_index_t *idx, uint32_t off)
+{
+   const char *str = index_get_string(idx, off);
+   return str == NULL ? NULL : ident_new(str);
+}
+
+static const index_scope_t *index_get_scope(cover_index_t *idx, uint32_t n)
+{
+   if (n >= idx->header->nscopes)
+      fatal("coverage database %s is corrupt", idx->file);
+
+   return &(idx->scopes[n]);
+}
+
+static void index_get_loc(index_rd_ctx_t *ctx, const index_loc_t *il,
+                          loc_t *loc)
+{
+   const char *file = index_get_string(ctx->idx, il->file);
+
+   file_ref_t ref = FILE_INVALID;
+   if (file != NULL) {
+      void *cached = hash_get(ctx->files, file);
+      if (cached != NULL)
+         ref = (uintptr_t)cached - 1;
+      else {
+         ref = loc_file_ref(file, NULL);
+         hash_put(ctx->files, file, (void *)(uintptr_t)(ref + 1));
+      }
+   }
+
+   loc->first_line   = il->first_line;
+   loc->first_column = il->first_column;
+   loc->line_delta   = il->line_delta;
+   loc->column_delta = il->column_delta;
+   loc->file_ref     = ref;
+}
+
+static cover_block_t *index_get_block(index_rd_ctx_t *ctx,
+                                      const index_scope_t *is)
+{
+   ident_t name = index_get_ident(ctx->idx, is->block);
+
+   cover_block_t *b = hash_get(ctx->db->blocks, name);
+   if (b == NULL) {
+      b = xcalloc(sizeof(cover_block_t));
+      b->name       = name;
+      b->block_name = index_get_ident(ctx->idx, is->block_name);
+      b->kind       = is->block_kind;
+      b->next_tag   = is->next_tag;
+
+      hash_put(ctx->db->blocks, name, b);
+   }
+
+   return b;
+}
+
+static cover_scope_t *index_read_scope(index_rd_ctx_t *ctx, uint32_t n,
+                                       cover_block_t *b)
+{
+   cover_index_t *idx = ctx->idx;
+   const index_scope_t *is = index_get_scope(idx, n);
+
+   if (is->first_item > idx->header->nitems
+       || is->nitems > idx->header->nitems - is->first_item
+       || is->end <= n || is->end > idx->header->nscopes)
+      fatal("coverage database %s is corrupt", idx->file);
+
+   cover_scope_t *s = pool_calloc(ctx->db->pool, sizeof(cover_scope_t));
+   s->name = index_get_ident(idx, is->name);
+   s->hier = index_get_ident(idx, is->hier);
+
+   if (is->flags & SCOPE_F_UNIT) {
+      s->block = index_get_block(ctx, is);
+      if (s->block->self == NULL)
+         s->block->self = s;
+   }
+   else
+      s->block = b;
+
+   index_get_loc(ctx, &is->loc, &s->loc);
+
+   for (uint32_t i = 0; i < is->nitems; i++) {
+      const uint32_t pos = is->first_item + i;
+      const index_item_t *ii = &(idx->items[pos]);
+
+      cover_item_t item = {
+         .kind        = ii->kind,
+         .tag         = ii->tag,
+         .data        = ctx->counters[pos],
+         .flags       = ii->flags,
+         .source      = ii->source,
+         .consecutive = ii->consecutive,
+         .atleast     = ii->atleast,
+         .metadata    = ii->metadata,
+         .n_ranges    = ii->n_ranges,
+         .hier        = index_get_ident(idx, ii->hier),
+         .func_name   = index_get_ident(idx, ii->func_name),
+      };
+
+      if (item.n_ranges > 0) {
+         if (ii->first_range > idx->header->nranges
+             || ii->n_ranges > idx->header->nranges - ii->first_range)
+            fatal("coverage database %s is corrupt", idx->file);
+
+         item.ranges = xmalloc_array(item.n_ranges, sizeof(cover_range_t));
+         memcpy(item.ranges, idx->ranges + ii->first_range,
+                item.n_ranges * sizeof(cover_range_t));
+      }
+
+      index_get_loc(ctx, &ii->loc, &item.loc);
+      if (item.flags & COVER_FLAGS_LHS_RHS_BINS) {
+         index_get_loc(ctx, &ii->loc_lhs, &item.loc_lhs);
+         index_get_loc(ctx, &ii->loc_rhs, &item.loc_rhs);
+      }
+
+      APUSH(s->items, item);
+   }
+
+   for (uint32_t child = n + 1; child < is->end; ) {
+      APUSH(s->children, index_read_scope(ctx, child, s->block));
+      child = index_get_scope(idx, child)->end;
+   }
+
+   return s;
+}
+
+static uint32_t index_find_scope(cover_index_t *idx, ident_t hier)
+{
+   const char *key = istr(hier);
+
+   int low = 0, high = idx->header->nscopes - 1;
+   while (low <= high) {
+      const int mid = (low + high) / 2;
+      const index_scope_t *is = index_get_scope(idx, idx->byhier[mid]);
+      const char *str = index_get_string(idx, is->hier) ?: "";
+
+      const int cmp = strcmp(key, str);
+      if (cmp == 0)
+         return idx->byhier[mid];
+      else if (cmp < 0)
+         high = mid - 1;
+      else
+         low = mid + 1;
+   }
+
+   fatal("coverage database %s does not contain scope %s", idx->file, key);
+}
+
+static cover_data_t *index_read(cover_index_t *idx, const int32_t *counters,
+                                uint32_t pre_mask, ident_t scope)
+{
+   cover_data_t *db = xcalloc(sizeof(cover_data_t));
+   db->mask        = idx->header->mask | pre_mask;
+   db->array_limit = idx->header->array_limit;
+   db->blocks      = hash_new(16);
+   db->pool        = pool_new();
+
+   index_rd_ctx_t ctx = {
+      .idx      = idx,
+      .db       = db,
+      .counters = counters,
+      .files    = hash_new(16),
+   };
+
+   const uint32_t n = scope == NULL ? 0 : index_find_scope(idx, scope);
+
+   if (n == 0)
+      db->root_scope = index_read_scope(&ctx, 0, NULL);
+   else {
+      // Only read the requested scope and its children below a copy of
+      // the root scope
+      const index_scope_t *root = index_get_scope(idx, 0);
+      db->root_scope = pool_calloc(db->pool, sizeof(cover_scope_t));
+      db->root_scope->name = index_get_ident(idx, root->name);
+      db->root_scope->hier = index_get_ident(idx, root->hier);
+      index_get_loc(&ctx, &root->loc, &db->root_scope->loc);
+
+      cover_block_t *b = NULL;
+      for (uint32_t p = index_get_scope(idx, n)->parent;
+           b == NULL && p != NO_PARENT;
+           p = index_get_scope(idx, p)->parent) {
+         const index_scope_t *is = index_get_scope(idx, p);
+         if (is->flags & SCOPE_F_UNIT)
+            b = index_get_block(&ctx, is);
+      }
+
+      APUSH(db->root_scope->children, index_read_scope(&ctx, n, b));
+   }
+
+   hash_free(ctx.files);
+   return db;
+}
+
+cover_data_t *cover_index_read(cover_index_t *idx, uint32_t pre_mask,
+                               ident_t scope)
+{
+   return index_read(idx, idx->counters, pre_mask, scope);
+}
+
+static void index_add_scalar(int32_t *dst, const int32_t *src,
+                             const index_item_t *items, size_t count)
+{
+   for (size_t i = 0; i < count; i++)
+      dst[i] = cover_merge_counter(items[i].kind, dst[i], src[i]);
+}
+
+static inline bool index_kind_adds(uint8_t kind)
+{
+   // Items for which cover_merge_counter is a plain saturating add when
+   // neither counter is negative
+   switch (kind) {
+   case COV_ITEM_STMT:
+   case COV_ITEM_FUNCTIONAL:
+   case COV_ITEM_BRANCH:
+   case COV_ITEM_STATE:
+   case COV_ITEM_EXPRESSION:
+   case COV_ITEM_TOGGLE:
+      return true;
+   default:
+      return false;
+   }
+}
+
+#ifdef HAVE_SSE41
+__attribute__((target("sse4.1")))
+static void index_add_sse41(int32_t *dst, const int32_t *src,
+                            const index_item_t *items, size_t count)
+{
+   const __m128i zero  = _mm_setzero_si128();
+   const __m128i max   = _mm_set1_epi32(INT32_MAX);
+
+   size_t pos = 0;
+   for (; pos + 3 < count; pos += 4) {
+      __m128i a = _mm_loadu_si128((const __m128i *)(dst + pos));
+      __m128i b = _mm_loadu_si128((const __m128i *)(src + pos));
+
+      // Negative counters and kinds that are not summed need the full
+      // per-kind merge rules
+      if (_mm_movemask_ps(_mm_castsi128_ps(_mm_or_si128(a, b))) != 0
+          || !index_kind_adds(items[pos].kind)
+          || !index_kind_adds(items[pos + 1].kind)
+          || !index_kind_adds(items[pos + 2].kind)
+          || !index_kind_adds(items[pos + 3].kind)) {
+         index_add_scalar(dst + pos, src + pos, items + pos, 4);
+         continue;
+      }
+
+      // Both inputs are non-negative so the sum can only overflow into
+      // the sign bit
+      __m128i sum = _mm_add_epi32(a, b);
+      __m128i ovf = _mm_cmpgt_epi32(zero, sum);
+
+      _mm_storeu_si128((__m128i *)(dst + pos),
+                       _mm_blendv_epi8(sum, max, ovf));
+   }
+
+   index_add_scalar(dst + pos, src + pos, items + pos, count - pos);
+}
+#endif
+
+static void index_add_counters(int32_t *dst, const int32_t *src,
+                               const index_item_t *items, size_t count)
+{
+#if defined HAVE_SSE41 && !ASAN_ENABLED
+   if (likely(__builtin_cpu_supports("sse4.1"))) {
+      index_add_sse41(dst, src, items, count);
+      return;
+   }
+#endif
+
+   index_add_scalar(dst, src, items, count);
+}
+
+static void index_sum_job(void *context, void *arg)
+{
+   index_sum_job_t *job = arg;
+
+   const index_item_t *items = job->idx[0]->items + job->start;
+
+   const size_t count = job->end - job->start;
+   for (int i = 1; i < job->count; i++)
+      index_add_counters(job->sum + job->start,
+                         job->idx[i]->counters + job->start, items, count);
+}
+
+cover_data_t *cover_index_merge(const char **files, int nfiles,
+                                uint32_t pre_mask, ident_t scope)
+{
+   // Fast path for merging indexed databases which all have the same
+   // layout: the counter arrays are combined element-wise using the same
+   // per-kind rules as cover_merge_one_item
+
+   cover_index_t **idx LOCAL = xcalloc_array(nfiles, sizeof(cover_index_t *));
+
+   bool same = true;
+   for (int i = 0; same && i < nfiles; i++) {
+      if ((idx[i] = cover_index_open(files[i])) == NULL)
+         same = false;
+      else if (idx[i]->header->layout != idx[0]->header->layout)
+         same = false;
+   }
+
+   if (!same) {
+      for (int i = 0; i < nfiles && idx[i] != NULL; i++)
+         cover_index_close(idx[i]);
+      return NULL;
+   }
+
+   const size_t nitems = idx[0]->header->nitems;
+
+   int32_t *sum LOCAL = xmalloc_array(MAX(nitems, 1), sizeof(int32_t));
+   memcpy(sum, idx[0]->counters, nitems * sizeof(int32_t));
+
+   if (nfiles > 1) {
+      const int njobs = (nitems + INDEX_SUM_CHUNK - 1) / INDEX_SUM_CHUNK;
+      index_sum_job_t *jobs LOCAL =
+         xcalloc_array(MAX(njobs, 1), sizeof(index_sum_job_t));
+
+      workq_t *wq = workq_new(NULL);
+
+      for (int i = 0; i < njobs; i++) {
+         jobs[i].idx   = idx;
+         jobs[i].count = nfiles;
+         jobs[i].sum   = sum;
+         jobs[i].start = i * INDEX_SUM_CHUNK;
+         jobs[i].end   = MIN(nitems, (i + 1) * INDEX_SUM_CHUNK);
+
+         workq_do(wq, index_sum_job, &(jobs[i]));
+      }
+
+      workq_start(wq);
+      workq_drain(wq);
+      workq_free(wq);
+   }
+
+   cover_data_t *db = index_read(idx[0], sum, pre_mask, scope);
+
+   for (int i = 0; i < nfiles; i++)
+      cover_index_close(idx[i]);
+
+   return db;
+}
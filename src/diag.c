@@ -101,6 +101,7 @@ typedef struct _hint_rec {
 static unsigned    n_diags[DIAG_FATAL + 1];
 static unsigned    error_limit = 0;
 static file_list_t loc_files;
+static nvc_lock_t  loc_files_lock = 0;
 static nvc_lock_t  diag_lock   = 0;
 
 static __thread diag_consumer_t  consumer_fn = NULL;
@@ -127,6 +128,8 @@ file_ref_t loc_file_ref(const char *name, const char *linebuf)
    if (name == NULL)
       return FILE_INVALID;
 
+   SCOPED_LOCK(loc_files_lock);
+
    for (unsigned i = 0; i < loc_files.count; i++) {
       if (strcmp(loc_files.items[i].name_str, name) == 0)
          return loc_files.items[i].ref;
@@ -357,24 +360,27 @@ void loc_read(loc_t *loc, loc_rd_ctx_t *ctx)
          fatal("corrupt location file reference %x", old_ref);
 
       if (ctx->ref_map[old_ref] == FILE_INVALID) {
+         // Coverage databases may be read concurrently
+         SCOPED_LOCK(loc_files_lock);
+
          for (unsigned i = 0; i < loc_files.count; i++) {
             if (strcmp(loc_files.items[i].name_str,
                        ctx->file_map[old_ref]) == 0)
                ctx->ref_map[old_ref] = loc_files.items[i].ref;
          }
-      }
 
-      if (ctx->ref_map[old_ref] == FILE_INVALID) {
-         loc_file_t new = {
-            .linebuf  = NULL,
-            .name_str = ctx->file_map[old_ref],
-            .ref      = loc_files.count
-         };
+         if (ctx->ref_map[old_ref] == FILE_INVALID) {
+            loc_file_t new = {
+               .linebuf  = NULL,
+               .name_str = ctx->file_map[old_ref],
+               .ref      = loc_files.count
+            };
 
-         APUSH(loc_files, new);
+            APUSH(loc_files, new);
 
-         ctx->ref_map[old_ref]  = new.ref;
-         ctx->file_map[old_ref] = NULL;   // Owned by loc_file_t now
+            ctx->ref_map[old_ref]  = new.ref;
+            ctx->file_map[old_ref] = NULL;   // Owned by loc_file_t now
+         }
       }
 
       new_ref = ctx->ref_map[old_ref];
@@ -49,6 +49,13 @@
 
 typedef A(tree_t) tree_list_t;
 
+typedef struct {
+   ident_t name;
+   ident_t parent;
+} elab_deferred_t;
+
+typedef A(elab_deferred_t) deferred_list_t;
+
 typedef struct _elab_ctx elab_ctx_t;
 typedef struct _generic_list generic_list_t;
 
@@ -70,6 +77,8 @@ typedef struct _elab_ctx {
    sdf_file_t       *sdf;
    driver_set_t     *drivers;
    hash_t           *modcache;
+   hash_t           *archcache;
+   deferred_list_t  *deferred;
    rt_model_t       *model;
    rt_scope_t       *scope;
    unsigned          depth;
@@ -106,6 +115,18 @@ typedef struct {
    tree_t       wrap;
 } elab_instance_t;
 
+typedef struct {
+   tree_t        copy;
+   driver_set_t *drivers;
+   int           nvalues;
+   tree_t       *values;
+} arch_instance_t;
+
+typedef struct {
+   bool                  shareable;
+   A(arch_instance_t)    instances;
+} arch_cache_t;
+
 static void elab_block(tree_t t, const elab_ctx_t *ctx);
 static void elab_stmts(tree_t t, const elab_ctx_t *ctx);
 static void elab_decls(tree_t t, const elab_ctx_t *ctx);
@@ -321,6 +342,120 @@ static elab_instance_t *elab_new_instance(vlog_node_t mod, vlog_node_t inst,
    return ei;
 }
 
+static void elab_shareable_cb(tree_t t, void *__ctx)
+{
+   bool *shareable = __ctx;
+
+   switch (tree_kind(t)) {
+   case T_FUNC_BODY:
+   case T_FUNC_DECL:
+   case T_FUNC_INST:
+   case T_PROC_BODY:
+   case T_PROC_DECL:
+   case T_PROC_INST:
+   case T_TYPE_DECL:
+   case T_SUBTYPE_DECL:
+   case T_PROT_DECL:
+   case T_PROT_BODY:
+   case T_PACKAGE:
+   case T_PACK_BODY:
+   case T_PACK_INST:
+      // Copies of these are renamed with the instance path
+      *shareable = false;
+      break;
+   default:
+      break;
+   }
+}
+
+static arch_cache_t *elab_cached_arch(tree_t arch, tree_t config,
+                                      const elab_ctx_t *ctx)
+{
+   tree_t key = config ?: arch;
+
+   arch_cache_t *ac = hash_get(ctx->archcache, key);
+   if (ac != NULL)
+      return ac;
+
+   ac = xcalloc(sizeof(arch_cache_t));
+   ac->shareable = true;
+
+   tree_t entity = tree_primary(arch);
+
+   const int ngenerics = tree_generics(entity);
+   for (int i = 0; i < ngenerics; i++) {
+      if (tree_class(tree_generic(entity, i)) != C_CONSTANT)
+         ac->shareable = false;
+   }
+
+   if (ac->shareable) {
+      tree_visit(entity, elab_shareable_cb, &(ac->shareable));
+      tree_visit(arch, elab_shareable_cb, &(ac->shareable));
+   }
+
+   hash_put(ctx->archcache, key, ac);
+   return ac;
+}
+
+static bool elab_can_share(arch_cache_t *ac, tree_t bind,
+                           const elab_ctx_t *ctx)
+{
+   if (!ac->shareable || ctx->cover != NULL || generic_override != NULL)
+      return false;
+
+   const int ngenmaps = tree_genmaps(bind);
+   for (int i = 0; i < ngenmaps; i++) {
+      if (!is_literal(tree_value(tree_genmap(bind, i))))
+         return false;
+   }
+
+   return true;
+}
+
+static const arch_instance_t *elab_shared_instance(arch_cache_t *ac,
+                                                   tree_t bind)
+{
+   // Instances of the same architecture with the same literal generic
+   // values produce identical copies after folding so can share one
+
+   const int ngenmaps = tree_genmaps(bind);
+   for (int i = 0; i < ac->instances.count; i++) {
+      const arch_instance_t *ai = &(ac->instances.items[i]);
+      if (ai->nvalues != ngenmaps)
+         continue;
+
+      int pos = 0;
+      for (; pos < ngenmaps; pos++) {
+         tree_t value = tree_value(tree_genmap(bind, pos));
+         if (!same_tree(value, ai->values[pos]))
+            break;
+      }
+
+      if (pos == ngenmaps)
+         return ai;
+   }
+
+   return NULL;
+}
+
+static void elab_share_instance(arch_cache_t *ac, tree_t bind, tree_t copy,
+                                driver_set_t *drivers)
+{
+   const int ngenmaps = tree_genmaps(bind);
+
+   arch_instance_t ai = {
+      .copy    = copy,
+      .drivers = drivers,
+      .nvalues = ngenmaps,
+      .values  = xmalloc_array(ngenmaps, sizeof(tree_t)),
+   };
+
+   for (int i = 0; i < ngenmaps; i++)
+      ai.values[i] = tree_value(tree_genmap(bind, i));
+
+   APUSH(ac->instances, ai);
+}
+
 static bool elab_synth_binding_cb(lib_t lib, void *__ctx)
 {
    synth_binding_params_t *params = __ctx;
@@ -1231,21 +1366,23 @@ static void elab_context(tree_t t)
 
 static void elab_inherit_context(elab_ctx_t *ctx, const elab_ctx_t *parent)
 {
-   ctx->parent   = parent;
-   ctx->jit      = parent->jit;
-   ctx->registry = parent->registry;
-   ctx->mir      = parent->mir;
-   ctx->root     = parent->root;
-   ctx->dotted   = ctx->dotted ?: parent->dotted;
-   ctx->library  = ctx->library ?: parent->library;
-   ctx->out      = ctx->out ?: parent->out;
-   ctx->cover    = parent->cover;
-   ctx->sdf      = parent->sdf;
-   ctx->inst     = ctx->inst ?: parent->inst;
-   ctx->modcache = parent->modcache;
-   ctx->depth    = parent->depth + 1;
-   ctx->model    = parent->model;
-   ctx->errors   = error_count();
+   ctx->parent    = parent;
+   ctx->jit       = parent->jit;
+   ctx->registry  = parent->registry;
+   ctx->mir       = parent->mir;
+   ctx->root      = parent->root;
+   ctx->dotted    = ctx->dotted ?: parent->dotted;
+   ctx->library   = ctx->library ?: parent->library;
+   ctx->out       = ctx->out ?: parent->out;
+   ctx->cover     = parent->cover;
+   ctx->sdf       = parent->sdf;
+   ctx->inst      = ctx->inst ?: parent->inst;
+   ctx->modcache  = parent->modcache;
+   ctx->archcache = parent->archcache;
+   ctx->deferred  = parent->deferred;
+   ctx->depth     = parent->depth + 1;
+   ctx->model     = parent->model;
+   ctx->errors    = error_count();
 }
 
 static bool elab_new_errors(const elab_ctx_t *ctx)
@@ -1283,6 +1420,18 @@ static void elab_lower(tree_t b, elab_ctx_t *ctx)
       diag_remove_hint_fn(elab_hint_fn);
 }
 
+static void elab_defer_process(ident_t name, mir_lower_fn_t fn,
+                               object_t *obj, const elab_ctx_t *ctx)
+{
+   ident_t sym = ident_prefix(ctx->dotted, name, '.');
+   mir_defer(ctx->mir, sym, ctx->dotted, MIR_UNIT_PROCESS, fn, obj);
+
+   if (ctx->deferred != NULL) {
+      elab_deferred_t d = { sym, ctx->dotted };
+      APUSH(*ctx->deferred, d);
+   }
+}
+
 static void elab_verilog_module(tree_t bind, ident_t label,
                                 const elab_instance_t *ei,
                                 const elab_ctx_t *ctx)
@@ -1404,10 +1553,8 @@ static void elab_verilog_ports(vlog_node_t inst, elab_instance_t *ei,
 
       tree_add_stmt(ctx->out, wrap);
 
-      ident_t sym = ident_prefix(ctx->dotted, name, '.');
-
-      mir_defer(ctx->mir, sym, ctx->dotted, MIR_UNIT_PROCESS,
-                vlog_lower_deferred, vlog_to_object(assign));
+      elab_defer_process(name, vlog_lower_deferred, vlog_to_object(assign),
+                         ctx);
    }
 }
 
@@ -1554,7 +1701,6 @@ static void elab_verilog_stmts(vlog_node_t v, const elab_ctx_t *ctx)
       case V_GATE_INST:
          {
             ident_t name = vlog_ident(s);
-            ident_t sym = ident_prefix(ctx->dotted, name, '.');
 
             tree_t w = tree_new(T_VERILOG);
             tree_set_ident(w, name);
@@ -1564,11 +1710,11 @@ static void elab_verilog_stmts(vlog_node_t v, const elab_ctx_t *ctx)
             tree_add_stmt(ctx->out, w);
 
             if (kind == V_UDP_TABLE)
-               mir_defer(ctx->mir, sym, ctx->dotted, MIR_UNIT_PROCESS,
-                         vlog_lower_udp, vlog_to_object(v));
+               elab_defer_process(name, vlog_lower_udp, vlog_to_object(v),
+                                  ctx);
             else
-               mir_defer(ctx->mir, sym, ctx->dotted, MIR_UNIT_PROCESS,
-                         vlog_lower_deferred, vlog_to_object(s));
+               elab_defer_process(name, vlog_lower_deferred,
+                                  vlog_to_object(s), ctx);
          }
          break;
       case V_BLOCK:
@@ -1752,8 +1898,23 @@ static void elab_architecture(tree_t bind, tree_t arch, tree_t config,
 
    elab_subprogram_prefix(arch, &new_ctx);
 
+   arch_cache_t *ac = elab_cached_arch(arch, config, ctx);
+
+   const arch_instance_t *shared = NULL;
+   const bool can_share = elab_can_share(ac, bind, ctx);
+   if (can_share)
+      shared = elab_shared_instance(ac, bind);
+
    tree_t arch_copy;
-   if (config != NULL) {
+   if (shared != NULL) {
+      if (config != NULL) {
+         new_ctx.config = shared->copy;
+         arch_copy = tree_ref(new_ctx.config);
+      }
+      else
+         arch_copy = shared->copy;
+   }
+   else if (config != NULL) {
       assert(tree_ref(config) == arch);
       new_ctx.config = elab_copy(config, &new_ctx);
       arch_copy = tree_ref(new_ctx.config);
@@ -1767,9 +1928,13 @@ static void elab_architecture(tree_t bind, tree_t arch, tree_t config,
    elab_context(entity);
    elab_context(arch_copy);
    elab_generics(entity, bind, &new_ctx);
-   elab_instance_fixup(arch_copy, &new_ctx);
-   simplify_global(arch_copy, new_ctx.generics, ctx->jit, ctx->registry,
-                   ctx->mir);
+
+   if (shared == NULL) {
+      elab_instance_fixup(arch_copy, &new_ctx);
+      simplify_global(arch_copy, new_ctx.generics, ctx->jit, ctx->registry,
+                      ctx->mir);
+   }
+
    elab_ports(entity, bind, &new_ctx);
    elab_decls(entity, &new_ctx);
 
@@ -1777,12 +1942,24 @@ static void elab_architecture(tree_t bind, tree_t arch, tree_t config,
       elab_decls(arch_copy, &new_ctx);
 
    if (error_count() == 0) {
-      new_ctx.drivers = find_drivers(arch_copy);
+      if (shared != NULL)
+         new_ctx.drivers = shared->drivers;
+      else
+         new_ctx.drivers = find_drivers(arch_copy);
+
       elab_lower(b, &new_ctx);
       elab_stmts(entity, &new_ctx);
       elab_stmts(arch_copy, &new_ctx);
    }
 
+   if (shared != NULL)
+      new_ctx.drivers = NULL;   // Owned by the cache
+   else if (can_share && new_ctx.drivers != NULL && error_count() == 0) {
+      elab_share_instance(ac, bind, new_ctx.config ?: arch_copy,
+                          new_ctx.drivers);
+      new_ctx.drivers = NULL;
+   }
+
    elab_pop_scope(&new_ctx);
 }
 
@@ -2460,6 +2637,48 @@ static void elab_verilog_root_cb(void *arg)
    elab_verilog_module(NULL, label, ei, ctx);
 }
 
+static void elab_lower_job(void *context, void *arg)
+{
+   mir_context_t *mc = context;
+   ident_t name = arg;
+
+   (void)mir_get_unit(mc, name);
+}
+
+static void elab_lower_deferred(const elab_ctx_t *ctx)
+{
+   // The tree walk is inherently serial but generating MIR for the
+   // processes in each Verilog instance only reads the syntax tree and
+   // the shape of the enclosing scope so can be done in parallel.
+   // Otherwise each unit is built on demand by cgen_find_dependencies
+   // on the main thread before cgen_async_work can start, or by the
+   // JIT when the process first runs.  VHDL processes are lowered by
+   // lower_instance through vcode which has process-wide state so are
+   // never deferred.
+
+   hset_t *parents = hset_new(64);
+   workq_t *wq = workq_new(ctx->mir);
+
+   for (int i = 0; i < ctx->deferred->count; i++) {
+      const elab_deferred_t *d = &(ctx->deferred->items[i]);
+      if (!hset_contains(parents, d->parent)) {
+         // Scope shapes are built on first use without any locking
+         (void)mir_get_shape(ctx->mir, d->parent);
+         hset_insert(parents, d->parent);
+      }
+
+      workq_do(wq, elab_lower_job, d->name);
+   }
+
+   workq_start(wq);
+   workq_drain(wq);
+
+   progress("lowering %d processes in parallel", ctx->deferred->count);
+
+   workq_free(wq);
+   hset_free(parents);
+}
+
 tree_t elab(object_t *top, jit_t *jit, unit_registry_t *ur, mir_context_t *mc,
             cover_data_t *cover, sdf_file_t *sdf, rt_model_t *m)
 {
@@ -2484,6 +2703,8 @@ tree_t elab(object_t *top, jit_t *jit, unit_registry_t *ur, mir_context_t *mc,
 
    lib_t work = lib_work();
 
+   deferred_list_t deferred = AINIT;
+
    elab_ctx_t ctx = {
       .out       = e,
       .root      = top,
@@ -2494,6 +2715,8 @@ tree_t elab(object_t *top, jit_t *jit, unit_registry_t *ur, mir_context_t *mc,
       .registry  = ur,
       .mir       = mc,
       .modcache  = hash_new(16),
+      .archcache = hash_new(16),
+      .deferred  = opt_get_int(OPT_PARALLEL_ELAB) ? &deferred : NULL,
       .dotted    = lib_name(work),
       .model     = m,
       .scope     = create_scope(m, e, NULL),
@@ -2512,6 +2735,24 @@ tree_t elab(object_t *top, jit_t *jit, unit_registry_t *ur, mir_context_t *mc,
 
    hash_free(ctx.modcache);
 
+   for (hash_iter_t it = HASH_BEGIN;
+        hash_iter(ctx.archcache, &it, &key, &value); ) {
+      arch_cache_t *ac = value;
+      for (int i = 0; i < ac->instances.count; i++) {
+         free_drivers(ac->instances.items[i].drivers);
+         free(ac->instances.items[i].values);
+      }
+      ACLEAR(ac->instances);
+      free(ac);
+   }
+
+   hash_free(ctx.archcache);
+
+   if (error_count() == 0 && deferred.count > 0)
+      elab_lower_deferred(&ctx);
+
+   ACLEAR(deferred);
+
    if (error_count() > 0)
       return NULL;
 
@@ -76,6 +76,8 @@ struct _fbuf {
    uint8_t     *rbuf;
    size_t       rptr;
    size_t       origsz;
+   uint8_t     *rmap;
+   size_t       rmapsz;
    fbuf_t      *next;
    fbuf_t      *prev;
    cs_state_t   checksum;
@@ -305,10 +307,14 @@ static void fbuf_update_header(fbuf_t *f, uint32_t checksum)
    if (len == -1)
       fatal_errno("%s: ftell", f->fname);
 
-   if (fseek(f->file, 8, SEEK_SET) != 0)
+   if (fseek(f->file, 4, SEEK_SET) != 0)
       fatal_errno("%s: fseek", f->fname);
 
-   const uint8_t bytes[12] = {
+   const uint8_t bytes[16] = {
+      f->zip,
+      f->checksum.algo,
+      FBUF_HEADER_SZ,
+      0,
       PACK_BE32(f->wtotal),
       PACK_BE32(checksum),
       PACK_BE32(len),
@@ -403,19 +409,31 @@ static void fbuf_decompress(fbuf_t *f)
 
    f->origsz = len;
    f->checksum.expect = checksum;
-   f->rbuf = xmalloc(f->origsz);
 
    uint8_t *payload = rmap + header_sz + userheader;
    const size_t payloadsz = filesz - header_sz - userheader;
 
+   if (header[4] == FBUF_ZIP_NONE) {
+      // Uncompressed data is read directly from the mapping which is
+      // kept until the file is closed
+      if (payloadsz < f->origsz)
+         fatal("%s has inconsistent uncompressed size %zu vs %zu",
+               f->fname, payloadsz, f->origsz);
+
+      checksum_update(&(f->checksum), payload, f->origsz);
+
+      f->rbuf   = payload;
+      f->rmap   = rmap;
+      f->rmapsz = filesz;
+      return;
+   }
+
+   f->rbuf = xmalloc(f->origsz);
+
    switch (header[4]) {
    case FBUF_ZIP_FASTLZ:
       fbuf_decompress_fastlz(f, payload, payloadsz);
       break;
-   case FBUF_ZIP_NONE:
-      memcpy(f->rbuf, payload, f->origsz);
-      checksum_update(&(f->checksum), f->rbuf, f->origsz);
-      break;
    case FBUF_ZIP_ZSTD:
       fbuf_decompress_zstd(f, payload, payloadsz);
       break;
@@ -468,6 +486,22 @@ fbuf_t *fbuf_open(const char *file, fbuf_mode_t mode, fbuf_cs_t csum)
    return (open_list = f);
 }
 
+void fbuf_set_zip(fbuf_t *f, fbuf_zip_t zip)
+{
+   assert(f->mode == FBUF_OUT);
+   assert(f->wpend == 0 && f->wtotal == 0);
+
+   if (zip != FBUF_ZIP_ZSTD && f->zstd != NULL) {
+      ZSTD_freeCCtx(f->zstd);
+      f->zstd = NULL;
+   }
+   else if (zip == FBUF_ZIP_ZSTD && f->zstd == NULL)
+      fatal_trace("cannot switch to ZSTD compression after opening %s",
+                  f->fname);
+
+   f->zip = zip;
+}
+
 const char *fbuf_file_name(fbuf_t *f)
 {
    return f->fname;
@@ -556,7 +590,9 @@ void fbuf_close(fbuf_t *f, uint32_t *checksum)
    if (checksum != NULL)
       *checksum = cs;
 
-   if (f->rbuf != NULL)
+   if (f->rmap != NULL)
+      unmap_file(f->rmap, f->rmapsz);
+   else if (f->rbuf != NULL)
       free(f->rbuf);
 
    if (f->wbuf != NULL) {
@@ -1468,6 +1468,7 @@ jit_thread_local_t *jit_attach_thread(jit_anchor_t *anchor)
    thread->anchor = anchor;
 
    jit_check_interrupt(thread->jit);
+   safepoint_poll();
 
    return thread;
 }
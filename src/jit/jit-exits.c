@@ -1246,6 +1246,22 @@ void *__nvc_mspace_alloc(uintptr_t size, jit_anchor_t *anchor)
    return ptr;
 }
 
+DLLEXPORT
+void __nvc_safepoint(jit_anchor_t *anchor)
+{
+   jit_thread_local_t *thread = jit_attach_thread(anchor);
+   thread->anchor = NULL;
+}
+
+DLLEXPORT
+void *__nvc_tlab_overflow(uintptr_t size, jit_anchor_t *anchor, tlab_t *tlab)
+{
+   if (tlab_overflow(tlab, size))
+      return tlab_alloc(tlab, size);
+   else
+      return __nvc_mspace_alloc(size, anchor);
+}
+
 DLLEXPORT
 void __nvc_putpriv(jit_handle_t handle, void *data)
 {
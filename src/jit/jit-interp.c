@@ -869,6 +869,14 @@ static void interp_case(jit_interp_t *state, jit_ir_t *ir)
       interp_branch_to(state, ir->arg2);
 }
 
+static void interp_poll(jit_interp_t *state, jit_ir_t *ir)
+{
+   if (unlikely(relaxed_load(&__nvc_safepoint_pending))) {
+      state->anchor->irpos = ir - state->func->irbuf;
+      __nvc_safepoint(state->anchor);
+   }
+}
+
 static void interp_trim(jit_interp_t *state, jit_ir_t *ir)
 {
    assert(state->tlab->alloc >= state->anchor->watermark);
@@ -1078,6 +1086,9 @@ static void interp_loop(jit_interp_t *state)
       case MACRO_TRIM:
          interp_trim(state, ir);
          break;
+      case MACRO_POLL:
+         interp_poll(state, ir);
+         break;
       case MACRO_REEXEC:
          interp_reexec(state, ir);
          return;
@@ -205,7 +205,8 @@ static inline void *__tlab_alloc(tlab_t *t, size_t size, size_t align)
 
    const size_t alignup = ALIGN_UP(size, sizeof(double));
    const size_t base = ALIGN_UP(t->alloc, align);
-   if (likely(base + alignup <= t->limit)) {
+   if (likely(base + alignup <= t->limit)
+       || tlab_overflow(t, base + alignup - t->alloc)) {
       t->alloc = base + alignup;
       return t->data + base;
    }
@@ -708,6 +708,12 @@ static void macro_trim(jit_irgen_t *g)
    irgen_emit_nullary(g, MACRO_TRIM, JIT_CC_NONE, JIT_REG_INVALID);
 }
 
+static void macro_poll(jit_irgen_t *g)
+{
+   irgen_emit_nullary(g, MACRO_POLL, JIT_CC_NONE, JIT_REG_INVALID);
+   g->flags = MIR_NULL_VALUE;
+}
+
 static void macro_reexec(jit_irgen_t *g)
 {
    irgen_emit_nullary(g, MACRO_REEXEC, JIT_CC_NONE, JIT_REG_INVALID);
@@ -2395,15 +2401,19 @@ static void irgen_op_range_length(jit_irgen_t *g, mir_value_t n)
 
 static void irgen_op_cond(jit_irgen_t *g, mir_value_t n)
 {
+   mir_block_t t0 = mir_cast_block(mir_get_arg(g->mu, n, 1));
+   mir_block_t t1 = mir_cast_block(mir_get_arg(g->mu, n, 2));
+
+   // Poll before the comparison as it clobbers the flags
+   if (t0.id <= g->curblock.id || t1.id <= g->curblock.id)
+      macro_poll(g);   // Loop back-edge
+
    mir_value_t arg0 = mir_get_arg(g->mu, n, 0);
    if (!mir_equals(arg0, g->flags)) {
       jit_value_t test = irgen_get_value(g, arg0);
       j_cmp(g, JIT_CC_NE, test, jit_value_from_int64(0));
    }
 
-   mir_block_t t0 = mir_cast_block(mir_get_arg(g->mu, n, 1));
-   mir_block_t t1 = mir_cast_block(mir_get_arg(g->mu, n, 2));
-
    if (t0.id == g->curblock.id + 1)
       j_jump(g, JIT_CC_F, g->blocks[t1.id]);
    else if (t1.id == g->curblock.id + 1)
@@ -2455,6 +2465,10 @@ static void irgen_op_select(jit_irgen_t *g, mir_value_t n)
 static void irgen_op_jump(jit_irgen_t *g, mir_value_t n)
 {
    mir_block_t target = mir_cast_block(mir_get_arg(g->mu, n, 0));
+
+   if (target.id <= g->curblock.id)
+      macro_poll(g);   // Loop back-edge
+
    j_jump(g, JIT_CC_NONE, g->blocks[target.id]);
 }
 
@@ -2462,6 +2476,8 @@ static void irgen_op_fcall(jit_irgen_t *g, mir_value_t n)
 {
    irgen_emit_debuginfo(g, n);   // For stack traces
 
+   macro_poll(g);
+
    mir_type_t rtype = mir_get_type(g->mu, n);
    if (mir_is_null(rtype)) {
       // Must call using procedure calling convention
@@ -2527,6 +2543,8 @@ static void irgen_op_pcall(jit_irgen_t *g, mir_value_t n)
 {
    irgen_emit_debuginfo(g, n);   // For stack traces
 
+   macro_poll(g);
+
    // First argument to procedure is suspended state
    j_send(g, 0, jit_value_from_int64(0));
 
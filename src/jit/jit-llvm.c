@@ -131,8 +131,11 @@ typedef enum {
    LLVM_DO_EXIT,
    LLVM_PUTPRIV,
    LLVM_MSPACE_ALLOC,
+   LLVM_TLAB_OVERFLOW,
    LLVM_GET_OBJECT,
    LLVM_TLAB_ALLOC,
+   LLVM_SAFEPOINT,
+   LLVM_POLL,
    LLVM_SCHED_WAVEFORM,
    LLVM_TEST_EVENT,
    LLVM_LAST_EVENT,
@@ -992,6 +995,26 @@ static LLVMValueRef llvm_get_fn(llvm_obj_t *obj, llvm_fn_t which)
       }
       break;
 
+   case LLVM_TLAB_OVERFLOW:
+      {
+         LLVMTypeRef args[] = {
+            obj->types[LLVM_INTPTR],
+#ifdef LLVM_HAS_OPAQUE_POINTERS
+            obj->types[LLVM_PTR],
+            obj->types[LLVM_PTR],
+#else
+            LLVMPointerType(obj->types[LLVM_ANCHOR], 0),
+            LLVMPointerType(obj->types[LLVM_TLAB], 0),
+#endif
+         };
+         obj->fntypes[which] = LLVMFunctionType(obj->types[LLVM_PTR], args,
+                                                ARRAY_LEN(args), false);
+
+         fn = llvm_add_fn(obj, "__nvc_tlab_overflow", obj->fntypes[which]);
+         llvm_add_func_attr(obj, fn, FUNC_ATTR_NOUNWIND, -1);
+      }
+      break;
+
    case LLVM_GET_OBJECT:
       {
          LLVMTypeRef args[] = {
@@ -1029,6 +1052,39 @@ static LLVMValueRef llvm_get_fn(llvm_obj_t *obj, llvm_fn_t which)
       }
       break;
 
+   case LLVM_SAFEPOINT:
+      {
+         LLVMTypeRef args[] = {
+#ifdef LLVM_HAS_OPAQUE_POINTERS
+            obj->types[LLVM_PTR],
+#else
+            LLVMPointerType(obj->types[LLVM_ANCHOR], 0),
+#endif
+         };
+         obj->fntypes[which] = LLVMFunctionType(obj->types[LLVM_VOID], args,
+                                                ARRAY_LEN(args), false);
+         fn = llvm_add_fn(obj, "__nvc_safepoint", obj->fntypes[which]);
+         llvm_add_func_attr(obj, fn, FUNC_ATTR_NOUNWIND, -1);
+      }
+      break;
+
+   case LLVM_POLL:
+      {
+         LLVMTypeRef args[] = {
+#ifdef LLVM_HAS_OPAQUE_POINTERS
+            obj->types[LLVM_PTR],
+#else
+            LLVMPointerType(obj->types[LLVM_ANCHOR], 0),
+#endif
+            obj->types[LLVM_INT32],
+         };
+         obj->fntypes[which] = LLVMFunctionType(obj->types[LLVM_VOID], args,
+                                                ARRAY_LEN(args), false);
+         fn = llvm_add_fn(obj, "poll", obj->fntypes[which]);
+         llvm_add_func_attr(obj, fn, FUNC_ATTR_NOUNWIND, -1);
+      }
+      break;
+
    default:
       fatal_trace("cannot generate prototype for function %d", which);
    }
@@ -2412,6 +2468,17 @@ static void cgen_macro_trim(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
    LLVMBuildStore(obj->builder, watermark, alloc_ptr);
 }
 
+static void cgen_macro_poll(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
+{
+   const unsigned irpos = ir - cgb->func->source->irbuf;
+
+   LLVMValueRef args[] = {
+      PTR(cgb->func->anchor),
+      llvm_int32(obj, irpos),
+   };
+   llvm_call_fn(obj, LLVM_POLL, args, ARRAY_LEN(args));
+}
+
 static void cgen_macro_reexec(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
 {
    LLVMValueRef fptr = LLVMGetParam(cgb->func->llvmfn, 0);
@@ -2634,6 +2701,9 @@ static void cgen_ir(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
    case MACRO_SADD:
       cgen_macro_sadd(obj, cgb, ir);
       break;
+   case MACRO_POLL:
+      cgen_macro_poll(obj, cgb, ir);
+      break;
    default:
       cgen_abort(cgb, ir, "cannot generate LLVM for %s", jit_op_name(ir->op));
    }
@@ -3303,13 +3373,63 @@ static void cgen_tlab_alloc_body(llvm_obj_t *obj)
 
    LLVMPositionBuilderAtEnd(obj->builder, slow_bb);
 
-   LLVMValueRef args[] = { bytes, anchor };
-   LLVMValueRef slow_ptr = llvm_call_fn(obj, LLVM_MSPACE_ALLOC, args,
+   LLVMValueRef args[] = { bytes, anchor, tlab };
+   LLVMValueRef slow_ptr = llvm_call_fn(obj, LLVM_TLAB_OVERFLOW, args,
                                         ARRAY_LEN(args));
 
    LLVMBuildRet(obj->builder, slow_ptr);
 }
 
+static void cgen_poll_body(llvm_obj_t *obj)
+{
+   LLVMValueRef fn = obj->fns[LLVM_POLL];
+   LLVMSetLinkage(fn, LLVMPrivateLinkage);
+
+#ifdef PRESERVE_FRAME_POINTER
+   llvm_add_func_attr(obj, fn, FUNC_ATTR_PRESERVE_FP, 0);
+#endif
+
+   LLVMBasicBlockRef entry = llvm_append_block(obj, fn, "");
+   LLVMBasicBlockRef slow_bb = llvm_append_block(obj, fn, "");
+   LLVMBasicBlockRef exit_bb = llvm_append_block(obj, fn, "");
+
+   LLVMPositionBuilderAtEnd(obj->builder, entry);
+
+   LLVMValueRef anchor = LLVMGetParam(fn, 0);
+   LLVMSetValueName(anchor, "anchor");
+
+   LLVMValueRef irpos = LLVMGetParam(fn, 1);
+   LLVMSetValueName(irpos, "irpos");
+
+   // Defined in the runtime and set while stop_world is in progress
+   LLVMValueRef pending_ptr = LLVMAddGlobal(obj->module, obj->types[LLVM_INT32],
+                                            "__nvc_safepoint_pending");
+   LLVMSetLinkage(pending_ptr, LLVMExternalLinkage);
+
+   LLVMValueRef pending = LLVMBuildLoad2(obj->builder, obj->types[LLVM_INT32],
+                                         pending_ptr, "");
+   LLVMSetAlignment(pending, sizeof(int32_t));
+   LLVMSetOrdering(pending, LLVMAtomicOrderingMonotonic);
+
+   LLVMValueRef stop = LLVMBuildICmp(obj->builder, LLVMIntNE, pending,
+                                     llvm_int32(obj, 0), "");
+   LLVMBuildCondBr(obj->builder, stop, slow_bb, exit_bb);
+
+   LLVMPositionBuilderAtEnd(obj->builder, slow_bb);
+
+   LLVMValueRef irpos_ptr =
+      LLVMBuildStructGEP2(obj->builder, obj->types[LLVM_ANCHOR], anchor, 2, "");
+   LLVMBuildStore(obj->builder, irpos, irpos_ptr);
+
+   LLVMValueRef args[] = { anchor };
+   llvm_call_fn(obj, LLVM_SAFEPOINT, args, ARRAY_LEN(args));
+
+   LLVMBuildBr(obj->builder, exit_bb);
+
+   LLVMPositionBuilderAtEnd(obj->builder, exit_bb);
+   LLVMBuildRetVoid(obj->builder);
+}
+
 static void cgen_exp_overflow_body(llvm_obj_t *obj, llvm_fn_t which,
                                    jit_size_t sz, llvm_fn_t mulbase)
 {
@@ -3732,6 +3852,9 @@ void llvm_obj_finalise(llvm_obj_t *obj, llvm_opt_level_t olevel)
    if (obj->fns[LLVM_TLAB_ALLOC] != NULL)
       cgen_tlab_alloc_body(obj);
 
+   if (obj->fns[LLVM_POLL] != NULL)
+      cgen_poll_body(obj);
+
    for (jit_size_t sz = JIT_SZ_8; sz <= JIT_SZ_64; sz++) {
       if (obj->fns[LLVM_EXP_OVERFLOW_S8 + sz] != NULL)
          cgen_exp_overflow_body(obj, LLVM_EXP_OVERFLOW_S8 + sz, sz,
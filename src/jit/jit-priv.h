@@ -91,6 +91,7 @@ typedef enum {
    MACRO_UNPACK,
    MACRO_VEC2OP,
    MACRO_VEC4OP,
+   MACRO_POLL,
 } jit_op_t;
 
 typedef enum {
@@ -484,6 +485,9 @@ DLLEXPORT void __nvc_pack(const uint8_t *src, int32_t size, jit_scalar_t *args);
 DLLEXPORT void __nvc_unpack(jit_scalar_t aval, jit_scalar_t bval,
                             jit_scalar_t *args);
 DLLEXPORT void *__nvc_mspace_alloc(uintptr_t size, jit_anchor_t *anchor);
+DLLEXPORT void __nvc_safepoint(jit_anchor_t *anchor);
+DLLEXPORT void *__nvc_tlab_overflow(uintptr_t size, jit_anchor_t *anchor,
+                                    tlab_t *tlab);
 DLLEXPORT void _debug_out(intptr_t val, int32_t reg);
 
 #endif  // _JIT_PRIV_H
@@ -38,6 +38,7 @@ typedef enum {
    TLAB_STUB,
    FEXP_STUB,
    ROUND_STUB,
+   POLL_STUB,
 
    NUM_STUBS
 } jit_x86_stub_t;
@@ -2055,6 +2056,16 @@ static void jit_x86_macro_fexp(code_blob_t *blob, jit_x86_state_t *state,
    jit_x86_put(blob, ir->result, __XMM0, slots);
 }
 
+static void jit_x86_macro_poll(code_blob_t *blob, jit_x86_state_t *state)
+{
+   // Only call the stub when a safepoint has been requested
+   MOV(__EAX, PTR(&__nvc_safepoint_pending), __QWORD);
+   MOV(__EAX, ADDR(__EAX, 0), __DWORD);
+   TEST(__EAX, __EAX, __DWORD);
+   JZ(IMM(5));
+   CALL(PTR(state->stubs[POLL_STUB]));
+}
+
 static void jit_x86_macro_trim(code_blob_t *blob, jit_ir_t *ir)
 {
    const ptrdiff_t off = offsetof(jit_anchor_t, watermark);
@@ -2219,6 +2230,9 @@ static void jit_x86_op(code_blob_t *blob, jit_x86_state_t *state, jit_ir_t *ir,
    case MACRO_TRIM:
       jit_x86_macro_trim(blob, ir);
       break;
+   case MACRO_POLL:
+      jit_x86_macro_poll(blob, state);
+      break;
    default:
       jit_dump_with_mark(blob->func, ir - blob->func->irbuf);
       fatal_trace("unhandled opcode %s in x86 backend", jit_op_name(ir->op));
@@ -2443,8 +2457,9 @@ static void jit_x86_gen_tlab_stub(jit_x86_state_t *state)
 
    MOV(CARG0_REG, __EAX, __DWORD);
    LEA(CARG1_REG, ADDR(__EBP, ANCHOR_OFFSET));
+   MOV(CARG2_REG, TLAB_REG, __QWORD);
 
-   MOV(__EAX, PTR(__nvc_mspace_alloc), __QWORD);
+   MOV(__EAX, PTR(__nvc_tlab_overflow), __QWORD);
    CALL(__EAX);
 
    jit_x86_pop_call_clobbered(blob);
@@ -2455,6 +2470,30 @@ static void jit_x86_gen_tlab_stub(jit_x86_state_t *state)
    code_blob_finalise(blob, &(state->stubs[TLAB_STUB]));
 }
 
+static void jit_x86_gen_poll_stub(jit_x86_state_t *state)
+{
+   ident_t name = ident_new("poll stub");
+   code_blob_t *blob = code_blob_new(state->code, name, 0);
+
+   // Only reached when jit_x86_macro_poll sees a pending safepoint
+
+   SUB(__ESP, IMM(8), __QWORD);   // Ensure stack aligned
+
+   jit_x86_push_call_clobbered(blob);
+
+   LEA(CARG0_REG, ADDR(__EBP, ANCHOR_OFFSET));
+
+   MOV(__EAX, PTR(__nvc_safepoint), __QWORD);
+   CALL(__EAX);
+
+   jit_x86_pop_call_clobbered(blob);
+
+   ADD(__ESP, IMM(8), __QWORD);
+   RET();
+
+   code_blob_finalise(blob, &(state->stubs[POLL_STUB]));
+}
+
 #if DEBUG
 static void jit_x86_gen_debug_stub(jit_x86_state_t *state)
 {
@@ -2531,6 +2570,7 @@ static void *jit_x86_init(jit_t *jit)
    jit_x86_gen_alloc_stub(state);
    jit_x86_gen_tlab_stub(state);
    jit_x86_gen_fexp_stub(state);
+   jit_x86_gen_poll_stub(state);
    DEBUG_ONLY(jit_x86_gen_debug_stub(state));
 
    if (!__builtin_cpu_supports("sse4.1"))
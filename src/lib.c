@@ -16,6 +16,7 @@
 //
 
 #include "util.h"
+#include "array.h"
 #include "common.h"
 #include "diag.h"
 #include "fbuf.h"
@@ -41,13 +42,16 @@
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#include <utime.h>
 
 typedef struct _search_path search_path_t;
 typedef struct _lib_index   lib_index_t;
 typedef struct _lib_list    lib_list_t;
 typedef struct _lib_unit    lib_unit_t;
+typedef struct _lib_source  lib_source_t;
 
-#define INDEX_FILE_MAGIC 0x55225511
+#define INDEX_FILE_MAGIC    0x55225512
+#define INDEX_FILE_MAGIC_V1 0x55225511   // No checksums or sources
 
 struct _lib_unit {
    object_t     *object;
@@ -55,6 +59,7 @@ struct _lib_unit {
    uint64_t      mtime;
    unit_meta_t   meta;
    lib_unit_t   *next;
+   lib_source_t *source;
    tree_kind_t   kind;
    bool          dirty;
    bool          error;
@@ -63,15 +68,37 @@ struct _lib_unit {
 struct _lib_index {
    ident_t      name;
    tree_kind_t  kind;
+   uint32_t     checksum;
    lib_index_t *next;
 };
 
+typedef struct {
+   ident_t  name;
+   uint32_t checksum;
+} lib_dep_t;
+
+typedef A(ident_t) ident_list_t;
+typedef A(lib_dep_t) dep_list_t;
+
+// Source file previously analysed into the library along with the
+// design units it defined and the checksums of their dependencies
+struct _lib_source {
+   char         *path;
+   uint64_t      hash;
+   ident_list_t  units;
+   dep_list_t    deps;
+   lib_source_t *next;
+};
+
 struct _lib {
    char         *path;
    ident_t       name;
    ghash_t      *lookup;
    lib_unit_t   *units;
    lib_index_t  *index;
+   lib_source_t *sources;
+   lib_source_t *pending;
+   lib_source_t *current;
    uint64_t      index_mtime;
    off_t         index_size;
    int           lock_fd;
@@ -143,6 +170,67 @@ static void lib_add_to_index(lib_t lib, ident_t name, tree_kind_t kind)
    }
 }
 
+static void lib_free_source(lib_source_t *s)
+{
+   ACLEAR(s->units);
+   ACLEAR(s->deps);
+   free(s->path);
+   free(s);
+}
+
+static void lib_insert_source(lib_t lib, lib_source_t *s)
+{
+   // Keep the list sorted by path to make library builds reproducible
+   lib_source_t **it;
+   for (it = &(lib->sources);
+        *it != NULL && strcmp((*it)->path, s->path) < 0;
+        it = &((*it)->next))
+      ;
+
+   if (*it != NULL && strcmp((*it)->path, s->path) == 0) {
+      lib_source_t *old = *it;
+      *it = old->next;
+      lib_free_source(old);
+   }
+
+   s->next = *it;
+   *it = s;
+}
+
+static void lib_read_sources(lib_t lib, fbuf_t *f, ident_rd_ctx_t ictx)
+{
+   while (lib->sources != NULL) {
+      lib_source_t *tmp = lib->sources->next;
+      lib_free_source(lib->sources);
+      lib->sources = tmp;
+   }
+
+   const int nsources = read_u32(f);
+   for (int i = 0; i < nsources; i++) {
+      lib_source_t *s = xcalloc(sizeof(lib_source_t));
+
+      const size_t len = fbuf_get_uint(f);
+      s->path = xmalloc(len + 1);
+      read_raw(s->path, len, f);
+      s->path[len] = '\0';
+
+      s->hash = read_u64(f);
+
+      const int nunits = read_u32(f);
+      for (int j = 0; j < nunits; j++)
+         APUSH(s->units, ident_read(ictx));
+
+      const int ndeps = read_u32(f);
+      for (int j = 0; j < ndeps; j++) {
+         lib_dep_t dep = { .name = ident_read(ictx) };
+         dep.checksum = read_u32(f);
+         APUSH(s->deps, dep);
+      }
+
+      lib_insert_source(lib, s);
+   }
+}
+
 static void lib_read_index(lib_t lib)
 {
    fbuf_t *f = lib_fbuf_open(lib, "_index", FBUF_IN, FBUF_CS_NONE);
@@ -152,9 +240,10 @@ static void lib_read_index(lib_t lib)
          fatal_errno("%s", fbuf_file_name(f));
 
       const uint32_t magic = read_u32(f);
-      if (magic != INDEX_FILE_MAGIC) {
+      if (magic != INDEX_FILE_MAGIC && magic != INDEX_FILE_MAGIC_V1) {
          warnf("ignoring library index %s from an old version of " PACKAGE,
                fbuf_file_name(f));
+         fbuf_close(f, NULL);
          return;
       }
 
@@ -170,24 +259,32 @@ static void lib_read_index(lib_t lib)
          tree_kind_t kind = read_u16(f);
          assert(kind <= T_LAST_TREE_KIND);
 
+         const uint32_t checksum =
+            magic == INDEX_FILE_MAGIC_V1 ? 0 : read_u32(f);
+
          while (*insert && ident_compare((*insert)->name, name) < 0)
             insert = &((*insert)->next);
 
          if (*insert && (*insert)->name == name) {
             (*insert)->kind = kind;
+            (*insert)->checksum = checksum;
             insert = &((*insert)->next);
          }
          else {
             lib_index_t *new = xmalloc(sizeof(lib_index_t));
-            new->name = name;
-            new->kind = kind;
-            new->next = *insert;
+            new->name     = name;
+            new->kind     = kind;
+            new->checksum = checksum;
+            new->next     = *insert;
 
             *insert = new;
             insert = &(new->next);
          }
       }
 
+      if (magic != INDEX_FILE_MAGIC_V1)
+         lib_read_sources(lib, f, ictx);
+
       ident_read_end(ictx);
       fbuf_close(f, NULL);
    }
@@ -367,6 +464,7 @@ static lib_unit_t *lib_put_aux(lib_t lib, object_t *object, bool dirty,
    where->error  = error;
    where->mtime  = mtime;
    where->kind   = kind;
+   where->source = dirty ? lib->current : NULL;
 
    if (meta != NULL)
       where->meta = *meta;
@@ -736,6 +834,16 @@ void lib_free(lib_t lib)
       lib->index = tmp;
    }
 
+   for (lib_source_t *s = lib->sources, *tmp; s; s = tmp) {
+      tmp = s->next;
+      lib_free_source(s);
+   }
+
+   for (lib_source_t *s = lib->pending, *tmp; s; s = tmp) {
+      tmp = s->next;
+      lib_free_source(s);
+   }
+
    for (lib_unit_t *lu = lib->units, *tmp; lu; lu = tmp) {
       tmp = lu->next;
       free(lu);
@@ -1069,6 +1177,11 @@ static void lib_save_unit(lib_t lib, lib_unit_t *unit)
    if (f == NULL)
       fatal("failed to create %s in library %s", tb_get(tb), istr(lib->name));
 
+   // Design units are stored uncompressed by default so they can be
+   // mapped into memory and decoded in place when loaded
+   if (!opt_get_int(OPT_LIB_COMPRESS))
+      fbuf_set_zip(f, FBUF_ZIP_NONE);
+
    write_u8('T', f);
 
    ident_wr_ctx_t ident_ctx = ident_write_begin(f);
@@ -1096,10 +1209,98 @@ static void lib_save_unit(lib_t lib, lib_unit_t *unit)
 
    arena_set_checksum(arena, checksum);
 
+   lib_index_t *it = lib_find_in_index(lib, unit->name);
+   assert(it != NULL);
+   it->checksum = checksum;
+
    assert(unit->dirty);
    unit->dirty = false;
 }
 
+static void lib_source_dep_cb(ident_t name, uint32_t checksum, void *ctx)
+{
+   lib_source_t *s = ctx;
+
+   for (int i = 0; i < s->deps.count; i++) {
+      if (s->deps.items[i].name == name)
+         return;
+   }
+
+   lib_dep_t dep = { name, checksum };
+   APUSH(s->deps, dep);
+}
+
+static void lib_commit_sources(lib_t lib)
+{
+   for (lib_source_t *s = lib->pending, *next; s; s = next) {
+      next = s->next;
+
+      for (lib_unit_t *lu = lib->units; lu; lu = lu->next) {
+         if (lu->source != s)
+            continue;
+
+         APUSH(s->units, lu->name);
+         arena_walk_dep_checksums(object_arena(lu->object),
+                                  lib_source_dep_cb, s);
+      }
+
+      // Forget any other source file that previously defined one of
+      // these units
+      for (lib_source_t **it = &(lib->sources); *it; ) {
+         bool overlap = false;
+         for (int i = 0; !overlap && i < (*it)->units.count; i++) {
+            for (int j = 0; !overlap && j < s->units.count; j++)
+               overlap = ((*it)->units.items[i] == s->units.items[j]);
+         }
+
+         if (overlap) {
+            lib_source_t *tmp = *it;
+            *it = tmp->next;
+            lib_free_source(tmp);
+         }
+         else
+            it = &((*it)->next);
+      }
+
+      if (s->units.count > 0)
+         lib_insert_source(lib, s);
+      else
+         lib_free_source(s);
+   }
+
+   lib->pending = NULL;
+
+   for (lib_unit_t *lu = lib->units; lu; lu = lu->next)
+      lu->source = NULL;
+}
+
+static void lib_write_sources(lib_t lib, fbuf_t *f, ident_wr_ctx_t ictx)
+{
+   int nsources = 0;
+   for (lib_source_t *s = lib->sources; s; s = s->next)
+      nsources++;
+
+   write_u32(nsources, f);
+
+   for (lib_source_t *s = lib->sources; s; s = s->next) {
+      const size_t len = strlen(s->path);
+      fbuf_put_uint(f, len);
+      write_raw(s->path, len, f);
+
+      write_u64(s->hash, f);
+
+      write_u32(s->units.count, f);
+      for (int i = 0; i < s->units.count; i++)
+         ident_write(s->units.items[i], ictx);
+
+      write_u32(s->deps.count, f);
+      for (int i = 0; i < s->deps.count; i++) {
+         ident_write(s->deps.items[i].name, ictx);
+         write_u32(s->deps.items[i].checksum, f);
+      }
+   }
+}
+
 void lib_save(lib_t lib)
 {
    assert(lib != NULL);
@@ -1110,6 +1311,16 @@ void lib_save(lib_t lib)
 
    freeze_global_arena();
 
+   LOCAL_TEXT_BUF index_path = lib_file_path(lib, "_index");
+   file_info_t info;
+   if (get_file_info(tb_get(index_path), &info)) {
+      if (info.mtime != lib->index_mtime || info.size != lib->index_size) {
+         // Library was updated concurrently: re-read the index while we
+         // have the lock
+         lib_read_index(lib);
+      }
+   }
+
    for (lib_unit_t *lu = lib->units; lu; lu = lu->next) {
       if (lu->dirty) {
          if (lu->error)
@@ -1123,15 +1334,7 @@ void lib_save(lib_t lib)
       }
    }
 
-   LOCAL_TEXT_BUF index_path = lib_file_path(lib, "_index");
-   file_info_t info;
-   if (get_file_info(tb_get(index_path), &info)) {
-      if (info.mtime != lib->index_mtime || info.size != lib->index_size) {
-         // Library was updated concurrently: re-read the index while we
-         // have the lock
-         lib_read_index(lib);
-      }
-   }
+   lib_commit_sources(lib);
 
    int index_sz = lib_index_size(lib);
 
@@ -1147,8 +1350,11 @@ void lib_save(lib_t lib)
    for (lib_index_t *it = lib->index; it != NULL; it = it->next) {
       ident_write(it->name, ictx);
       write_u16(it->kind, f);
+      write_u32(it->checksum, f);
    }
 
+   lib_write_sources(lib, f, ictx);
+
    ident_write_end(ictx);
    fbuf_close(f, NULL);
 
@@ -1161,6 +1367,83 @@ void lib_save(lib_t lib)
    file_unlock(lib->lock_fd);
 }
 
+void lib_begin_source(lib_t lib, const char *file, uint64_t hash)
+{
+   assert(lib != NULL);
+
+   if (file == NULL) {
+      lib->current = NULL;
+      return;
+   }
+
+   lib_source_t *s = xcalloc(sizeof(lib_source_t));
+   s->path = xstrdup(file);
+   s->hash = hash;
+   s->next = lib->pending;
+
+   lib->pending = lib->current = s;
+}
+
+static bool lib_dep_current(const lib_dep_t *dep)
+{
+   lib_t lib = lib_find(ident_until(dep->name, '.'));
+   if (lib == NULL)
+      return false;
+
+   lib_unit_t *lu = ghash_get(lib->lookup, dep->name);
+   if (lu != NULL && lu->dirty)
+      return false;   // Reanalysed but not yet saved
+
+   lib_index_t *it = lib_find_in_index(lib, dep->name);
+   return it != NULL && it->checksum == dep->checksum;
+}
+
+bool lib_source_unchanged(lib_t lib, const char *file, uint64_t hash)
+{
+   assert(lib != NULL);
+
+   if (lib->path == NULL || lib->readonly)
+      return false;
+
+   lib_source_t *s;
+   for (s = lib->sources; s != NULL && strcmp(s->path, file); s = s->next)
+      ;
+
+   if (s == NULL || s->hash != hash || s->units.count == 0)
+      return false;
+
+   for (int i = 0; i < s->units.count; i++) {
+      if (lib_find_in_index(lib, s->units.items[i]) == NULL)
+         return false;
+
+      lib_unit_t *lu = ghash_get(lib->lookup, s->units.items[i]);
+      if (lu != NULL && lu->dirty)
+         return false;   // Redefined by another file
+   }
+
+   // The checksum of a dependency only changes when its serialised
+   // form does, so editing an architecture or package body does not
+   // invalidate units that depend on the entity or package
+   for (int i = 0; i < s->deps.count; i++) {
+      if (!lib_dep_current(&(s->deps.items[i])))
+         return false;
+   }
+
+   // Update the modification time of the existing units so they are
+   // not reported as older than their source file
+   LOCAL_TEXT_BUF tb = tb_new();
+   for (int i = 0; i < s->units.count; i++) {
+      tb_rewind(tb);
+      lib_encode_file_name(s->units.items[i], tb);
+
+      LOCAL_TEXT_BUF path = lib_file_path(lib, tb_get(tb));
+      if (utime(tb_get(path), NULL) != 0)
+         return false;
+   }
+
+   return true;
+}
+
 void lib_walk_index(lib_t lib, lib_index_fn_t fn, void *context)
 {
    assert(lib != NULL);
@@ -194,6 +194,33 @@ bool mask_test_and_set(bit_mask_t *m, size_t bit)
    return false;
 }
 
+bool mask_atomic_test_and_set_range(bit_mask_t *m, size_t start,
+                                    size_t count)
+{
+   // Safe to call concurrently with other atomic updates to the mask
+   // as long as no two threads try to set overlapping ranges
+   assert(count > 0);
+   assert(start + count <= m->size);
+
+   uint64_t *words = m->size > 64 ? m->ptr : &(m->bits);
+
+   const uint64_t first = UINT64_C(1) << (start % 64);
+   if (__atomic_fetch_or(&(words[start / 64]), first, __ATOMIC_RELAXED) & first)
+      return true;
+
+   for (size_t bit = start + 1, left = count - 1; left > 0;) {
+      const size_t low = bit % 64;
+      const size_t high = MIN(low + left - 1, 63);
+      __atomic_fetch_or(&(words[bit / 64]), mask_for_range(low, high),
+                        __ATOMIC_RELAXED);
+
+      bit += high - low + 1;
+      left -= high - low + 1;
+   }
+
+   return false;
+}
+
 ssize_t mask_scan_backwards(bit_mask_t *m, size_t bit)
 {
    if (m->size <= 64) {
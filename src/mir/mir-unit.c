@@ -299,7 +299,17 @@ static mir_unit_t *mir_lazy_build(mir_context_t *mc, deferred_unit_t *du)
       mir_dump(mu);
    }
 
-   chash_put(mc->map, du->name, tag_pointer(mu, UNIT_GENERATED));
+   // Another thread may have built the same unit concurrently in which
+   // case discard this copy and use theirs
+   void *cmp = tag_pointer(du, UNIT_DEFERRED);
+   void *prev = chash_cas(mc->map, du->name, cmp,
+                          tag_pointer(mu, UNIT_GENERATED));
+   if (prev != cmp) {
+      mir_unit_free_memory(mu);
+      assert(pointer_tag(prev) == UNIT_GENERATED);
+      return untag_pointer(prev, mir_unit_t);
+   }
+
    return mu;
 }
 
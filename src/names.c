@@ -73,6 +73,8 @@ typedef struct {
    unsigned     overflowsz;
    decl_t       decls[INLINE_DECLS];
    decl_t      *overflow;
+   tree_list_t  overloads;
+   bool         memoised;
 } symbol_t;
 
 #define SYMBOLS_PER_CHUNK 32
@@ -386,6 +388,8 @@ static void free_overflow(sym_chunk_t *chunk)
    for (int i = 0; i < chunk->count; i++) {
       if (chunk->symbols[i].overflow)
          free(chunk->symbols[i].overflow);
+
+      ACLEAR(chunk->symbols[i].overloads);
    }
 }
 
@@ -689,15 +693,26 @@ static inline const decl_t *get_decl(const symbol_t *sym, unsigned nth)
       ? &(sym->decls[nth]) : &(sym->overflow[nth - INLINE_DECLS]);
 }
 
+static inline void forget_overloads(symbol_t *sym)
+{
+   // Any change to the declarations visible through this symbol
+   // invalidates the memoised overload set
+   sym->memoised = false;
+   ATRIM(sym->overloads, 0);
+}
+
 static inline decl_t *get_decl_mutable(symbol_t *sym, unsigned nth)
 {
    assert(nth < sym->ndecls);
+   forget_overloads(sym);
    return (nth < INLINE_DECLS)
       ? &(sym->decls[nth]) : &(sym->overflow[nth - INLINE_DECLS]);
 }
 
 static decl_t *add_decl(symbol_t *sym)
 {
+   forget_overloads(sym);
+
    if (sym->ndecls < INLINE_DECLS)
       return &(sym->decls[sym->ndecls++]);
    else if (sym->ndecls - INLINE_DECLS == sym->overflowsz) {
@@ -2693,6 +2708,43 @@ static void overload_add_candidate(overload_t *o, tree_t d)
    APUSH(o->candidates, d);
 }
 
+static void overload_add_visible(overload_t *o)
+{
+   // The set of visible subprograms for a name only changes when a
+   // declaration is added to or hidden from the symbol so it can be
+   // reused for every call until then
+   symbol_t *sym = (symbol_t *)o->symbol;
+   assert(o->candidates.count == 0);
+
+   if (sym->memoised) {
+      ARESERVE(o->candidates, sym->overloads.count);
+      for (unsigned i = 0; i < sym->overloads.count; i++)
+         APUSH(o->candidates, sym->overloads.items[i]);
+      return;
+   }
+
+   for (int i = 0; i < sym->ndecls; i++) {
+      const decl_t *dd = get_decl(sym, i);
+      if (dd->visibility == HIDDEN)
+         continue;
+      else if (!(dd->mask & N_SUBPROGRAM))
+         continue;
+
+      tree_t next = dd->tree;
+      if (dd->kind == T_ALIAS && !(next = get_aliased_subprogram(next)))
+         continue;
+
+      overload_add_candidate(o, next);
+   }
+
+   assert(sym->overloads.count == 0);
+   ARESERVE(sym->overloads, o->candidates.count);
+   for (unsigned i = 0; i < o->candidates.count; i++)
+      APUSH(sym->overloads, o->candidates.items[i]);
+
+   sym->memoised = true;
+}
+
 static type_t get_protected_type(nametab_t *tab, tree_t t)
 {
    switch (tree_kind(t)) {
@@ -2750,21 +2802,8 @@ static void begin_overload_resolution(overload_t *o)
    else
       o->symbol = iterate_symbol_for(o->nametab, o->name);
 
-   if (o->symbol != NULL) {
-      for (int i = 0; i < o->symbol->ndecls; i++) {
-         const decl_t *dd = get_decl(o->symbol, i);
-         if (dd->visibility == HIDDEN)
-            continue;
-         else if (!(dd->mask & N_SUBPROGRAM))
-            continue;
-
-         tree_t next = dd->tree;
-         if (dd->kind == T_ALIAS && !(next = get_aliased_subprogram(next)))
-            continue;
-
-         overload_add_candidate(o, next);
-      }
-   }
+   if (o->symbol != NULL)
+      overload_add_visible(o);
 
    overload_trace_candidates(o, "initial candidates");
 
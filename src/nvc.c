@@ -16,6 +16,7 @@
 //
 
 #include "util.h"
+#include "array.h"
 #include "common.h"
 #include "cov/cov-api.h"
 #include "diag.h"
@@ -90,6 +91,7 @@ const char version_string[] =
    LLVM_ONLY(" (Using LLVM " LLVM_VERSION ")") DEBUG_ONLY(" [debug]");
 
 static int process_command(int argc, char **argv, cmd_state_t *state);
+static int nvc_main(int argc, char **argv);
 static int parse_int(const char *str);
 static jit_t *get_jit(cmd_state_t *state);
 
@@ -112,7 +114,7 @@ static int scan_cmd(int start, int argc, char **argv)
       "-a", "-e", "-r", "-c", "--dump", "--make", "--syntax", "--list",
       "--init", "--install", "--print-deps", "--do", "-i",
       "--cover-export", "--preprocess", "--gui", "--cover-merge",
-      "--cover-report",
+      "--cover-report", "--server",
    };
 
    for (int i = start; i < argc; i++) {
@@ -153,8 +155,9 @@ static void parse_pp_define(char *optarg)
    }
 }
 
-static void do_file_list(const char *file, jit_t *jit, unit_registry_t *ur,
-                         mir_context_t *mc)
+typedef A(char *) file_list_t;
+
+static void do_file_list(const char *file, file_list_t *files)
 {
    FILE *f;
    if (strcmp(file, "-") == 0)
@@ -199,7 +202,7 @@ static void do_file_list(const char *file, jit_t *jit, unit_registry_t *ur,
             tb_append(tb, *p++);
       }
 
-      analyse_file(tb_get(tb), jit, ur, mc);
+      APUSH(*files, xstrdup(tb_get(tb)));
    }
 
    free(line);
@@ -219,16 +222,18 @@ static int analyse(int argc, char **argv, cmd_state_t *state)
       { "files",           required_argument, 0, 'f' },
       { "check-synthesis", no_argument,       0, 's' },
       { "no-save",         no_argument,       0, 'N' },
+      { "no-incremental",  no_argument,       0, 'n' },
       { "single-unit",     no_argument,       0, 'u' },
       { "preserve-case",   no_argument,       0, 'p' },
       { "keywords",        required_argument, 0, 'k' },
+      { "verbose",         no_argument,       0, 'V' },
       { 0, 0, 0, 0 }
    };
 
    const int next_cmd = scan_cmd(2, argc, argv);
    int c, index = 0, error_limit = 20;
    const char *file_list = NULL;
-   const char *spec = ":D:f:I:";
+   const char *spec = ":D:f:I:V";
    bool no_save = false;
 
    while ((c = getopt_long(next_cmd, argv, spec, long_options, &index)) != -1) {
@@ -272,6 +277,12 @@ static int analyse(int argc, char **argv, cmd_state_t *state)
       case 'N':
          no_save = true;
          break;
+      case 'n':
+         opt_set_int(OPT_INCREMENTAL, 0);
+         break;
+      case 'V':
+         opt_set_int(OPT_VERBOSE, 1);
+         break;
       case 'I':
          add_include_dir(optarg);
          break;
@@ -305,18 +316,28 @@ static int analyse(int argc, char **argv, cmd_state_t *state)
 
    jit_t *jit = jit_new(state->registry, state->mir, NULL);
 
+   file_list_t files = AINIT;
+
    if (file_list != NULL)
-      do_file_list(file_list, jit, state->registry, state->mir);
+      do_file_list(file_list, &files);
    else if (optind == next_cmd)
       fatal("missing file name");
 
    for (int i = optind; i < next_cmd; i++) {
       if (argv[i][0] == '@')
-         do_file_list(argv[i] + 1, jit, state->registry, state->mir);
+         do_file_list(argv[i] + 1, &files);
       else
-         analyse_file(argv[i], jit, state->registry, state->mir);
+         APUSH(files, xstrdup(argv[i]));
    }
 
+   if (files.count > 0)
+      analyse_files((const char **)files.items, files.count, jit,
+                    state->registry, state->mir);
+
+   for (int i = 0; i < files.count; i++)
+      free(files.items[i]);
+   ACLEAR(files);
+
    jit_free(jit);
    set_error_limit(0);
 
@@ -457,6 +478,7 @@ static int elaborate(int argc, char **argv, cmd_state_t *state)
       { "precompile",      no_argument,       0, 'p' },   // DEPRECATED 1.18
       { "no-collapse",     no_argument,       0, 'C' },
       { "trace",           no_argument,       0, 't' },
+      { "parallel",        no_argument,       0, 'P' },
       { 0, 0, 0, 0 }
    };
 
@@ -497,6 +519,9 @@ static int elaborate(int argc, char **argv, cmd_state_t *state)
       case 'C':
          opt_set_int(OPT_NO_COLLAPSE, 1);
          break;
+      case 'P':
+         opt_set_int(OPT_PARALLEL_ELAB, 1);
+         break;
       case 'j':
          use_jit = true;
          break;
@@ -600,13 +625,7 @@ static int elaborate(int argc, char **argv, cmd_state_t *state)
    progress("elaborating design");
 
    if (state->cover != NULL) {
-      fbuf_t *f = fbuf_open(meta.cover_file, FBUF_OUT, FBUF_CS_NONE);
-      if (f == NULL)
-         fatal_errno("failed to open coverage database: %s", meta.cover_file);
-
-      cover_dump_items(state->cover, f, COV_DUMP_ELAB);
-      fbuf_close(f, NULL);
-
+      cover_write_file(state->cover, meta.cover_file, COV_DUMP_ELAB);
       progress("dumping coverage data");
    }
 
@@ -744,6 +763,7 @@ static jit_t *get_jit(cmd_state_t *state)
    _std_reflection_init();
    _file_io_init();
    _nvc_sim_pkg_init();
+   _nvc_channel_init();
 
    return jit;
 }
@@ -766,27 +786,14 @@ static cover_data_t *load_coverage(const unit_meta_t *meta)
    if (meta->cover_file == NULL)
       return NULL;
 
-   fbuf_t *f = fbuf_open(meta->cover_file, FBUF_IN, FBUF_CS_NONE);
-   if (f == NULL)
-      fatal_errno("failed to open coverage database: %s", meta->cover_file);
-
-   cover_data_t *db = cover_read_items(f, 0);
-
-   fbuf_close(f, NULL);
-   return db;
+   return cover_read_file(meta->cover_file, 0);
 }
 
 static void emit_coverage(const unit_meta_t *meta, jit_t *j, cover_data_t *db)
 {
    assert(meta->cover_file != NULL);
 
-   fbuf_t *f = fbuf_open(meta->cover_file, FBUF_OUT, FBUF_CS_NONE);
-   if (f == NULL)
-      fatal_errno("failed to open coverage database: %s", meta->cover_file);
-
-   cover_dump_items(db, f, COV_DUMP_RUNTIME);
-
-   fbuf_close(f, NULL);
+   cover_write_file(db, meta->cover_file, COV_DUMP_RUNTIME);
 }
 
 static void enable_ieee_warnings_cb(rt_model_t *m, void *ctx)
@@ -829,6 +836,7 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
       { "vhpi-trace",    no_argument,       0, 'T' },
       { "gtkw",          optional_argument, 0, 'g' },
       { "shuffle",       no_argument,       0, 'H' },
+      { "profile-activity", optional_argument, 0, 'A' },
       { 0, 0, 0, 0 }
    };
 
@@ -837,6 +845,7 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
    const char   *wave_fname = NULL;
    const char   *gtkw_fname = NULL;
    const char   *pli_plugins = NULL;
+   const char   *activity_fname = NULL;
 
    static bool have_run = false;
    if (have_run)
@@ -936,6 +945,12 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
                "as non-deterministic behaviour");
          opt_set_int(OPT_SHUFFLE_PROCS, 1);
          break;
+      case 'A':
+         if (optarg == NULL)
+            activity_fname = "";
+         else
+            activity_fname = optarg;
+         break;
       default:
          should_not_reach_here();
       }
@@ -986,6 +1001,13 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
    else if (gtkw_fname != NULL)
       warnf("$bold$--gtkw$$ option has no effect without $bold$--wave$$");
 
+   if (activity_fname != NULL && *activity_fname == '\0') {
+      char *tmp LOCAL = xasprintf("%s.activity.json", state->top_level_arg);
+      opt_set_str(OPT_PROFILE_ACTIVITY, tmp);
+   }
+   else
+      opt_set_str(OPT_PROFILE_ACTIVITY, activity_fname);
+
    if (opt_get_size(OPT_HEAP_SIZE) < 0x100000)
       warnf("recommended heap size is at least 1M");
 
@@ -1749,6 +1771,7 @@ static int gui_cmd(int argc, char **argv, cmd_state_t *state)
       { "init",     required_argument, 0, 'i' },
       { "port",     required_argument, 0, 'p' },
       { "protocol", required_argument, 0, 'o' },
+      { "trace",    required_argument, 0, 't' },
       { 0, 0, 0, 0 }
    };
 
@@ -1780,6 +1803,7 @@ static int gui_cmd(int argc, char **argv, cmd_state_t *state)
                      "'http' and 'cxxrtl'", optarg);
          }
          break;
+      case 't': opt_set_str(OPT_TRACE_FILE, optarg); break;
       case '?': bad_option("gui", argv);
       case ':': missing_argument("gui", argv);
       default: abort();
@@ -1811,55 +1835,152 @@ static int gui_cmd(int argc, char **argv, cmd_state_t *state)
 }
 #endif
 
-static cover_data_t *merge_coverage_files(int argc, int next_cmd, char **argv,
-                                          cover_mask_t rpt_mask,
-                                          merge_mode_t mode)
+#ifdef ENABLE_SERVER
+static int compile_request(int argc, char **argv, void *ctx)
 {
-   // Merge all input coverage databases given on command line
+   // The request runs in a process forked from the server so discard
+   // any options and the standard set by the server's own command line
+   set_default_options();
+   reset_standard();
 
-   if (optind == next_cmd)
-      fatal("no input coverage database specified");
+   return nvc_main(argc, argv);
+}
 
-   cover_data_t *cover = NULL;
+static void preload_unit(lib_t lib, ident_t ident, int kind, void *ctx)
+{
+   if (lib_get_generic(lib, ident, NULL) != NULL)
+      (*(int *)ctx)++;
+}
 
-   for (int i = optind; i < next_cmd; i++) {
-      fbuf_t *f = fbuf_open(argv[i], FBUF_IN, FBUF_CS_NONE);
-      if (f == NULL) {
-         // Attempt to redirect the old file name to the new one
-         // TODO: this should be removed at some point
-         char *slash = strrchr(argv[i], *DIR_SEP) ?: strrchr(argv[i], '/');
-         if (slash != NULL && slash[1] == '_') {
-            char *tail = strstr(slash, ".covdb");
-            if (tail != NULL && tail[6] == '\0') {
-               ident_t unit_name = ident_new_n(slash + 2, tail - slash - 2);
-               lib_t lib = lib_find(ident_until(unit_name, '.'));
-               if (lib != NULL) {
-                  const unit_meta_t *meta;
-                  object_t *obj = lib_get_generic(lib, unit_name, &meta);
-                  if (obj != NULL && meta->cover_file != NULL) {
-                     warnf("redirecting %s to %s, please update your scripts",
-                           argv[i], meta->cover_file);
-                     f = fbuf_open(meta->cover_file, FBUF_IN, FBUF_CS_NONE);
-                  }
-               }
-            }
-         }
+static void preload_library(const char *name, int *count)
+{
+   lib_t lib = lib_require(ident_new(name));
+   lib_walk_index(lib, preload_unit, count);
+}
+
+static int server_cmd(int argc, char **argv, cmd_state_t *state)
+{
+   static struct option long_options[] = {
+      { "socket",  required_argument, 0, 's' },
+      { "preload", required_argument, 0, 'p' },
+      { 0, 0, 0, 0 }
+   };
+
+   const int next_cmd = scan_cmd(2, argc, argv);
+   int c, index = 0;
+   const char *spec = ":", *socket_path = "nvc.sock";
+   A(char *) preload = AINIT;
+   while ((c = getopt_long(next_cmd, argv, spec, long_options, &index)) != -1) {
+      switch (c) {
+      case 0: break;  // Set a flag
+      case 's': socket_path = optarg; break;
+      case 'p':
+         for (char *tok = strtok(optarg, ","); tok; tok = strtok(NULL, ","))
+            APUSH(preload, tok);
+         break;
+      case '?': bad_option("server", argv);
+      case ':': missing_argument("server", argv);
+      default: abort();
       }
+   }
 
-      if (f == NULL)
-         fatal_errno("could not open %s", argv[i]);
+   if (argc != optind)
+      fatal("$bold$--server$$ command takes no positional arguments");
+
+   // Each request opens its own work library relative to the client's
+   // working directory
+   lib_set_work(NULL);
+   lib_free(state->work);
+   state->work = NULL;
 
-      progress("loading input coverage database %s", argv[i]);
+   int count = 0;
+   if (preload.count == 0) {
+      preload_library("STD", &count);
+      preload_library("IEEE", &count);
+   }
+   else {
+      for (int i = 0; i < preload.count; i++)
+         preload_library(preload.items[i], &count);
+   }
+
+   ACLEAR(preload);
+
+   notef("loaded %d design units", count);
+
+   start_compile_server(socket_path, compile_request, NULL, NULL, NULL);
+   return EXIT_SUCCESS;
+}
+#endif
 
-      if (i == optind)
-         cover = cover_read_items(f, rpt_mask);
+static int connect_cmd(const char *path, int argc, char **argv)
+{
+#ifdef ENABLE_SERVER
+   // Forward the original arguments except the --connect option
+   A(char *) args = AINIT;
+   for (int i = 1; i < argc; i++) {
+      if (strncmp(argv[i], "--connect=", 10) == 0)
+         continue;
+      else if (strcmp(argv[i], "--connect") == 0)
+         i++;
       else
-         cover_merge_items(f, cover, mode);
+         APUSH(args, argv[i]);
+   }
 
-      fbuf_close(f, NULL);
+   const int rc = compile_client(path, args.count, args.items);
+   ACLEAR(args);
+   return rc;
+#else
+   fatal("%s was built without server support", PACKAGE);
+#endif
+}
+
+static const char *find_coverage_file(const char *arg)
+{
+   if (access(arg, R_OK) == 0)
+      return arg;
+
+   // Attempt to redirect the old file name to the new one
+   // TODO: this should be removed at some point
+   const char *slash = strrchr(arg, *DIR_SEP) ?: strrchr(arg, '/');
+   if (slash != NULL && slash[1] == '_') {
+      const char *tail = strstr(slash, ".covdb");
+      if (tail != NULL && tail[6] == '\0') {
+         ident_t unit_name = ident_new_n(slash + 2, tail - slash - 2);
+         lib_t lib = lib_find(ident_until(unit_name, '.'));
+         if (lib != NULL) {
+            const unit_meta_t *meta;
+            object_t *obj = lib_get_generic(lib, unit_name, &meta);
+            if (obj != NULL && meta->cover_file != NULL) {
+               warnf("redirecting %s to %s, please update your scripts",
+                     arg, meta->cover_file);
+               return meta->cover_file;
+            }
+         }
+      }
    }
 
-   return cover;
+   fatal_errno("could not open %s", arg);
+}
+
+static cover_data_t *merge_coverage_files(int argc, int next_cmd, char **argv,
+                                          cover_mask_t rpt_mask,
+                                          merge_mode_t mode, ident_t scope)
+{
+   // Merge all input coverage databases given on command line
+
+   if (optind == next_cmd)
+      fatal("no input coverage database specified");
+
+   const int nfiles = next_cmd - optind;
+   const char **files LOCAL = xmalloc_array(nfiles, sizeof(const char *));
+
+   for (int i = 0; i < nfiles; i++)
+      files[i] = find_coverage_file(argv[optind + i]);
+
+   progress("loading %d input coverage database%s", nfiles,
+            nfiles > 1 ? "s" : "");
+
+   return cover_merge_files(files, nfiles, rpt_mask, mode, scope);
 }
 
 static int cover_export_cmd(int argc, char **argv, cmd_state_t *state)
@@ -1924,7 +2045,8 @@ static int cover_export_cmd(int argc, char **argv, cmd_state_t *state)
 
    cover_data_t *cover;
    if (looks_like_file)
-      cover = merge_coverage_files(argc, next_cmd, argv, 0, MERGE_UNION);
+      cover = merge_coverage_files(argc, next_cmd, argv, 0, MERGE_UNION,
+                                   NULL);
    else {
       set_top_level(argv, next_cmd, state);
 
@@ -1974,6 +2096,7 @@ static int cover_report_cmd(int argc, char **argv, cmd_state_t *state)
       { "dont-print",   required_argument, 0, 'd' },
       { "item-limit",   required_argument, 0, 'l' },
       { "per-file",     no_argument,       0, 'f' },
+      { "scope",        required_argument, 0, 's' },
       { "verbose",      no_argument,       0, 'V' },
       { 0, 0, 0, 0 }
    };
@@ -1981,6 +2104,7 @@ static int cover_report_cmd(int argc, char **argv, cmd_state_t *state)
    const int next_cmd = scan_cmd(2, argc, argv);
 
    const char *outdir = NULL, *exclude_file = NULL;
+   ident_t scope = NULL;
    int c, index;
    const char *spec = ":Vo:";
    cover_mask_t rpt_mask = 0;
@@ -2007,6 +2131,9 @@ static int cover_report_cmd(int argc, char **argv, cmd_state_t *state)
       case 'f':
          rpt_mask |= COVER_MASK_PER_FILE_REPORT;
          break;
+      case 's':
+         scope = ident_new(optarg);
+         break;
       case 'V':
          opt_set_int(OPT_VERBOSE, 1);
          break;
@@ -2025,7 +2152,7 @@ static int cover_report_cmd(int argc, char **argv, cmd_state_t *state)
    progress("initialising");
 
    cover_data_t *cover =
-      merge_coverage_files(argc, next_cmd, argv, rpt_mask, MERGE_UNION);
+      merge_coverage_files(argc, next_cmd, argv, rpt_mask, MERGE_UNION, scope);
 
    if (exclude_file && cover) {
       progress("loading exclude file %s", exclude_file);
@@ -2082,13 +2209,12 @@ static int cover_merge_cmd(int argc, char **argv, cmd_state_t *state)
 
    progress("initialising");
 
-   cover_data_t *cover = merge_coverage_files(argc, next_cmd, argv, 0, mode);
+   cover_data_t *cover =
+      merge_coverage_files(argc, next_cmd, argv, 0, mode, NULL);
 
    progress("saving merged coverage database to %s", out_db);
 
-   fbuf_t *f = fbuf_open(out_db, FBUF_OUT, FBUF_CS_NONE);
-   cover_dump_items(cover, f, COV_DUMP_PROCESSING);
-   fbuf_close(f, NULL);
+   cover_write_file(cover, out_db, COV_DUMP_PROCESSING);
 
    argc -= next_cmd - 1;
    argv += next_cmd - 1;
@@ -2161,7 +2287,7 @@ static void usage(void)
       struct {
          const char *args;
          const char *usage;
-      } options[16];
+      } options[18];
    } groups[] = {
       { "Commands",
         {
@@ -2189,10 +2315,15 @@ static void usage(void)
              "Expand FILEs with Verilog preprocessor" },
            { "--print-deps [UNIT]...",
              "Print dependencies in Makefile format" },
+#ifdef ENABLE_SERVER
+           { "--server", "Run commands sent by clients on a local socket" },
+#endif
         }
       },
       { "Global options",
         {
+           { "--compress-libraries",
+             "Compress design units saved to libraries" },
            { "-h, --help", "Display this message and exit" },
            { "-H SIZE", "Set the maximum heap size to SIZE bytes" },
            { "--ieee-warnings={on,off,off-at-0}",
@@ -2208,6 +2339,9 @@ static void usage(void)
            { "--std={1993,..,2019}", "VHDL standard revision to use" },
            { "--stderr={note,warning,error,failure}",
              "Print messages of this severity level or higher to stderr" },
+#ifdef ENABLE_SERVER
+           { "--connect=SOCKET", "Send command to server listening on SOCKET" },
+#endif
            { "-v, --version", "Display version and copyright information" },
            { "--vhpi-debug", "Report VHPI errors as diagnostic messages" },
            { "--vhpi-trace", "Trace VHPI calls and events" },
@@ -2225,6 +2359,8 @@ static void usage(void)
            { "-I DIR", "Add DIR to list of Verilog include directories" },
            { "--keywords=VERSION",
              "Use keywords from specified Verilog version" },
+           { "--no-incremental",
+             "Analyse files even if they have not changed" },
            { "--no-save", "Do not save analysed design units" },
            { "--preserve-case",
              "Preserve the original case of VHDL identifiers" },
@@ -2232,6 +2368,7 @@ static void usage(void)
            { "--relaxed", "Disable certain pedantic rule checks" },
            { "--single-unit",
              "Treat all Verilog files as a single compilation unit" },
+           { "-V, --verbose", "Print files analysed or skipped" },
         }
       },
       { "Elaboration options",
@@ -2248,6 +2385,8 @@ static void usage(void)
            { "-O0, -O1, -O2, -O3", "Set optimisation level (default is -O2)" },
            { "--no-collapse", "Do not collapse multiple signals into one" },
            { "--no-save", "Do not save the elaborated design to disk" },
+           { "--parallel",
+             "Lower Verilog module instances on multiple threads" },
            { "-V, --verbose", "Print resource usage at each step" },
         }
       },
@@ -2262,6 +2401,9 @@ static void usage(void)
            { "--format={fst,vcd}", "Waveform dump format" },
            { "--include=GLOB",
              "Include signals matching GLOB in waveform dump" },
+           { "--profile-activity[=FILE]",
+             "Count signal events and process activity and write the "
+             "profile to FILE" },
            { "--shuffle", "Run processes in random order" },
            { "--stats", "Print time and memory usage at end of run" },
            { "--stop-delta=N", "Stop after N delta cycles (default 10000)" },
@@ -2270,11 +2412,21 @@ static void usage(void)
            { "-w, --wave[=FILE]", "Write waveform dump to FILE" },
         }
       },
+#ifdef ENABLE_SERVER
+      { "Server options",
+        {
+           { "--preload=LIB,...",
+             "Load all units in libraries LIB (default std,ieee)" },
+           { "--socket=PATH", "Listen on PATH (default nvc.sock)" },
+        }
+      },
+#endif
 #ifdef ENABLE_GUI
       { "GUI options",
         {
            { "--init=CMDS", "Evaluate TCL commands on startup" },
            { "--port=PORT", "Specify port for HTTP server" },
+           { "--trace=FILE", "Keep a queryable history of waves in FILE" },
         }
       },
 #endif
@@ -2291,6 +2443,8 @@ static void usage(void)
              "(default 5000)" },
            { "--per-file",
              "Create source file code coverage report." },
+           { "--scope=PATH",
+             "Only report on the design hierarchy below PATH" },
         }
       },
       { "Coverage merge options",
@@ -2471,6 +2625,9 @@ static int process_command(int argc, char **argv, cmd_state_t *state)
       { "cover-merge",  no_argument, 0, 'M' },
       { "cover-report", no_argument, 0, 'p' },
       { "preprocess",   no_argument, 0, 'R' },
+#ifdef ENABLE_SERVER
+      { "server",       no_argument, 0, 'S' },
+#endif
 #ifdef ENABLE_GUI
       { "gui",          no_argument, 0, 'g' },
 #endif
@@ -2517,6 +2674,10 @@ static int process_command(int argc, char **argv, cmd_state_t *state)
       return cover_report_cmd(argc, argv, state);
    case 'R':
       return preprocess_cmd(argc, argv, state);
+#ifdef ENABLE_SERVER
+   case 'S':
+      return server_cmd(argc, argv, state);
+#endif
 #ifdef ENABLE_GUI
    case 'g':
       return gui_cmd(argc, argv, state);
@@ -2527,18 +2688,8 @@ static int process_command(int argc, char **argv, cmd_state_t *state)
    }
 }
 
-int main(int argc, char **argv)
+static int nvc_main(int argc, char **argv)
 {
-   term_init();
-   thread_init();
-   set_default_options();
-   intern_strings();
-   register_signal_handlers();
-   mspace_stack_limit(MSPACE_CURRENT_FRAME);
-   check_cpu_features();
-
-   atexit(fbuf_cleanup);
-
    static struct option long_options[] = {
       { "help",          no_argument,       0, 'h' },
       { "version",       no_argument,       0, 'v' },
@@ -2554,12 +2705,17 @@ int main(int argc, char **argv)
       { "vhpi-debug",    no_argument,       0, 'D' },
       { "vhpi-trace",    no_argument,       0, 'T' },
       { "seed",          required_argument, 0, 'S' },
+      { "compress-libraries", no_argument,  0, 'z' },
+#ifdef ENABLE_SERVER
+      { "connect",       required_argument, 0, 'C' },
+#endif
       { 0, 0, 0, 0 }
    };
 
    opterr = 0;
+   optind = 1;
 
-   const char *work_name = "work";
+   const char *work_name = "work", *connect_path = NULL;
    cmd_state_t state = {};
 
    const int next_cmd = scan_cmd(1, argc, argv);
@@ -2628,6 +2784,12 @@ int main(int argc, char **argv)
       case 'S':
          opt_set_int(OPT_RANDOM_SEED, parse_int(optarg));
          break;
+      case 'z':
+         opt_set_int(OPT_LIB_COMPRESS, 1);
+         break;
+      case 'C':
+         connect_path = optarg;
+         break;
       case '?':
          bad_option("global", argv);
       case ':':
@@ -2637,6 +2799,9 @@ int main(int argc, char **argv)
       }
    }
 
+   if (connect_path != NULL)
+      return connect_cmd(connect_path, argc, argv);
+
    srand(opt_get_int(OPT_RANDOM_SEED));
 
    state.work = lib_new(work_name);
@@ -2669,3 +2834,18 @@ int main(int argc, char **argv)
 
    return ret;
 }
+
+int main(int argc, char **argv)
+{
+   term_init();
+   thread_init();
+   set_default_options();
+   intern_strings();
+   register_signal_handlers();
+   mspace_stack_limit(MSPACE_CURRENT_FRAME);
+   check_cpu_features();
+
+   atexit(fbuf_cleanup);
+
+   return nvc_main(argc, argv);
+}
@@ -84,11 +84,11 @@ typedef struct _object_arena {
 #define ITEM_NUMBER      (I_NUMBER)
 
 static const char *item_text_map[] = {
-   "I_IDENT",    "I_VALUE",      "I_PRIMARY",  "I_GENERICS",   "I_PORTS",
+   "I_IDENT",    "I_VALUE",      "I_TYPE",     "I_REF",        "I_PORTS",
    "I_DECLS",    "I_STMTS",      "I_TARGET",   "I_IVAL",       "I_IDENT2",
    "I_SEVERITY", "I_GENMAPS",    "I_PARAMS",   "I_WAVES",      "I_CONDS",
-   "I_TYPE",     "I_SUBKIND",    "I_DELAY",    "I_REJECT",     "I_POS",
-   "I_REF",      "I_FILE_MODE",  "I_ASSOCS",   "I_CONTEXT",    "I_TRIGGERS",
+   "I_PRIMARY",  "I_SUBKIND",    "I_DELAY",    "I_REJECT",     "I_POS",
+   "I_GENERICS", "I_FILE_MODE",  "I_ASSOCS",   "I_CONTEXT",    "I_TRIGGERS",
    "I_PARTS"  ,  "I_CLASS",      "I_RANGES",   "I_NAME",       "I_PRAGMAS",
    "I_DVAL",     "I_SPEC",       "I_FOREIGN",  "I_INDEXES",    "I_BASE",
    "I_ELEM",     "I_DESIGNATED", "???",        "I_RESOLUTION", "I_RESULT",
@@ -345,6 +345,12 @@ static void object_init(object_class_t *class)
       class->object_size[i] = sizeof(object_t) + (nitems * sizeof(item_t));
       DEBUG_ONLY(all_items |= class->has_map[i]);
 
+      memset(class->item_map[i], -1, sizeof(item_map_t));
+      for (int bit = 0, n = 0; bit < 64; bit++) {
+         if (class->has_map[i] & ONE_HOT(bit))
+            class->item_map[i][bit] = n++;
+      }
+
       format_digest += knuth_hash(class->has_map[i] >> 32);
       format_digest += knuth_hash(class->has_map[i]);
    }
@@ -1026,6 +1032,12 @@ object_t *object_read(fbuf_t *f, object_load_fn_t loader_fn,
    return (object_t *)arena->base;
 }
 
+uint32_t object_format_digest(void)
+{
+   object_one_time_init();
+   return format_digest;
+}
+
 unsigned object_next_generation(void)
 {
    return next_generation++;
@@ -1255,6 +1267,15 @@ void arena_walk_deps(object_arena_t *arena, arena_deps_fn_t fn, void *context)
       (*fn)(object_arena_name(arena->deps.items[i]), context);
 }
 
+void arena_walk_dep_checksums(object_arena_t *arena, arena_checksum_fn_t fn,
+                              void *context)
+{
+   for (unsigned i = 0; i < arena->deps.count; i++) {
+      object_arena_t *dep = arena->deps.items[i];
+      (*fn)(object_arena_name(dep), dep->checksum, context);
+   }
+}
+
 void arena_walk_obsolete_deps(object_arena_t *arena, arena_deps_fn_t fn,
                               void *context)
 {
@@ -34,10 +34,13 @@
 
 typedef uint64_t imask_t;
 
+// The most frequently accessed items have the lowest bits so they are
+// stored first and share a cache line with the object header
+
 #define I_IDENT      ONE_HOT(0)
 #define I_VALUE      ONE_HOT(1)
-#define I_PRIMARY    ONE_HOT(2)
-#define I_GENERICS   ONE_HOT(3)
+#define I_TYPE       ONE_HOT(2)
+#define I_REF        ONE_HOT(3)
 #define I_PORTS      ONE_HOT(4)
 #define I_DECLS      ONE_HOT(5)
 #define I_STMTS      ONE_HOT(6)
@@ -49,12 +52,12 @@ typedef uint64_t imask_t;
 #define I_PARAMS     ONE_HOT(12)
 #define I_WAVES      ONE_HOT(13)
 #define I_CONDS      ONE_HOT(14)
-#define I_TYPE       ONE_HOT(15)
+#define I_PRIMARY    ONE_HOT(15)
 #define I_SUBKIND    ONE_HOT(16)
 #define I_DELAY      ONE_HOT(17)
 #define I_REJECT     ONE_HOT(18)
 #define I_POS        ONE_HOT(19)
-#define I_REF        ONE_HOT(20)
+#define I_GENERICS   ONE_HOT(20)
 #define I_FILE_MODE  ONE_HOT(21)
 #define I_ASSOCS     ONE_HOT(22)
 #define I_CONTEXT    ONE_HOT(23)
@@ -106,18 +109,18 @@ enum {
 
 STATIC_ASSERT(OBJECT_ALIGN >= sizeof(double));
 
+// Index into the items array for each item bit or -1 if not present
+typedef int8_t item_map_t[64];
+
 #define lookup_item(class, t, mask) ({                                  \
          assert((t) != NULL);                                           \
          assert((mask & (mask - 1)) == 0);                              \
                                                                         \
-         const imask_t __has = has_map[(t)->object.kind];               \
+         const int __n = item_map[(t)->object.kind][__builtin_ctzll(mask)]; \
                                                                         \
-         if (unlikely((__has & (mask)) == 0))                           \
+         if (unlikely(__n < 0))                                         \
             object_lookup_failed((class), &(t)->object, mask);          \
                                                                         \
-         const imask_t __below = __has & ((mask) - 1);                  \
-         const int __n = __builtin_popcountll(__below);                 \
-                                                                        \
          &((t)->object.items[__n]);                                     \
       })
 
@@ -212,6 +215,7 @@ typedef struct {
    const char             *name;
    const change_allowed_t *change_allowed;
    const imask_t          *has_map;
+   item_map_t             *item_map;
    const char            **kind_text_map;
    const int               tag;
    const int               last_kind;
@@ -233,6 +237,7 @@ object_t *object_new(object_arena_t *arena,
 void object_visit(object_t *object, object_visit_ctx_t *ctx);
 object_t *object_rewrite(object_t *object, object_rewrite_ctx_t *ctx);
 unsigned object_next_generation(void);
+uint32_t object_format_digest(void);
 void object_copy(object_copy_ctx_t *ctx);
 object_arena_t *object_arena(object_t *object);
 size_t object_arena_default_size(void);
@@ -262,6 +267,9 @@ void object_arena_freeze(object_arena_t *arena);
 
 typedef void (*arena_deps_fn_t)(ident_t, void *);
 void arena_walk_deps(object_arena_t *arena, arena_deps_fn_t fn, void *context);
+typedef void (*arena_checksum_fn_t)(ident_t, uint32_t, void *);
+void arena_walk_dep_checksums(object_arena_t *arena, arena_checksum_fn_t fn,
+                              void *context);
 void arena_walk_obsolete_deps(object_arena_t *arena, arena_deps_fn_t fn,
                               void *context);
 
@@ -181,4 +181,10 @@ void set_default_options(void)
    opt_set_str(OPT_GVN_VERBOSE, getenv("NVC_GVN_VERBOSE"));
    opt_set_str(OPT_DCE_VERBOSE, getenv("NVC_DCE_VERBOSE"));
    opt_set_int(OPT_RANDOM_SEED, get_timestamp_us());
+   opt_set_str(OPT_TRACE_FILE, NULL);
+   opt_set_int(OPT_PARALLEL_ELAB, 0);
+   opt_set_str(OPT_PROFILE_ACTIVITY, NULL);
+   opt_set_int(OPT_INCREMENTAL, 1);
+   opt_set_int(OPT_LIB_COMPRESS, 0);
+   opt_set_int(OPT_FAST_SCAN, get_int_env("NVC_FAST_SCAN", 1));
 }
@@ -76,6 +76,12 @@ typedef enum {
    OPT_GVN_VERBOSE,
    OPT_DCE_VERBOSE,
    OPT_RANDOM_SEED,
+   OPT_TRACE_FILE,
+   OPT_PARALLEL_ELAB,
+   OPT_PROFILE_ACTIVITY,
+   OPT_INCREMENTAL,
+   OPT_LIB_COMPRESS,
+   OPT_FAST_SCAN,
 
    OPT_LAST_NAME
 } opt_name_t;
@@ -149,10 +149,13 @@ struct _type {
    object_t object;
 };
 
+static item_map_t item_map[P_LAST_PSL_KIND];
+
 object_class_t psl_object = {
    .name           = "psl",
    .change_allowed = change_allowed,
    .has_map        = has_map,
+   .item_map       = item_map,
    .kind_text_map  = kind_text_map,
    .has_loc        = true,
    .tag            = OBJECT_TAG_PSL,
@@ -0,0 +1,233 @@
+//
+//  Copyright (C) 2025  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "util.h"
+#include "array.h"
+#include "diag.h"
+#include "jit/jit.h"
+#include "jit/jit-ffi.h"
+#include "rt/nvc_channel.h"
+#include "rt/rt.h"
+#include "thread.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_DEPTH  (1 << 20)
+#define MAX_WIDTH  (1 << 16)
+#define SPIN_LIMIT 1000
+#define SLEEP_USEC 100
+#define WARN_SPINS (SPIN_LIMIT + 10000000 / SLEEP_USEC)   // 10 seconds
+
+typedef struct {
+   nvc_channel_t *map;
+   size_t         size;
+   int            fd;
+} channel_slot_t;
+
+static A(channel_slot_t) channels;
+
+static nvc_channel_t *get_channel(int32_t handle)
+{
+   if (handle < 0 || handle >= channels.count
+       || channels.items[handle].map == NULL)
+      jit_msg(NULL, DIAG_FATAL, "invalid channel handle %d", handle);
+
+   return channels.items[handle].map;
+}
+
+static void channel_backoff(int *spins)
+{
+   // The model normally runs on another core so spin briefly before
+   // sleeping to avoid adding latency to each transaction.  Sleeping
+   // happens in a blocking region so garbage collection and other
+   // stop_world callers do not wait for the model.
+   if (*spins < SPIN_LIMIT) {
+      (*spins)++;
+      spin_wait();
+      return;
+   }
+   else if (*spins < WARN_SPINS)
+      (*spins)++;
+   else if (*spins == WARN_SPINS) {
+      // A model serviced by this thread, for example from a VHPI
+      // callback at the end of the time step, can never run while a
+      // process is blocked here
+      jit_msg(NULL, DIAG_WARN, "still waiting for the foreign model: a "
+              "model that runs in this process at the end of a time step "
+              "must use CHANNEL_TRY_SEND and CHANNEL_TRY_RECV instead");
+      (*spins)++;
+   }
+
+   thread_sleep_blocked(SLEEP_USEC);
+}
+
+static void check_message_size(nvc_channel_t *ch, size_t count)
+{
+   if (count > ch->width)
+      jit_msg(NULL, DIAG_FATAL, "message of %zu words exceeds channel "
+              "width %u", count, ch->width);
+}
+
+DLLEXPORT
+void _nvc_channel_open(jit_scalar_t *args)
+{
+   const uint8_t *path_ptr = args[1].pointer;
+   size_t path_len = ffi_array_length(args[3].integer);
+   int64_t depth = args[4].integer;
+   int64_t width = args[5].integer;
+
+   if (depth > MAX_DEPTH)
+      jit_msg(NULL, DIAG_FATAL, "channel depth %"PRIi64" is greater than "
+              "the maximum %d", depth, MAX_DEPTH);
+   else if (width > MAX_WIDTH)
+      jit_msg(NULL, DIAG_FATAL, "channel width %"PRIi64" is greater than "
+              "the maximum %d", width, MAX_WIDTH);
+
+   char *path LOCAL = null_terminate(path_ptr, path_len);
+
+   int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+   if (fd < 0)
+      jit_msg(NULL, DIAG_FATAL, "cannot create channel %s: %s", path,
+              strerror(errno));
+
+   depth = next_power_of_2(depth);
+
+   const size_t size = nvc_channel_size(depth, width);
+   if (ftruncate(fd, size) != 0)
+      jit_msg(NULL, DIAG_FATAL, "cannot resize channel %s: %s", path,
+              strerror(errno));
+
+   nvc_channel_t *ch = map_shared_file(fd, size);
+   memset(ch, '\0', sizeof(nvc_channel_t));
+   ch->version = NVC_CHANNEL_VERSION;
+   ch->depth   = depth;
+   ch->width   = width;
+
+   // The foreign model may already be polling the file for the magic
+   // number so publish it after the rest of the header
+   __atomic_store_n(&ch->magic, NVC_CHANNEL_MAGIC, __ATOMIC_RELEASE);
+
+   const channel_slot_t slot = { ch, size, fd };
+   APUSH(channels, slot);
+
+   args[0].integer = channels.count - 1;
+}
+
+DLLEXPORT
+void _nvc_channel_close(jit_scalar_t *args)
+{
+   int32_t handle = args[2].integer;
+
+   nvc_channel_t *ch = get_channel(handle);
+   channel_slot_t *slot = &(channels.items[handle]);
+
+   unmap_file(ch, slot->size);
+   close(slot->fd);
+
+   slot->map = NULL;
+}
+
+DLLEXPORT
+void _nvc_channel_try_send(jit_scalar_t *args)
+{
+   nvc_channel_t *ch = get_channel(args[1].integer);
+   const int32_t *words = args[2].pointer;
+   size_t count = ffi_array_length(args[4].integer);
+
+   check_message_size(ch, count);
+
+   args[0].integer = nvc_channel_push(ch, NVC_CHANNEL_TO_MODEL, words, count);
+}
+
+DLLEXPORT
+void _nvc_channel_send(jit_scalar_t *args)
+{
+   nvc_channel_t *ch = get_channel(args[2].integer);
+   const int32_t *words = args[3].pointer;
+   size_t count = ffi_array_length(args[5].integer);
+
+   check_message_size(ch, count);
+
+   for (int spins = 0;
+        !nvc_channel_push(ch, NVC_CHANNEL_TO_MODEL, words, count);)
+      channel_backoff(&spins);
+}
+
+static void channel_recv(nvc_channel_t *ch, const int32_t *payload,
+                         uint32_t count, jit_scalar_t *args)
+{
+   int32_t *words = args[3].pointer;
+   size_t max = ffi_array_length(args[5].integer);
+   int32_t *length = args[6].pointer;
+
+   // The length is written by the other side of the shared ring so
+   // must not be trusted to fit within the slot
+   if (count > ch->width)
+      jit_msg(NULL, DIAG_FATAL, "received message of %u words exceeds "
+              "channel width %u", count, ch->width);
+
+   if (count > max)
+      jit_msg(NULL, DIAG_FATAL, "received message of %u words is too long "
+              "for buffer of length %zu", count, max);
+
+   memcpy(words, payload, count * sizeof(int32_t));
+   *length = count;
+
+   nvc_channel_release(ch, NVC_CHANNEL_TO_SIM);
+}
+
+DLLEXPORT
+void _nvc_channel_try_recv(jit_scalar_t *args)
+{
+   nvc_channel_t *ch = get_channel(args[2].integer);
+   uint8_t *valid = args[7].pointer;
+
+   uint32_t count;
+   const int32_t *payload = nvc_channel_front(ch, NVC_CHANNEL_TO_SIM, &count);
+   if (payload == NULL) {
+      *(int32_t *)args[6].pointer = 0;
+      *valid = 0;
+   }
+   else {
+      channel_recv(ch, payload, count, args);
+      *valid = 1;
+   }
+}
+
+DLLEXPORT
+void _nvc_channel_recv(jit_scalar_t *args)
+{
+   nvc_channel_t *ch = get_channel(args[2].integer);
+
+   uint32_t count;
+   const int32_t *payload;
+   for (int spins = 0;
+        !(payload = nvc_channel_front(ch, NVC_CHANNEL_TO_SIM, &count));)
+      channel_backoff(&spins);
+
+   channel_recv(ch, payload, count, args);
+}
+
+void _nvc_channel_init(void)
+{
+   // Dummy function to force linking
+}
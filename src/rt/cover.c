@@ -29,6 +29,10 @@
 #include <string.h>
 #include <limits.h>
 
+#ifdef ARCH_X86_64
+#include <x86intrin.h>
+#endif
+
 enum std_ulogic {
    _U  = 0x0,
    _X  = 0x1,
@@ -126,65 +130,122 @@ static inline void cover_toggle_check_0_1_u_z(uint8_t old, uint8_t new,
 }
 
 __attribute__((always_inline))
-static inline void cover_toggle_generic(rt_signal_t *s, int32_t *counters,
-                                        toggle_check_fn_t fn)
+static inline void cover_toggle_bytes(const uint8_t *cur, const uint8_t *last,
+                                      int len, int32_t *counters,
+                                      toggle_check_fn_t fn)
 {
-   const void *cur = signal_value(s);
-   const void *last = signal_last_value(s);
-
-   // Callback is optimized for performance
-   // Check only group of 8 bytes that do have change of signal value
-   // Optimize for assumption that most bits don't change in large signals
-   uint32_t s_size = s->shared.size;
-   uint32_t batches = ((s_size - 1) / sizeof(uint64_t)) + 1;
-   for (int i = 0; i < batches; i++) {
-      int batch_size = sizeof(uint64_t);
-      if (i < batches - 1) {
-         const void *batch_new = cur + i * sizeof(uint64_t);
-         const void *batch_old = last + i * sizeof(uint64_t);
-         if (memcmp(batch_new, batch_old, sizeof(uint64_t)) == 0)
-            continue;
-      }
-      else
-         batch_size = ((s_size - 1) % sizeof(uint64_t)) + 1;
-
-      int32_t low = i * sizeof(uint64_t);
-      int32_t high = low + batch_size;
-      int32_t *toggle_01 = counters + low * 2;
-      int32_t *toggle_10 = toggle_01 + 1;
-      for (int j = low; j < high; j++) {
-         uint8_t new = ((const uint8_t *)cur)[j];
-         uint8_t old = ((const uint8_t *)last)[j];
-         if (new != old)
-            (*fn)(old, new, toggle_01, toggle_10);
-         toggle_01 += 2;
-         toggle_10 += 2;
-      }
+   for (int i = 0; i < len; i++) {
+      if (cur[i] != last[i])
+         (*fn)(last[i], cur[i], counters + i * 2, counters + i * 2 + 1);
    }
 }
 
-static void cover_toggle_cb_0_1(uint64_t now, rt_signal_t *s, rt_watch_t *w,
-                                void *user)
+static void cover_toggle_scalar(const uint8_t *cur, const uint8_t *last,
+                                int len, int32_t *counters, bool from_u,
+                                bool to_z)
 {
-   cover_toggle_generic(s, user, cover_toggle_check_0_1);
+   if (from_u && to_z)
+      cover_toggle_bytes(cur, last, len, counters, cover_toggle_check_0_1_u_z);
+   else if (from_u)
+      cover_toggle_bytes(cur, last, len, counters, cover_toggle_check_0_1_u);
+   else if (to_z)
+      cover_toggle_bytes(cur, last, len, counters, cover_toggle_check_0_1_z);
+   else
+      cover_toggle_bytes(cur, last, len, counters, cover_toggle_check_0_1);
 }
 
-static void cover_toggle_cb_0_1_u(uint64_t now, rt_signal_t *s, rt_watch_t *w,
-                                  void *user)
+#ifdef HAVE_SSE41
+__attribute__((target("sse4.1")))
+static void cover_toggle_sse41(const uint8_t *cur, const uint8_t *last,
+                               int len, int32_t *counters, bool from_u,
+                               bool to_z)
 {
-   cover_toggle_generic(s, user, cover_toggle_check_0_1_u);
-}
+   const __m128i v0 = _mm_set1_epi8(_0);
+   const __m128i v1 = _mm_set1_epi8(_1);
+   const __m128i vu = _mm_set1_epi8(_U);
+   const __m128i vx = _mm_set1_epi8(_X);
+   const __m128i vz = _mm_set1_epi8(_Z);
+
+   int pos = 0;
+   for (; pos + 15 < len; pos += 16) {
+      __m128i new = _mm_loadu_si128((const __m128i *)(cur + pos));
+      __m128i old = _mm_loadu_si128((const __m128i *)(last + pos));
+      if (_mm_testc_si128(_mm_cmpeq_epi8(new, old), _mm_set1_epi8(0xff)))
+         continue;   // Most lanes in a wide signal do not change
+
+      __m128i old0 = _mm_cmpeq_epi8(old, v0);
+      __m128i old1 = _mm_cmpeq_epi8(old, v1);
+      __m128i new0 = _mm_cmpeq_epi8(new, v0);
+      __m128i new1 = _mm_cmpeq_epi8(new, v1);
+
+      __m128i rise = _mm_and_si128(old0, new1);
+      __m128i fall = _mm_and_si128(old1, new0);
+
+      if (from_u) {
+         __m128i oldux = _mm_or_si128(_mm_cmpeq_epi8(old, vu),
+                                      _mm_cmpeq_epi8(old, vx));
+         rise = _mm_or_si128(rise, _mm_and_si128(oldux, new1));
+         fall = _mm_or_si128(fall, _mm_and_si128(oldux, new0));
+      }
 
-static void cover_toggle_cb_0_1_z(uint64_t now, rt_signal_t *s, rt_watch_t *w,
-                                  void *user)
-{
-   cover_toggle_generic(s, user, cover_toggle_check_0_1_z);
+      if (to_z) {
+         __m128i oldz = _mm_cmpeq_epi8(old, vz);
+         __m128i newz = _mm_cmpeq_epi8(new, vz);
+         rise = _mm_or_si128(rise, _mm_and_si128(old0, newz));
+         rise = _mm_or_si128(rise, _mm_and_si128(oldz, new1));
+         fall = _mm_or_si128(fall, _mm_and_si128(old1, newz));
+         fall = _mm_or_si128(fall, _mm_and_si128(oldz, new0));
+      }
+
+      for (int bits = _mm_movemask_epi8(rise); bits; bits &= bits - 1)
+         increment_counter(counters + (pos + __builtin_ctz(bits)) * 2);
+
+      for (int bits = _mm_movemask_epi8(fall); bits; bits &= bits - 1)
+         increment_counter(counters + (pos + __builtin_ctz(bits)) * 2 + 1);
+   }
+
+   if (pos < len)
+      cover_toggle_scalar(cur + pos, last + pos, len - pos,
+                          counters + pos * 2, from_u, to_z);
 }
+#endif
 
-static void cover_toggle_cb_0_1_u_z(uint64_t now, rt_signal_t *s, rt_watch_t *w,
-                                    void *user)
+void cover_sample_toggles(rt_model_t *m, rt_toggle_t **toggles, unsigned count)
 {
-   cover_toggle_generic(s, user, cover_toggle_check_0_1_u_z);
+   cover_data_t *data = get_coverage(m);
+   assert(data != NULL);
+
+   const bool from_u = !!(data->mask & COVER_MASK_TOGGLE_COUNT_FROM_UNDEFINED);
+   const bool to_z = !!(data->mask & COVER_MASK_TOGGLE_COUNT_FROM_TO_Z);
+
+   unsigned deltas;
+   const uint64_t now = model_now(m, &deltas);
+
+   for (unsigned i = 0; i < count; i++) {
+      rt_signal_t *s = toggles[i]->signal;
+      const uint8_t *bytes = s->shared.data;
+
+      // Only nexuses that had an event in this cycle have a valid last
+      // value to compare against
+      rt_nexus_t *n = &(s->nexus);
+      for (unsigned j = 0; j < s->n_nexus; j++, n = n->chain) {
+         if (n->last_event != now || n->event_delta != deltas)
+            continue;
+
+         const uint8_t *cur = bytes + n->offset;
+         const uint8_t *last = cur + s->shared.size;
+         const int len = n->width * n->size;
+         int32_t *counters = toggles[i]->counters + n->offset * 2;
+
+#if defined HAVE_SSE41 && !ASAN_ENABLED
+         if (likely(__builtin_cpu_supports("sse4.1"))) {
+            cover_toggle_sse41(cur, last, len, counters, from_u, to_z);
+            continue;
+         }
+#endif
+         cover_toggle_scalar(cur, last, len, counters, from_u, to_z);
+      }
+   }
 }
 
 static bool is_constant_input(rt_signal_t *s)
@@ -226,8 +287,6 @@ void x_cover_setup_toggle_cb(sig_shared_t *ss, int32_t tag)
    if (counters == NULL)
       return;
 
-   cover_mask_t op_mask = data->mask;
-
    if (is_constant_input(s)) {
       int32_t *toggle_01 = counters + tag;
       int32_t *toggle_10 = toggle_01 + 1;
@@ -245,20 +304,7 @@ void x_cover_setup_toggle_cb(sig_shared_t *ss, int32_t tag)
       return;
    }
 
-   sig_event_fn_t fn = &cover_toggle_cb_0_1;
-
-   if ((op_mask & COVER_MASK_TOGGLE_COUNT_FROM_UNDEFINED) &&
-       (op_mask & COVER_MASK_TOGGLE_COUNT_FROM_TO_Z))
-      fn = &cover_toggle_cb_0_1_u_z;
-
-   else if (op_mask & COVER_MASK_TOGGLE_COUNT_FROM_UNDEFINED)
-      fn = &cover_toggle_cb_0_1_u;
-
-   else if (op_mask & COVER_MASK_TOGGLE_COUNT_FROM_TO_Z)
-      fn = &cover_toggle_cb_0_1_z;
-
-   rt_watch_t *w = watch_new(m, fn, counters + tag, WATCH_EVENT, 1);
-   model_set_event_cb(m, s, w);
+   toggle_new(m, s, counters + tag);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -96,6 +96,29 @@ typedef struct {
    unsigned      max;
 } deferq_t;
 
+typedef struct {
+   rt_nexus_t *nexus;
+   uint64_t    transactions;
+   uint64_t    events;
+} nexus_activity_t;
+
+typedef struct {
+   rt_proc_t *proc;
+   uint64_t   wakeups;
+   uint64_t   runs;
+   uint64_t   time_ns;
+} proc_activity_t;
+
+typedef A(nexus_activity_t *) nexus_activity_list_t;
+typedef A(proc_activity_t *) proc_activity_list_t;
+
+typedef struct {
+   hash_t                *nexus_map;
+   hash_t                *proc_map;
+   nexus_activity_list_t  nexuses;
+   proc_activity_list_t   procs;
+} activity_t;
+
 typedef struct _rt_model {
    tree_t             top;
    hash_t            *scopes;
@@ -135,9 +158,12 @@ typedef struct _rt_model {
    memblock_t        *memblocks;
    model_thread_t    *threads[MAX_THREADS];
    signal_list_t      eventsigs;
+   toggle_list_t      toggles;
+   toggle_list_t      toggleq;
    bool               shuffle;
    bool               liveness;
    rt_trigger_t      *triggertab[TRIGGER_TAB_SIZE];
+   activity_t        *activity;
 } rt_model_t;
 
 #define FMT_VALUES_SZ   128
@@ -146,6 +172,7 @@ typedef struct _rt_model {
 #define WAVEFORM_CHUNK  256
 #define PENDING_MIN     4
 #define MAX_RANK        UINT8_MAX
+#define ACTIVITY_TOP    20
 
 #define TRACE(...) do {                                 \
       if (unlikely(__trace_on))                         \
@@ -532,6 +559,205 @@ rt_scope_t *get_active_scope(rt_model_t *m)
    return model_thread(m)->active_scope;
 }
 
+static activity_t *activity_new(void)
+{
+   activity_t *a = xcalloc(sizeof(activity_t));
+   a->nexus_map = hash_new(256);
+   a->proc_map  = hash_new(64);
+
+   return a;
+}
+
+static nexus_activity_t *nexus_activity(rt_model_t *m, rt_nexus_t *n)
+{
+   activity_t *a = m->activity;
+
+   nexus_activity_t *na = hash_get(a->nexus_map, n);
+   if (na == NULL) {
+      na = xcalloc(sizeof(nexus_activity_t));
+      na->nexus = n;
+
+      hash_put(a->nexus_map, n, na);
+      APUSH(a->nexuses, na);
+   }
+
+   return na;
+}
+
+static proc_activity_t *proc_activity(rt_model_t *m, rt_proc_t *proc)
+{
+   activity_t *a = m->activity;
+
+   proc_activity_t *pa = hash_get(a->proc_map, proc);
+   if (pa == NULL) {
+      pa = xcalloc(sizeof(proc_activity_t));
+      pa->proc = proc;
+
+      hash_put(a->proc_map, proc, pa);
+      APUSH(a->procs, pa);
+   }
+
+   return pa;
+}
+
+static void get_nexus_path(rt_nexus_t *n, text_buf_t *tb)
+{
+   rt_scope_t *s = n->signal->parent;
+   while (is_signal_scope(s))
+      s = s->parent;
+
+   get_path_name(s, tb);
+   tb_append(tb, ':');
+   tb_cat(tb, trace_nexus(n));
+   tb_downcase(tb);
+}
+
+static int nexus_activity_cmp(const void *a, const void *b)
+{
+   const nexus_activity_t *na = *(const nexus_activity_t **)a;
+   const nexus_activity_t *nb = *(const nexus_activity_t **)b;
+
+   if (na->events != nb->events)
+      return na->events > nb->events ? -1 : 1;
+   else if (na->transactions != nb->transactions)
+      return na->transactions > nb->transactions ? -1 : 1;
+   else
+      return 0;
+}
+
+static int proc_activity_cmp(const void *a, const void *b)
+{
+   const proc_activity_t *pa = *(const proc_activity_t **)a;
+   const proc_activity_t *pb = *(const proc_activity_t **)b;
+
+   if (pa->time_ns != pb->time_ns)
+      return pa->time_ns > pb->time_ns ? -1 : 1;
+   else if (pa->runs != pb->runs)
+      return pa->runs > pb->runs ? -1 : 1;
+   else
+      return 0;
+}
+
+static void json_string(FILE *f, const char *str)
+{
+   fputc('"', f);
+   for (const char *p = str; *p; p++) {
+      if (*p == '"' || *p == '\\')
+         fprintf(f, "\\%c", *p);
+      else if ((unsigned char)*p < 0x20 || (unsigned char)*p >= 0x80)
+         fprintf(f, "\\u%04x", (unsigned char)*p);   // Latin-1
+      else
+         fputc(*p, f);
+   }
+   fputc('"', f);
+}
+
+static void write_activity_json(rt_model_t *m, const char *fname)
+{
+   activity_t *a = m->activity;
+
+   FILE *f = fopen(fname, "w");
+   if (f == NULL) {
+      errorf("cannot create %s: %s", fname, last_os_error());
+      return;
+   }
+
+   LOCAL_TEXT_BUF tb = tb_new();
+
+   fprintf(f, "{\n  \"signals\": [");
+
+   for (int i = 0; i < a->nexuses.count; i++) {
+      nexus_activity_t *na = a->nexuses.items[i];
+
+      tb_rewind(tb);
+      get_nexus_path(na->nexus, tb);
+
+      fprintf(f, "%s\n    { \"name\": ", i > 0 ? "," : "");
+      json_string(f, tb_get(tb));
+      fprintf(f, ", \"transactions\": %"PRIu64", \"events\": %"PRIu64" }",
+              na->transactions, na->events);
+   }
+
+   fprintf(f, "\n  ],\n  \"processes\": [");
+
+   for (int i = 0; i < a->procs.count; i++) {
+      proc_activity_t *pa = a->procs.items[i];
+
+      fprintf(f, "%s\n    { \"name\": ", i > 0 ? "," : "");
+      json_string(f, istr(pa->proc->name));
+      fprintf(f, ", \"wakeups\": %"PRIu64", \"runs\": %"PRIu64", "
+              "\"time_ns\": %"PRIu64" }", pa->wakeups, pa->runs, pa->time_ns);
+   }
+
+   fprintf(f, "\n  ]\n}\n");
+   fclose(f);
+}
+
+static void print_activity_header(const char *title)
+{
+   printf("== %s ", title);
+   for (int pad = 74 - strlen(title); pad > 0; pad--)
+      fputc('=', stdout);
+   fputc('\n', stdout);
+}
+
+static void activity_report(rt_model_t *m)
+{
+   activity_t *a = m->activity;
+
+   qsort(a->nexuses.items, a->nexuses.count, sizeof(nexus_activity_t *),
+         nexus_activity_cmp);
+   qsort(a->procs.items, a->procs.count, sizeof(proc_activity_t *),
+         proc_activity_cmp);
+
+   LOCAL_TEXT_BUF tb = tb_new();
+
+   print_activity_header("Signal activity");
+   printf("%-46s %14s %14s\n", "Signal", "Events", "Transactions");
+
+   for (int i = 0; i < a->nexuses.count && i < ACTIVITY_TOP; i++) {
+      nexus_activity_t *na = a->nexuses.items[i];
+
+      tb_rewind(tb);
+      get_nexus_path(na->nexus, tb);
+
+      printf("%-46s %14"PRIu64" %14"PRIu64"\n", tb_get(tb), na->events,
+             na->transactions);
+   }
+
+   print_activity_header("Process activity");
+   printf("%-46s %9s %9s %10s\n", "Process", "Wakeups", "Runs", "Time (us)");
+
+   for (int i = 0; i < a->procs.count && i < ACTIVITY_TOP; i++) {
+      proc_activity_t *pa = a->procs.items[i];
+      printf("%-46s %9"PRIu64" %9"PRIu64" %10"PRIu64"\n",
+             istr(pa->proc->name), pa->wakeups, pa->runs, pa->time_ns / 1000);
+   }
+
+   fflush(stdout);
+
+   const char *fname = opt_get_str(OPT_PROFILE_ACTIVITY);
+   write_activity_json(m, fname);
+
+   notef("wrote activity profile for %d signals and %d processes to %s",
+         a->nexuses.count, a->procs.count, fname);
+}
+
+static void activity_free(activity_t *a)
+{
+   for (int i = 0; i < a->nexuses.count; i++)
+      free(a->nexuses.items[i]);
+
+   for (int i = 0; i < a->procs.count; i++)
+      free(a->procs.items[i]);
+
+   ACLEAR(a->nexuses);
+   ACLEAR(a->procs);
+   hash_free(a->nexus_map);
+   hash_free(a->proc_map);
+   free(a);
+}
+
 static void free_waveform(rt_model_t *m, waveform_t *w)
 {
    model_thread_t *thread = model_thread(m);
@@ -616,6 +842,19 @@ void model_free(rt_model_t *m)
 
       notef("setup:%ums run:%ums user:%ums sys:%ums maxrss:%ukB static:%ukB",
             m->ready_rusage.ms, ru.ms, ru.user, ru.sys, ru.rss, mem / 1024);
+
+      mspace_stats_t gc;
+      mspace_stats(m->mspace, &gc);
+
+      if (gc.collections > 0)
+         notef("gc:%u total:%ums pause p50:%uus p90:%uus p99:%uus max:%uus",
+               gc.collections, gc.total_us / 1000, gc.p50_us, gc.p90_us,
+               gc.p99_us, gc.max_us);
+   }
+
+   if (m->activity != NULL) {
+      activity_report(m);
+      activity_free(m->activity);
    }
 
    while (heap_size(m->eventq_heap) > 0) {
@@ -667,6 +906,13 @@ void model_free(rt_model_t *m)
    hash_free(m->scopes);
    ihash_free(m->res_memo);
    ACLEAR(m->eventsigs);
+
+   for (int i = 0; i < m->toggles.count; i++)
+      free(m->toggles.items[i]);
+
+   ACLEAR(m->toggles);
+   ACLEAR(m->toggleq);
+
    free(m);
 }
 
@@ -822,6 +1068,11 @@ const void *signal_value(rt_signal_t *s)
    return s->shared.data;
 }
 
+const uint32_t *signal_generation(rt_signal_t *s)
+{
+   return &(s->generation);
+}
+
 const void *signal_last_value(rt_signal_t *s)
 {
    return s->shared.data + s->shared.size;
@@ -1714,10 +1965,11 @@ static void setup_signal(rt_model_t *m, rt_signal_t *s, tree_t where,
 {
    rt_scope_t *parent = model_thread(m)->active_scope;
 
-   s->where   = where;
-   s->n_nexus = 1;
-   s->offset  = offset;
-   s->parent  = parent;
+   s->where      = where;
+   s->n_nexus    = 1;
+   s->offset     = offset;
+   s->parent     = parent;
+   s->generation = 0;
 
    s->shared.flags = flags;
    s->shared.size  = count * size;
@@ -2421,6 +2673,9 @@ void model_reset(rt_model_t *m)
    m->stop_delta = opt_get_int(OPT_STOP_DELTA);
    m->shuffle    = opt_get_int(OPT_SHUFFLE_PROCS);
 
+   if (opt_get_str(OPT_PROFILE_ACTIVITY) != NULL && m->activity == NULL)
+      m->activity = activity_new();
+
    __trace_on = opt_get_int(OPT_RT_TRACE);
 
    create_processes(m, m->root);
@@ -2768,6 +3023,18 @@ static void async_update_implicit_signal(rt_model_t *m, void *arg)
    update_implicit_signal(m, imp);
 }
 
+static void profile_process(rt_model_t *m, rt_proc_t *proc,
+                            void (*fn)(rt_model_t *, rt_proc_t *))
+{
+   proc_activity_t *pa = proc_activity(m, proc);
+   const uint64_t start = get_timestamp_ns();
+
+   (*fn)(m, proc);
+
+   pa->runs++;
+   pa->time_ns += get_timestamp_ns() - start;
+}
+
 static void async_run_process(rt_model_t *m, void *arg)
 {
    rt_proc_t *proc = arg;
@@ -2775,7 +3042,10 @@ static void async_run_process(rt_model_t *m, void *arg)
    assert(proc->wakeable.pending);
    proc->wakeable.pending = false;
 
-   run_process(m, proc);
+   if (unlikely(m->activity != NULL))
+      profile_process(m, proc, run_process);
+   else
+      run_process(m, proc);
 }
 
 static void async_update_property(rt_model_t *m, void *arg)
@@ -2938,6 +3208,9 @@ static void wakeup_one(rt_model_t *m, rt_wakeable_t *obj)
          TRACE("wakeup %sprocess %s", obj->postponed ? "postponed " : "",
                istr(proc->name));
 
+         if (unlikely(m->activity != NULL))
+            proc_activity(m, proc)->wakeups++;
+
          if (proc->wakeable.delayed) {
             // This process was already scheduled to run at a later
             // time so we need to delete it from the simulation queue
@@ -3009,14 +3282,29 @@ static void wakeup_one(rt_model_t *m, rt_wakeable_t *obj)
          rt_proc_t *proc = container_of(obj, rt_proc_t, wakeable);
          TRACE("wakeup continuous assignment %s", istr(proc->name));
 
+         if (unlikely(m->activity != NULL))
+            proc_activity(m, proc)->wakeups++;
+
          assert(!proc->wakeable.delayed);
 
-         if (m->blocking_update)
-            update_assignment(m, proc);
-         else {
+         if (!m->blocking_update) {
             deferq_do(&m->implicitq, async_run_process, proc);
             set_pending(obj);
          }
+         else if (unlikely(m->activity != NULL))
+            profile_process(m, proc, update_assignment);
+         else
+            update_assignment(m, proc);
+      }
+      break;
+
+   case W_TOGGLE:
+      {
+         // Toggle coverage for all signals with events is sampled
+         // together at the end of the cycle
+         rt_toggle_t *t = container_of(obj, rt_toggle_t, wakeable);
+         APUSH(m->toggleq, t);
+         set_pending(obj);
       }
       break;
    }
@@ -3041,6 +3329,10 @@ static void notify_event(rt_model_t *m, rt_nexus_t *n)
 {
    n->last_event = m->now;
    n->event_delta = m->iteration;
+   n->signal->generation++;
+
+   if (unlikely(m->activity != NULL))
+      nexus_activity(m, n)->events++;
 
    if (n->flags & NET_F_CACHE_EVENT)
       n->signal->shared.flags |= SIG_F_EVENT_FLAG;
@@ -3128,6 +3420,9 @@ static void update_driving(rt_model_t *m, rt_nexus_t *n, bool safe)
       n->active_delta = m->iteration;
       n->flags &= ~NET_F_PENDING;
 
+      if (unlikely(m->activity != NULL))
+         nexus_activity(m, n)->transactions++;
+
       calculate_driving_value(m, n);
 
       // Update outputs if the effective value must be calculated
@@ -3396,6 +3691,16 @@ static void sync_event_cache(rt_model_t *m)
    }
 }
 
+static void sample_toggles(rt_model_t *m)
+{
+   cover_sample_toggles(m, m->toggleq.items, m->toggleq.count);
+
+   for (int i = 0; i < m->toggleq.count; i++)
+      m->toggleq.items[i]->wakeable.pending = false;
+
+   ATRIM(m->toggleq, 0);
+}
+
 static void swap_deferq(deferq_t *a, deferq_t *b)
 {
    deferq_t tmp = *a;
@@ -3546,6 +3851,9 @@ static void model_cycle(rt_model_t *m)
    }
    else if (m->stop_delta > 0 && m->iteration == m->stop_delta)
       reached_iteration_limit(m);
+
+   if (m->toggleq.count > 0)
+      sample_toggles(m);
 }
 
 static bool should_stop_now(rt_model_t *m, uint64_t stop_time)
@@ -3827,6 +4135,22 @@ void watch_free(rt_model_t *m, rt_watch_t *w)
    should_not_reach_here();
 }
 
+rt_toggle_t *toggle_new(rt_model_t *m, rt_signal_t *s, int32_t *counters)
+{
+   rt_toggle_t *t = xcalloc(sizeof(rt_toggle_t));
+   t->wakeable.kind = W_TOGGLE;
+   t->signal        = s;
+   t->counters      = counters;
+
+   APUSH(m->toggles, t);
+
+   rt_nexus_t *n = &(s->nexus);
+   for (int i = 0; i < s->n_nexus; i++, n = n->chain)
+      sched_event(m, &(n->pending), &(t->wakeable));
+
+   return t;
+}
+
 rt_watch_t *model_set_event_cb(rt_model_t *m, rt_signal_t *s, rt_watch_t *w)
 {
    assert(!w->wakeable.zombie);
@@ -4838,12 +5162,21 @@ void x_deposit_signal(sig_shared_t *ss, uint32_t offset, int32_t count,
 
       const size_t valuesz = n->size * n->width;
 
+      // A deposit counts as a transaction and also as an event if the
+      // value changes, the same as an update through a driver
+      if (unlikely(m->activity != NULL))
+         nexus_activity(m, n)->transactions++;
+
       if (!cmp_bytes(eff, vptr, valuesz)) {
          copy2(last, eff, vptr, valuesz);
          m->trigger_epoch++;
 
          n->last_event = m->now;
          n->event_delta = m->iteration;
+         n->signal->generation++;
+
+         if (unlikely(m->activity != NULL))
+            nexus_activity(m, n)->events++;
 
          assert(!(n->flags & NET_F_CACHE_EVENT));
 
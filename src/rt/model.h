@@ -55,6 +55,8 @@ rt_watch_t *watch_new(rt_model_t *m, sig_event_fn_t fn, void *user,
                       watch_kind_t kind, unsigned slots);
 void watch_free(rt_model_t *m, rt_watch_t *w);
 
+rt_toggle_t *toggle_new(rt_model_t *m, rt_signal_t *s, int32_t *counters);
+
 void model_set_phase_cb(rt_model_t *m, model_phase_t phase, rt_event_fn_t fn,
                         void *user);
 rt_watch_t *model_set_event_cb(rt_model_t *m, rt_signal_t *s, rt_watch_t *w);
@@ -83,6 +85,7 @@ void get_path_name(rt_scope_t *s, text_buf_t *tb);
 
 const void *signal_value(rt_signal_t *s);
 const void *signal_last_value(rt_signal_t *s);
+const uint32_t *signal_generation(rt_signal_t *s);
 uint8_t signal_size(rt_signal_t *s);
 uint32_t signal_width(rt_signal_t *s);
 size_t signal_expand(rt_signal_t *s, uint64_t *buf, size_t max);
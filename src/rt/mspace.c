@@ -40,7 +40,28 @@
 
 STATIC_ASSERT(OVERRUN_MARGIN % LINE_SIZE == 0);
 
+// Each size class up to this many lines keeps its own search position
+// in the address-ordered list of free fragments
+#define NUM_CLASSES 32
+
+// Switch to parallel marking after tracing this many objects
+#define PARALLEL_MARK_MIN 10000
+
+// Number of objects moved between a marking thread and the shared pool
+#define MARK_CHUNK 256
+
+// Objects up to this many lines are served from per-thread caches
+#define CACHE_LINES 4
+#define CACHE_DEPTH 8
+
+// TLABs start at TLAB_SIZE and double up to this limit while short-lived
+// data keeps overflowing into the heap.  The buffer is always allocated
+// at the maximum size so it can grow in place: pages past the current
+// limit are never touched.
+#define TLAB_MAX_SIZE (1024 * 1024)
+
 typedef A(uint64_t) work_list_t;
+typedef A(uint32_t) pause_list_t;
 typedef struct _linked_tlab linked_tlab_t;
 
 typedef struct _linked_tlab {
@@ -67,13 +88,27 @@ typedef struct {
 #endif
 } gc_state_t;
 
-typedef struct _free_list free_list_t;
+typedef struct {
+   mspace_t    *mspace;
+   bit_mask_t  *markmask;
+   work_list_t  pool;
+   int          lock;
+   unsigned     size;
+   int          active;
+} mark_pool_t;
 
-struct _free_list {
-   free_list_t *next;
-   char        *ptr;
-   size_t       size;
-};
+typedef struct {
+   char   *ptr;
+   size_t  nlines;
+} free_frag_t;
+
+typedef A(free_frag_t) frag_list_t;
+
+typedef struct {
+   unsigned  epoch;
+   unsigned  count[CACHE_LINES];
+   char     *objs[CACHE_LINES][CACHE_DEPTH];
+} thread_cache_t;
 
 struct _mspace {
    nvc_lock_t       lock;
@@ -84,12 +119,18 @@ struct _mspace {
    mptr_t           roots;
    mptr_t           free_mptrs;
    mspace_oom_fn_t  oomfn;
-   free_list_t     *free_list;
+   frag_list_t      free;
+   unsigned         cursor[NUM_CLASSES];
+   unsigned         epoch;
+   thread_cache_t  *caches[MAX_THREADS];
    uint64_t         create_us;
    linked_tlab_t   *live_tlabs;
    linked_tlab_t   *free_tlabs;
+   size_t           tlab_size;
+   size_t           tlab_spill;
    unsigned         total_gc;
    unsigned         num_cycles;
+   pause_list_t     pauses;
 #ifdef DEBUG
    bool             stress;
 #endif
@@ -99,6 +140,7 @@ static intptr_t *stack_limit[MAX_THREADS];
 
 static void mspace_gc(mspace_t *m);
 static bool is_mspace_ptr(mspace_t *m, char *p);
+static void mspace_add_free(mspace_t *m, char *ptr, size_t nlines);
 
 mspace_t *mspace_new(size_t size)
 {
@@ -119,13 +161,9 @@ mspace_t *mspace_new(size_t size)
    mask_init(&(m->headmask), m->maxlines);
    mask_setall(&(m->headmask));
 
-   free_list_t *f = xmalloc(sizeof(free_list_t));
-   f->next = NULL;
-   f->ptr  = m->space;
-   f->size = m->maxsize - OVERRUN_MARGIN;
-
-   m->free_list = f;
+   mspace_add_free(m, m->space, m->maxlines);
 
+   m->tlab_size = TLAB_SIZE;
    m->create_us = get_timestamp_us();
    return m;
 }
@@ -155,10 +193,11 @@ void mspace_destroy(mspace_t *m)
              "run time", m->num_cycles, m->total_gc, gc_frac * 100.0);
    }
 
-   for (free_list_t *it = m->free_list, *tmp; it; it = tmp) {
-      tmp = it->next;
-      free(it);
-   }
+   ACLEAR(m->free);
+   ACLEAR(m->pauses);
+
+   for (int i = 0; i < MAX_THREADS; i++)
+      free(m->caches[i]);
 
    for (mptr_t p = m->free_mptrs, tmp; p; p = tmp) {
       tmp = p->next;
@@ -176,49 +215,124 @@ void mspace_stack_limit(void *limit)
    atomic_store(&(stack_limit[thread_id()]), limit);
 }
 
-static void *mspace_try_alloc(mspace_t *m, size_t size)
+static void mspace_add_free(mspace_t *m, char *ptr, size_t nlines)
 {
-   // Add one to size before rounding up to LINE_SIZE to allow a valid
-   // pointer to point at one element past the end of an array
-   const size_t nlines = (size + LINE_SIZE) / LINE_SIZE;
-   const size_t asize = nlines * LINE_SIZE;
+   const free_frag_t f = { ptr, nlines };
+   APUSH(m->free, f);
+}
 
-   SCOPED_LOCK(m->lock);
+static char *mspace_take_free(mspace_t *m, size_t nlines)
+{
+   // Fragments only ever shrink between collections so all fragments
+   // before the cursor for a size class are too small for any request
+   // in that class and never need to be visited again
+   const int class = MIN(nlines, NUM_CLASSES - 1);
+
+   unsigned i = m->cursor[class];
+   while (i < m->free.count && m->free.items[i].nlines < class)
+      i++;
+   m->cursor[class] = i;
+
+   for (; i < m->free.count; i++) {
+      free_frag_t *f = &(m->free.items[i]);
+      if (f->nlines >= nlines) {
+         char *base = f->ptr;
+         f->ptr += nlines * LINE_SIZE;
+         f->nlines -= nlines;
+         return base;
+      }
+   }
 
-   for (free_list_t **it = &(m->free_list); *it; it = &((*it)->next)) {
-      assert((*it)->size % LINE_SIZE == 0);
-      if ((*it)->size >= asize) {
-         char *base = (*it)->ptr;
-         assert((uintptr_t)base % LINE_SIZE == 0);
-         assert(base >= m->space);
-         assert(base < m->space + m->maxsize);
-
-         ASAN_UNPOISON(base, size);
-
-         const ptrdiff_t line = (base - m->space) / LINE_SIZE;
-         mask_set(&(m->headmask), line);
-         if (nlines > 1)
-            mask_clear_range(&(m->headmask), line + 1, nlines - 1);
-
-         if ((*it)->size == asize) {
-            free_list_t *next = (*it)->next;
-            free(*it);
-            *it = next;
-         }
-         else {
-            (*it)->size -= asize;
-            (*it)->ptr += asize;
-         }
+   return NULL;
+}
+
+static char *mspace_carve(mspace_t *m, size_t nlines)
+{
+   char *base = mspace_take_free(m, nlines);
+   if (base == NULL)
+      return NULL;
+
+   assert(base >= m->space);
+   assert(base < m->space + m->maxsize);
 
-         // Make sure the first fault to the page is a write to
-         // allocate THP on Linux
-         *(volatile char *)base = 0;
+   const ptrdiff_t line = (base - m->space) / LINE_SIZE;
+   mask_set(&(m->headmask), line);
+   if (nlines > 1)
+      mask_clear_range(&(m->headmask), line + 1, nlines - 1);
 
+   // Make sure the first fault to the page is a write to allocate THP
+   // on Linux
+   ASAN_UNPOISON(base, 1);
+   *(volatile char *)base = 0;
+
+   return base;
+}
+
+static char *mspace_cache_alloc(mspace_t *m, size_t nlines)
+{
+   const int tid = thread_id();
+   thread_cache_t *tc = m->caches[tid];
+   unsigned *count = tc ? &(tc->count[nlines - 1]) : NULL;
+
+   if (count != NULL && *count > 0) {
+      // Cached objects are not roots and so are swept by any collection
+      // after the cache was filled: the epoch must be checked after
+      // taking the pointer which keeps it alive from then on
+      char *base = tc->objs[nlines - 1][--(*count)];
+      if (atomic_load(&(m->epoch)) == tc->epoch)
          return base;
-      }
    }
 
-   return NULL;
+   SCOPED_LOCK(m->lock);
+
+   if (tc == NULL) {
+      tc = m->caches[tid] = xcalloc(sizeof(thread_cache_t));
+      count = &(tc->count[nlines - 1]);
+   }
+
+   if (tc->epoch != m->epoch) {
+      memset(tc->count, '\0', sizeof(tc->count));
+      tc->epoch = m->epoch;
+   }
+
+   assert(*count == 0);
+
+   char *batch[CACHE_DEPTH + 1];
+   int nbatch = 0;
+   while (nbatch < ARRAY_LEN(batch)) {
+      if ((batch[nbatch] = mspace_carve(m, nlines)) == NULL)
+         break;
+      nbatch++;
+   }
+
+   if (nbatch == 0)
+      return NULL;
+
+   // Push in reverse so objects are handed out in address order
+   for (int i = nbatch - 1; i > 0; i--)
+      tc->objs[nlines - 1][(*count)++] = batch[i];
+
+   return batch[0];
+}
+
+static void *mspace_try_alloc(mspace_t *m, size_t size)
+{
+   // Add one to size before rounding up to LINE_SIZE to allow a valid
+   // pointer to point at one element past the end of an array
+   const size_t nlines = (size + LINE_SIZE) / LINE_SIZE;
+
+   char *base;
+   if (nlines <= CACHE_LINES)
+      base = mspace_cache_alloc(m, nlines);
+   else {
+      SCOPED_LOCK(m->lock);
+      base = mspace_carve(m, nlines);
+   }
+
+   if (base != NULL)
+      ASAN_UNPOISON(base, size);
+
+   return base;
 }
 
 void *mspace_alloc(mspace_t *m, size_t size)
@@ -341,7 +455,7 @@ tlab_t *tlab_acquire(mspace_t *m)
 
    linked_tlab_t *lt = m->free_tlabs;
    if (lt == NULL) {
-      lt = xmalloc(sizeof(linked_tlab_t) + TLAB_SIZE);
+      lt = xmalloc(sizeof(linked_tlab_t) + TLAB_MAX_SIZE);
       lt->tlab.mspace = m;
    }
    else {
@@ -363,7 +477,7 @@ tlab_t *tlab_acquire(mspace_t *m)
    // Ensure proper starting alignment on 32-bit systems
    const size_t data_off = offsetof(tlab_t, data);
    lt->tlab.alloc = ALIGN_UP(data_off, sizeof(double)) - data_off;
-   lt->tlab.limit = TLAB_SIZE - OVERRUN_MARGIN;
+   lt->tlab.limit = m->tlab_size - OVERRUN_MARGIN;
 
    return &(lt->tlab);
 }
@@ -403,7 +517,7 @@ void *tlab_alloc(tlab_t *t, size_t size)
    assert(t->alloc <= t->limit);
    assert((t->alloc & (sizeof(double) - 1)) == 0);
 
-   if (t->alloc + size <= t->limit) {
+   if (t->alloc + size <= t->limit || tlab_overflow(t, size)) {
       void *p = t->data + t->alloc;
       t->alloc += ALIGN_UP(size, sizeof(double));
       return p;
@@ -412,27 +526,59 @@ void *tlab_alloc(tlab_t *t, size_t size)
       return mspace_alloc(t->mspace, size);
 }
 
+bool tlab_overflow(tlab_t *t, size_t size)
+{
+   // The null TLAB used during initialisation has no space and
+   // everything allocated through it is expected to be long-lived
+   if (t->limit == 0)
+      return false;
+
+   // Extend the TLAB in place if the size grew since it was acquired
+   const size_t size_now = relaxed_load(&(t->mspace->tlab_size));
+   const uint32_t limit = size_now - OVERRUN_MARGIN;
+   if (limit > t->limit) {
+      t->limit = limit;
+      if (t->alloc + size <= limit)
+         return true;
+   }
+
+   atomic_add(&(t->mspace->tlab_spill), size);
+   return false;
+}
+
 __attribute__((always_inline))
 static inline bool is_mspace_ptr(mspace_t *m, char *p)
 {
    return p >= m->space && p < m->space + m->maxsize;
 }
 
-static void mspace_mark_root(mspace_t *m, intptr_t p, gc_state_t *state)
+static inline bool mspace_find_object(mspace_t *m, intptr_t p,
+                                      uint32_t *line, uint32_t *objlen)
 {
-   if (is_mspace_ptr(m, (char *)p)) {
-      ptrdiff_t line = ((char *)p - m->space) / LINE_SIZE;
-      assert(line < UINT32_MAX);   // Enforced by MAX_HEAP
+   if (!is_mspace_ptr(m, (char *)p))
+      return false;
 
-      // Scan backwards to the start of the object
-      line = mask_scan_backwards(&(m->headmask), line);
-      assert(line != -1);
+   ptrdiff_t l = ((char *)p - m->space) / LINE_SIZE;
+   assert(l < UINT32_MAX);   // Enforced by MAX_HEAP
 
-      size_t objlen = 1;
-      if (line + 1 < m->maxlines)
-         objlen += mask_count_clear(&(m->headmask), line + 1);
-      assert(objlen < UINT32_MAX);
+   // Scan backwards to the start of the object
+   l = mask_scan_backwards(&(m->headmask), l);
+   assert(l != -1);
 
+   size_t len = 1;
+   if (l + 1 < m->maxlines)
+      len += mask_count_clear(&(m->headmask), l + 1);
+   assert(len < UINT32_MAX);
+
+   *line = l;
+   *objlen = len;
+   return true;
+}
+
+static void mspace_mark_root(mspace_t *m, intptr_t p, gc_state_t *state)
+{
+   uint32_t line, objlen;
+   if (mspace_find_object(m, p, &line, &objlen)) {
       if (!mask_test(&(state->markmask), line)) {
          mask_set_range(&(state->markmask), line, objlen);
 
@@ -442,6 +588,131 @@ static void mspace_mark_root(mspace_t *m, intptr_t p, gc_state_t *state)
    }
 }
 
+static void mark_pool_lock(mark_pool_t *mp)
+{
+   while (atomic_xchg(&(mp->lock), 1))
+      spin_wait();
+}
+
+static void mark_pool_unlock(mark_pool_t *mp)
+{
+   store_release(&(mp->lock), 0);
+}
+
+static void mark_pool_give(mark_pool_t *mp, work_list_t *stack)
+{
+   // Share the oldest entries which are likely to lead to the largest
+   // amount of further work
+   const int n = MIN(stack->count / 2, MARK_CHUNK);
+
+   mark_pool_lock(mp);
+   {
+      for (int i = 0; i < n; i++)
+         APUSH(mp->pool, stack->items[i]);
+
+      relaxed_store(&(mp->size), mp->pool.count);
+   }
+   mark_pool_unlock(mp);
+
+   memmove(stack->items, stack->items + n,
+           (stack->count - n) * sizeof(uint64_t));
+   ATRIM(*stack, stack->count - n);
+}
+
+static bool mark_pool_take(mark_pool_t *mp, work_list_t *stack)
+{
+   if (relaxed_load(&(mp->size)) == 0)
+      return false;
+
+   int n;
+   mark_pool_lock(mp);
+   {
+      n = MIN(mp->pool.count, MARK_CHUNK);
+      for (int i = 0; i < n; i++)
+         APUSH(*stack, APOP(mp->pool));
+
+      relaxed_store(&(mp->size), mp->pool.count);
+   }
+   mark_pool_unlock(mp);
+
+   return n > 0;
+}
+
+__attribute__((no_sanitize_address))
+static void mspace_mark_worker(int id, int count, void *arg)
+{
+   mark_pool_t *mp = arg;
+   mspace_t *m = mp->mspace;
+
+   work_list_t stack = AINIT;
+
+   atomic_add(&(mp->active), 1);
+
+   for (;;) {
+      while (stack.count > 0) {
+         const uint64_t enc = APOP(stack);
+         const uint32_t line = enc >> 32;
+         const uint32_t objlen = enc & 0xffffffff;
+
+         for (size_t i = 0; i < objlen; i++) {
+            const ptrdiff_t off = (uintptr_t)(line + i) * LINE_SIZE;
+            intptr_t *words = (intptr_t *)(m->space + off);
+            for (int j = 0; j < LINE_WORDS; j++) {
+               uint32_t l, len;
+               if (!mspace_find_object(m, words[j], &l, &len))
+                  continue;
+               else if (mask_atomic_test_and_set_range(mp->markmask, l, len))
+                  continue;
+
+               APUSH(stack, ((uint64_t)l << 32) | len);
+            }
+         }
+
+         if (stack.count >= 2 * MARK_CHUNK && relaxed_load(&(mp->size)) == 0)
+            mark_pool_give(mp, &stack);
+      }
+
+      if (mark_pool_take(mp, &stack))
+         continue;
+
+      // Marking is complete once every thread is idle and the pool is
+      // empty as only active threads add to the pool
+      atomic_add(&(mp->active), -1);
+
+      for (;;) {
+         if (relaxed_load(&(mp->size)) > 0) {
+            atomic_add(&(mp->active), 1);
+            if (mark_pool_take(mp, &stack))
+               break;
+            atomic_add(&(mp->active), -1);
+         }
+         else if (atomic_load(&(mp->active)) == 0) {
+            ACLEAR(stack);
+            return;
+         }
+         else
+            spin_wait();
+      }
+   }
+}
+
+static void mspace_parallel_mark(mspace_t *m, gc_state_t *state)
+{
+   mark_pool_t mp = {
+      .mspace   = m,
+      .markmask = &(state->markmask),
+      .pool     = state->worklist,
+      .size     = state->worklist.count,
+   };
+
+   stop_world_parallel(MAX_THREADS, mspace_mark_worker, &mp);
+
+   assert(mp.pool.count == 0);
+   assert(mp.active == 0);
+
+   state->worklist = mp.pool;
+}
+
 static void mspace_suspend_cb(int thread_id, struct cpu_state *cpu, void *arg)
 {
    gc_state_t *state = arg;
@@ -515,7 +786,14 @@ static void mspace_gc(mspace_t *m)
          mspace_mark_root(m, *(intptr_t *)p, &state);
    }
 
-   while (state.worklist.count > 0) {
+   // Trace on this thread until it is clear the live heap is large
+   // enough to be worth distributing across helper threads
+   for (int budget = PARALLEL_MARK_MIN; state.worklist.count > 0; budget--) {
+      if (budget == 0) {
+         mspace_parallel_mark(m, &state);
+         break;
+      }
+
       const uint64_t enc = APOP(state.worklist);
       const uint32_t line = enc >> 32;
       const uint32_t objlen = enc & 0xffffffff;
@@ -535,27 +813,20 @@ static void mspace_gc(mspace_t *m)
    }
 #endif
 
-   for (free_list_t *it = m->free_list, *tmp; it; it = tmp) {
-      tmp = it->next;
-      free(it);
-   }
-   m->free_list = NULL;
+   ATRIM(m->free, 0);
+   memset(m->cursor, '\0', sizeof(m->cursor));
+
+   // Invalidate all per-thread caches as they may contain unmarked
+   // objects which are now on the free lists
+   atomic_add(&(m->epoch), 1);
 
    int freefrags = 0, freelines = 0;
-   free_list_t **tail = &(m->free_list);
    for (size_t line = 0; line < m->maxlines;) {
       const size_t clear = mask_count_clear(&(state.markmask), line);
       if (clear == 0)
          line++;
       else {
-         free_list_t *f = xmalloc(sizeof(free_list_t));
-         f->next = NULL;
-         f->ptr  = m->space + line * LINE_SIZE;
-         f->size = clear * LINE_SIZE;
-
-         *tail = f;
-         tail = &(f->next);
-
+         mspace_add_free(m, m->space + line * LINE_SIZE, clear);
          mask_set_range(&(m->headmask), line, clear);
 
          freefrags++;
@@ -565,17 +836,29 @@ static void mspace_gc(mspace_t *m)
       }
    }
 
+   // If more than a TLAB worth of data overflowed into the heap since
+   // the last collection and most of the heap turned out to be garbage
+   // then grow the TLABs so that these temporaries are reclaimed when
+   // the TLAB is reset rather than by a full collection
+   if (m->tlab_spill > m->tlab_size && freelines > m->maxlines / 2
+       && m->tlab_size < TLAB_MAX_SIZE)
+      m->tlab_size *= 2;
+
+   m->tlab_spill = 0;
+
    start_world();
 
-   if (opt_get_verbose(OPT_GC_VERBOSE, NULL)) {
-      const int ticks = get_timestamp_us() - start_ticks;
-      debugf("GC: allocated %zd/%zu; fragmentation %.2g%% [%d us]",
-             mask_popcount(&(state.markmask)) * LINE_SIZE, m->maxsize,
-             ((double)(freefrags - 1) / (double)freelines) * 100.0, ticks);
+   const int ticks = get_timestamp_us() - start_ticks;
+   APUSH(m->pauses, ticks);
 
-      m->total_gc += ticks;
-      m->num_cycles++;
-   }
+   m->total_gc += ticks;
+   m->num_cycles++;
+
+   if (opt_get_verbose(OPT_GC_VERBOSE, NULL))
+      debugf("GC: allocated %zd/%zu; fragmentation %.2g%%; TLAB size %zuk "
+             "[%d us]", mask_popcount(&(state.markmask)) * LINE_SIZE,
+             m->maxsize, ((double)(freefrags - 1) / (double)freelines) * 100.0,
+             m->tlab_size / 1024, ticks);
 
    mask_free(&(state.markmask));
 
@@ -603,3 +886,34 @@ void *mspace_find(mspace_t *m, void *ptr, size_t *size)
    *size = objlen * LINE_SIZE;
    return m->space + line * LINE_SIZE;
 }
+
+static int pause_cmp(const void *a, const void *b)
+{
+   const uint32_t pa = *(const uint32_t *)a, pb = *(const uint32_t *)b;
+   return (pa > pb) - (pa < pb);
+}
+
+void mspace_stats(mspace_t *m, mspace_stats_t *stats)
+{
+   SCOPED_LOCK(m->lock);
+
+   const int n = m->pauses.count;
+
+   stats->collections = n;
+   stats->total_us    = m->total_gc;
+
+   if (n == 0) {
+      stats->p50_us = stats->p90_us = stats->p99_us = stats->max_us = 0;
+      return;
+   }
+
+   uint32_t *sorted LOCAL = xmalloc_array(n, sizeof(uint32_t));
+   memcpy(sorted, m->pauses.items, n * sizeof(uint32_t));
+   qsort(sorted, n, sizeof(uint32_t), pause_cmp);
+
+   // Nearest-rank percentiles
+   stats->p50_us = sorted[(n * 50 + 99) / 100 - 1];
+   stats->p90_us = sorted[(n * 90 + 99) / 100 - 1];
+   stats->p99_us = sorted[(n * 99 + 99) / 100 - 1];
+   stats->max_us = sorted[n - 1];
+}
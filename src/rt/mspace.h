@@ -27,6 +27,15 @@ typedef void *UNSAFE_MPTR;
 
 typedef void (*mspace_oom_fn_t)(mspace_t *, size_t);
 
+typedef struct {
+   unsigned collections;
+   unsigned total_us;
+   unsigned p50_us;
+   unsigned p90_us;
+   unsigned p99_us;
+   unsigned max_us;
+} mspace_stats_t;
+
 #define TLAB_SIZE (64 * 1024)
 
 // The code generator knows the layout of this struct
@@ -56,10 +65,12 @@ void *mspace_alloc_array(mspace_t *m, int nelems, size_t size);
 void *mspace_alloc_flex(mspace_t *m, size_t fixed, int nelems, size_t size);
 void mspace_set_oom_handler(mspace_t *m, mspace_oom_fn_t fn);
 void *mspace_find(mspace_t *m, void *ptr, size_t *size);
+void mspace_stats(mspace_t *m, mspace_stats_t *stats);
 
 tlab_t *tlab_acquire(mspace_t *m);
 void tlab_release(tlab_t *t);
 void *tlab_alloc(tlab_t *t, size_t size);
+bool tlab_overflow(tlab_t *t, size_t size);
 
 mptr_t mptr_new(mspace_t *m, const char *name);
 void mptr_free(mspace_t *m, mptr_t *ptr);
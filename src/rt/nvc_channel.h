@@ -0,0 +1,128 @@
+//
+//  Copyright (C) 2025  Nick Gasson
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+//
+// Shared memory channel between a VHDL process using the NVC.CHANNEL
+// package and a foreign model in C or C++, possibly running in another
+// process.  The channel is a file mapped by both sides containing this
+// header followed by two single-producer single-consumer rings of
+// fixed size slots.  Each slot holds a word count followed by up to
+// WIDTH 32-bit words of payload.
+//
+// CHANNEL_SEND and CHANNEL_RECV wait on the simulation thread for the
+// model to make progress, so a model serviced by that same thread, for
+// example from a VHPI callback at the end of each time step, must only
+// be used with CHANNEL_TRY_SEND and CHANNEL_TRY_RECV.
+//
+
+#ifndef _NVC_CHANNEL_H
+#define _NVC_CHANNEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define NVC_CHANNEL_MAGIC   0x5156434e   // "NCVQ"
+#define NVC_CHANNEL_VERSION 1
+
+typedef enum {
+   NVC_CHANNEL_TO_MODEL,   // Written by the simulator
+   NVC_CHANNEL_TO_SIM,     // Written by the foreign model
+} nvc_channel_dir_t;
+
+typedef struct {
+   // Head and tail are free-running counters on separate cache lines
+   // so the producer and consumer do not contend
+   uint32_t head __attribute__((aligned(64)));   // Next slot to read
+   uint32_t tail __attribute__((aligned(64)));   // Next slot to write
+} nvc_ring_t;
+
+typedef struct {
+   uint32_t   magic;     // Set last once the channel is initialised
+   uint32_t   version;
+   uint32_t   depth;     // Slots in each ring, a power of two
+   uint32_t   width;     // Maximum payload words in each slot
+   nvc_ring_t rings[2];
+} nvc_channel_t;
+
+static inline size_t nvc_channel_size(uint32_t depth, uint32_t width)
+{
+   return sizeof(nvc_channel_t) + 2 * (size_t)depth * (width + 1) * 4;
+}
+
+static inline bool nvc_channel_valid(const nvc_channel_t *ch)
+{
+   return __atomic_load_n(&ch->magic, __ATOMIC_ACQUIRE) == NVC_CHANNEL_MAGIC
+      && ch->version == NVC_CHANNEL_VERSION;
+}
+
+static inline uint32_t *nvc_channel_slot(nvc_channel_t *ch,
+                                         nvc_channel_dir_t dir,
+                                         uint32_t index)
+{
+   uint32_t *data = (uint32_t *)(ch + 1);
+   const size_t slot = (size_t)dir * ch->depth + (index & (ch->depth - 1));
+   return data + slot * (ch->width + 1);
+}
+
+// Copy COUNT words into the next free slot, returning false if the ring
+// is full or the message is too large
+static inline bool nvc_channel_push(nvc_channel_t *ch, nvc_channel_dir_t dir,
+                                    const int32_t *words, uint32_t count)
+{
+   nvc_ring_t *r = &(ch->rings[dir]);
+
+   const uint32_t tail = r->tail;
+   if (count > ch->width)
+      return false;
+   else if (tail - __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == ch->depth)
+      return false;
+
+   uint32_t *slot = nvc_channel_slot(ch, dir, tail);
+   slot[0] = count;
+   memcpy(slot + 1, words, count * 4);
+
+   __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+   return true;
+}
+
+// Return a pointer to the payload of the oldest message without copying
+// it or NULL if the ring is empty: the slot remains valid until the
+// consumer calls nvc_channel_release
+static inline const int32_t *nvc_channel_front(nvc_channel_t *ch,
+                                               nvc_channel_dir_t dir,
+                                               uint32_t *count)
+{
+   nvc_ring_t *r = &(ch->rings[dir]);
+
+   const uint32_t head = r->head;
+   if (head == __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE))
+      return NULL;
+
+   const uint32_t *slot = nvc_channel_slot(ch, dir, head);
+   *count = slot[0];
+   return (const int32_t *)(slot + 1);
+}
+
+static inline void nvc_channel_release(nvc_channel_t *ch,
+                                       nvc_channel_dir_t dir)
+{
+   nvc_ring_t *r = &(ch->rings[dir]);
+   __atomic_store_n(&r->head, r->head + 1, __ATOMIC_RELEASE);
+}
+
+#endif  // _NVC_CHANNEL_H
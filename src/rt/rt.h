@@ -22,7 +22,7 @@
 
 #include <stdint.h>
 
-#define RT_ABI_VERSION   31
+#define RT_ABI_VERSION   32
 #define RT_ALIGN_MASK    0x7
 #define RT_MULTITHREADED 0
 
@@ -79,5 +79,8 @@ void _std_env_init(void);
 void _std_reflection_init(void);
 void _file_io_init(void);
 void _nvc_sim_pkg_init(void);
+void _nvc_channel_init(void);
+
+void cover_sample_toggles(rt_model_t *m, rt_toggle_t **toggles, unsigned count);
 
 #endif  // _RT_H
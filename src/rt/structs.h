@@ -34,9 +34,11 @@ typedef A(rt_prop_t *) prop_list_t;
 typedef A(rt_signal_t *) signal_list_t;
 typedef A(rt_proc_t *) proc_list_t;
 typedef A(rt_alias_t *) alias_list_t;
+typedef A(rt_toggle_t *) toggle_list_t;
 
 typedef enum {
    W_PROC, W_WATCH, W_IMPLICIT, W_PROPERTY, W_TRANSFER, W_TRIGGER, W_ASSIGN,
+   W_TOGGLE,
 } wakeable_kind_t;
 
 typedef uint32_t wakeup_gen_t;
@@ -220,6 +222,7 @@ typedef struct _rt_signal {
    nvc_lock_t    lock;
    uint32_t      offset;
    uint32_t      n_nexus;
+   uint32_t      generation;
    rt_nexus_t    nexus;
    sig_shared_t  shared;
 } rt_signal_t;
@@ -243,6 +246,12 @@ typedef struct {
    unsigned       count;
 } rt_transfer_t;
 
+typedef struct _rt_toggle {
+   rt_wakeable_t  wakeable;
+   rt_signal_t   *signal;
+   int32_t       *counters;
+} rt_toggle_t;
+
 typedef struct _rt_alias {
    rt_alias_t  *chain;
    tree_t       where;
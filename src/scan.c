@@ -17,6 +17,7 @@
 
 #include "util.h"
 #include "array.h"
+#include "common.h"
 #include "diag.h"
 #include "ident.h"
 #include "option.h"
@@ -31,6 +32,13 @@
 #include <stdarg.h>
 #include <stdlib.h>
 
+#ifdef ARCH_X86_64
+#include <x86intrin.h>
+#endif
+
+#define FAST_MAX_IDENT 128
+#define FAST_READ_MAX  512
+
 typedef struct {
    bool  result;
    bool  taken;
@@ -64,6 +72,134 @@ typedef struct {
 
 typedef A(input_buf_t) buf_stack_t;
 
+typedef struct {
+   bool        enabled;
+   bool        flex_owns;
+   bool        preserve_case;
+   const char *pos;
+   const char *end;
+   const char *linestart;
+   const char *synced;
+   int         lineno;
+   int         last_token;
+} fast_scan_t;
+
+typedef struct {
+   const char      *text;
+   token_t          token;
+   vhdl_standard_t  std;
+} keyword_t;
+
+static const keyword_t vhdl_keywords[] = {
+   { "ABS",           tABS,           STD_87 },
+   { "ACCESS",        tACCESS,        STD_87 },
+   { "AFTER",         tAFTER,         STD_87 },
+   { "ALIAS",         tALIAS,         STD_87 },
+   { "ALL",           tALL,           STD_87 },
+   { "AND",           tAND,           STD_87 },
+   { "ARCHITECTURE",  tARCHITECTURE,  STD_87 },
+   { "ARRAY",         tARRAY,         STD_87 },
+   { "ASSERT",        tASSERT,        STD_87 },
+   { "ATTRIBUTE",     tATTRIBUTE,     STD_87 },
+   { "BEGIN",         tBEGIN,         STD_87 },
+   { "BLOCK",         tBLOCK,         STD_87 },
+   { "BODY",          tBODY,          STD_87 },
+   { "BUFFER",        tBUFFER,        STD_87 },
+   { "BUS",           tBUS,           STD_87 },
+   { "CASE",          tCASE,          STD_87 },
+   { "COMPONENT",     tCOMPONENT,     STD_87 },
+   { "CONFIGURATION", tCONFIGURATION, STD_87 },
+   { "CONSTANT",      tCONSTANT,      STD_87 },
+   { "CONTEXT",       tCONTEXT,       STD_08 },
+   { "COVER",         tCOVER,         STD_08 },
+   { "DEFAULT",       tDEFAULT,       STD_08 },
+   { "DISCONNECT",    tDISCONNECT,    STD_87 },
+   { "DOWNTO",        tDOWNTO,        STD_87 },
+   { "ELSE",          tELSE,          STD_87 },
+   { "ELSIF",         tELSIF,         STD_87 },
+   { "END",           tEND,           STD_87 },
+   { "ENTITY",        tENTITY,        STD_87 },
+   { "EXIT",          tEXIT,          STD_87 },
+   { "FILE",          tFILE,          STD_87 },
+   { "FOR",           tFOR,           STD_87 },
+   { "FORCE",         tFORCE,         STD_08 },
+   { "FUNCTION",      tFUNCTION,      STD_87 },
+   { "GENERATE",      tGENERATE,      STD_87 },
+   { "GENERIC",       tGENERIC,       STD_87 },
+   { "GROUP",         tGROUP,         STD_87 },
+   { "GUARDED",       tGUARDED,       STD_87 },
+   { "IF",            tIF,            STD_87 },
+   { "IMPURE",        tIMPURE,        STD_87 },
+   { "IN",            tIN,            STD_87 },
+   { "INERTIAL",      tINERTIAL,      STD_87 },
+   { "INOUT",         tINOUT,         STD_87 },
+   { "IS",            tIS,            STD_87 },
+   { "LABEL",         tLABEL,         STD_87 },
+   { "LIBRARY",       tLIBRARY,       STD_87 },
+   { "LINKAGE",       tLINKAGE,       STD_87 },
+   { "LITERAL",       tLITERAL,       STD_87 },
+   { "LOOP",          tLOOP,          STD_87 },
+   { "MAP",           tMAP,           STD_87 },
+   { "MOD",           tMOD,           STD_87 },
+   { "NAND",          tNAND,          STD_87 },
+   { "NEW",           tNEW,           STD_87 },
+   { "NEXT",          tNEXT,          STD_87 },
+   { "NOR",           tNOR,           STD_87 },
+   { "NOT",           tNOT,           STD_87 },
+   { "NULL",          tNULL,          STD_87 },
+   { "OF",            tOF,            STD_87 },
+   { "ON",            tON,            STD_87 },
+   { "OPEN",          tOPEN,          STD_87 },
+   { "OR",            tOR,            STD_87 },
+   { "OTHERS",        tOTHERS,        STD_87 },
+   { "OUT",           tOUT,           STD_87 },
+   { "PACKAGE",       tPACKAGE,       STD_87 },
+   { "PARAMETER",     tPARAMETER,     STD_08 },
+   { "PORT",          tPORT,          STD_87 },
+   { "POSTPONED",     tPOSTPONED,     STD_87 },
+   { "PRIVATE",       tPRIVATE,       STD_19 },
+   { "PROCEDURE",     tPROCEDURE,     STD_87 },
+   { "PROCESS",       tPROCESS,       STD_87 },
+   { "PROTECTED",     tPROTECTED,     STD_00 },
+   { "PURE",          tPURE,          STD_87 },
+   { "RANGE",         tRANGE,         STD_87 },
+   { "RECORD",        tRECORD,        STD_87 },
+   { "REGISTER",      tREGISTER,      STD_87 },
+   { "REJECT",        tREJECT,        STD_87 },
+   { "RELEASE",       tRELEASE,       STD_08 },
+   { "REM",           tREM,           STD_87 },
+   { "REPORT",        tREPORT,        STD_87 },
+   { "RETURN",        tRETURN,        STD_87 },
+   { "REVERSE_RANGE", tREVRANGE,      STD_87 },
+   { "ROL",           tROL,           STD_87 },
+   { "ROR",           tROR,           STD_87 },
+   { "SELECT",        tSELECT,        STD_87 },
+   { "SEVERITY",      tSEVERITY,      STD_87 },
+   { "SHARED",        tSHARED,        STD_87 },
+   { "SIGNAL",        tSIGNAL,        STD_87 },
+   { "SLA",           tSLA,           STD_87 },
+   { "SLL",           tSLL,           STD_87 },
+   { "SRA",           tSRA,           STD_87 },
+   { "SRL",           tSRL,           STD_87 },
+   { "SUBTYPE",       tSUBTYPE,       STD_87 },
+   { "THEN",          tTHEN,          STD_87 },
+   { "TO",            tTO,            STD_87 },
+   { "TRANSPORT",     tTRANSPORT,     STD_87 },
+   { "TYPE",          tTYPE,          STD_87 },
+   { "UNAFFECTED",    tUNAFFECTED,    STD_87 },
+   { "UNITS",         tUNITS,         STD_87 },
+   { "UNTIL",         tUNTIL,         STD_87 },
+   { "USE",           tUSE,           STD_87 },
+   { "VARIABLE",      tVARIABLE,      STD_87 },
+   { "VIEW",          tVIEW,          STD_19 },
+   { "WAIT",          tWAIT,          STD_87 },
+   { "WHEN",          tWHEN,          STD_87 },
+   { "WHILE",         tWHILE,         STD_87 },
+   { "WITH",          tWITH,          STD_87 },
+   { "XNOR",          tXNOR,          STD_87 },
+   { "XOR",           tXOR,           STD_87 },
+};
+
 static input_buf_t       input_buf;
 static buf_stack_t       buf_stack;
 static hdl_kind_t        src_kind;
@@ -74,13 +210,21 @@ static macro_stack_t     macro_stack;
 static vlog_version_t    default_keywords = VLOG_1800_2023;
 static keywords_stack_t  keywords_stack;
 static string_list_t     include_dirs;
+static fast_scan_t       fast;
+static hash_t           *fast_keywords;
 
 extern int yylex(void);
 
 extern void reset_scanner(void);
+extern void resume_scanner(int token, bool at_bol);
+extern bool scanner_in_initial(void);
+extern int scanner_unread(void);
+extern int scanner_last_token(void);
 
 static bool pp_cond_analysis_expr(void);
 static void pp_defines_init(void);
+static void fast_init_keywords(void);
+static void fast_to_flex(void);
 
 yylval_t yylval;
 loc_t yylloc;
@@ -105,6 +249,14 @@ void input_from_buffer(const char *buf, size_t len, file_ref_t file_ref,
    src_kind = kind;
    pperrors = 0;
 
+   fast.enabled       = (kind == SOURCE_VHDL && opt_get_int(OPT_FAST_SCAN));
+   fast.flex_owns     = true;
+   fast.preserve_case = opt_get_int(OPT_PRESERVE_CASE);
+   fast.end           = buf + len;
+
+   if (fast.enabled)
+      fast_init_keywords();
+
    switch (kind) {
    case SOURCE_VERILOG:
       reset_verilog_parser();
@@ -184,6 +336,10 @@ void input_from_file(const char *file)
 
 void push_buffer(const char *buf, size_t len, file_ref_t file_ref)
 {
+   // Included files are always scanned by flex
+   fast_to_flex();
+   fast.enabled = false;
+
    APUSH(buf_stack, input_buf);
 
    yylloc = LOC_INVALID;
@@ -271,7 +427,10 @@ int get_next_char(char *b, int max_buffer)
    if (navail == 0)
       return 0;
 
-   const int nchars = MIN(navail, max_buffer);
+   // Flex only scans short sections of the input when the fast path
+   // below is active so avoid copying more than is needed
+   const int limit = fast.enabled ? MIN(max_buffer, FAST_READ_MAX) : max_buffer;
+   const int nchars = MIN(navail, limit);
 
    memcpy(b, input_buf.read_ptr, nchars);
    input_buf.read_ptr += nchars;
@@ -399,6 +558,406 @@ void free_token(token_t tok, yylval_t *lval)
    DEBUG_ONLY(lval->str = NULL);
 }
 
+static inline bool is_ascii_letter(char c)
+{
+   return (unsigned char)((c | 0x20) - 'a') < 26;
+}
+
+static inline bool is_ascii_digit(char c)
+{
+   return (unsigned char)(c - '0') < 10;
+}
+
+static const char *skip_blanks(const char *p, const char *end)
+{
+#ifdef ARCH_X86_64
+   const __m128i space = _mm_set1_epi8(' ');
+   const __m128i tab   = _mm_set1_epi8('\t');
+   const __m128i cr    = _mm_set1_epi8('\r');
+
+   for (; end - p >= 16; p += 16) {
+      const __m128i v = _mm_loadu_si128((const __m128i *)p);
+      const __m128i blank = _mm_or_si128(
+         _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+         _mm_cmpeq_epi8(v, cr));
+
+      const unsigned mask = ~_mm_movemask_epi8(blank) & 0xffff;
+      if (mask != 0)
+         return p + __builtin_ctz(mask);
+   }
+#endif
+
+   while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+      p++;
+
+   return p;
+}
+
+static const char *skip_ident_chars(const char *p, const char *end)
+{
+#ifdef ARCH_X86_64
+   // Bytes outside the ASCII range compare as negative and so are never
+   // treated as identifier characters
+   const __m128i lower_a = _mm_set1_epi8('a' - 1);
+   const __m128i lower_z = _mm_set1_epi8('z' + 1);
+   const __m128i digit_0 = _mm_set1_epi8('0' - 1);
+   const __m128i digit_9 = _mm_set1_epi8('9' + 1);
+   const __m128i under   = _mm_set1_epi8('_');
+   const __m128i casebit = _mm_set1_epi8(0x20);
+
+   for (; end - p >= 16; p += 16) {
+      const __m128i v = _mm_loadu_si128((const __m128i *)p);
+      const __m128i folded = _mm_or_si128(v, casebit);
+      const __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(folded, lower_a),
+                                           _mm_cmplt_epi8(folded, lower_z));
+      const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, digit_0),
+                                          _mm_cmplt_epi8(v, digit_9));
+      const __m128i ident = _mm_or_si128(_mm_or_si128(letter, digit),
+                                         _mm_cmpeq_epi8(v, under));
+
+      const unsigned mask = ~_mm_movemask_epi8(ident) & 0xffff;
+      if (mask != 0)
+         return p + __builtin_ctz(mask);
+   }
+#endif
+
+   while (p < end && (is_ascii_letter(*p) || is_ascii_digit(*p) || *p == '_'))
+      p++;
+
+   return p;
+}
+
+static bool is_pragma_comment(const char *p, const char *end)
+{
+   // These comments are recognised as tokens by the flex scanner
+   static const char *const prefixes[] = {
+      "synthesis", "coverage", "pragma", "psl"
+   };
+
+   while (p < end && (*p == ' ' || *p == '\t'))
+      p++;
+
+   for (int i = 0; i < ARRAY_LEN(prefixes); i++) {
+      const size_t len = strlen(prefixes[i]);
+      if ((size_t)(end - p) >= len && strncasecmp(p, prefixes[i], len) == 0)
+         return true;
+   }
+
+   return false;
+}
+
+static void fast_init_keywords(void)
+{
+   if (fast_keywords != NULL)
+      return;
+
+   fast_keywords = hash_new(ARRAY_LEN(vhdl_keywords) * 2);
+
+   for (int i = 0; i < ARRAY_LEN(vhdl_keywords); i++) {
+      ident_t id = ident_new(vhdl_keywords[i].text);
+      hash_put(fast_keywords, id, (void *)&(vhdl_keywords[i]));
+   }
+}
+
+static token_t fast_token(token_t token, const char *start, size_t len)
+{
+   const int first_col = start - fast.linestart;
+   const int last_col = first_col + len - 1;
+
+   yylloc = get_loc(fast.lineno, first_col, fast.lineno, last_col,
+                    input_buf.file_ref);
+
+   fast.pos = start + len;
+   return (fast.last_token = token);
+}
+
+static int fast_identifier(const char *start, const char *end)
+{
+   const size_t len = end - start;
+   if (len > FAST_MAX_IDENT || start[len - 1] == '_')
+      return -1;
+   else if (end < fast.end) {
+      // May be a bit string literal, Latin-1 identifier, or PSL until!
+      const unsigned char next = *end;
+      if (next >= 0x80 || next == '"' || next == '%' || next == '!')
+         return -1;
+   }
+
+   char upper[FAST_MAX_IDENT + 1];
+   for (size_t i = 0; i < len; i++) {
+      if (start[i] == '_' && i > 0 && start[i - 1] == '_')
+         return -1;
+      upper[i] = toupper_iso88591(start[i]);
+   }
+   upper[len] = '\0';
+
+   ident_t id = ident_new(upper);
+
+   const keyword_t *kw = hash_get(fast_keywords, id);
+   if (kw == NULL) {
+      yylval.ident = fast.preserve_case ? ident_new_n(start, len) : id;
+      return fast_token(tID, start, len);
+   }
+   else if (standard() < kw->std)
+      return -1;   // Flex warns about future reserved words
+   else
+      return fast_token(kw->token, start, len);
+}
+
+static int fast_number(const char *start)
+{
+   const char *p = start;
+   while (p < fast.end && is_ascii_digit(*p))
+      p++;
+
+   if (p - start > 18)
+      return -1;   // May overflow
+
+   int64_t value = 0;
+   for (const char *d = start; d < p; d++)
+      value = value * 10 + (*d - '0');
+
+   bool real = false;
+   if (p + 1 < fast.end && *p == '.' && is_ascii_digit(p[1])) {
+      for (p += 2; p < fast.end && is_ascii_digit(*p); p++)
+         ;
+      real = true;
+   }
+
+   if (p < fast.end) {
+      // Exponents, underscores, based and bit string literals
+      const char next = *p;
+      if (is_ascii_letter(next) || strchr("_.#:\"%", next) != NULL)
+         return -1;
+   }
+
+   if (real)
+      yylval.real = strtod(start, NULL);
+   else
+      yylval.i64 = value;
+
+   return fast_token(real ? tREAL : tINT, start, p - start);
+}
+
+static int fast_string(const char *start)
+{
+   const char *p = start + 1;
+   for (;; p++) {
+      if (p == fast.end || *p == '\n' || *p == '\0')
+         return -1;   // Unterminated string
+      else if (*p != '"')
+         continue;
+      else if (p + 1 < fast.end && p[1] == '"')
+         p++;
+      else
+         break;
+   }
+
+   const size_t len = p + 1 - start;
+
+   // Keep the opening and closing quotes as for parse_string in lexer.l
+   char *str = (yylval.str = xmalloc(len + 1)), *s = str;
+   *s++ = '"';
+   for (const char *q = start + 1; q < p; q++) {
+      if (*q == '"')
+         q++;
+      *s++ = *q;
+   }
+   *s++ = '"';
+   *s = '\0';
+
+   return fast_token(tSTRING, start, len);
+}
+
+static int fast_yylex(void)
+{
+   // Hand-written scanner for the most common VHDL tokens which avoids
+   // copying the input into the flex buffer and running the generated
+   // DFA: returns -1 to let flex scan anything else from this position
+   const char *p = fast.pos, *const end = fast.end;
+
+   for (;;) {
+      p = skip_blanks(p, end);
+
+      if (p == end) {
+         fast.pos = p;
+         return tEOF;
+      }
+      else if (*p == '\n') {
+         fast.lineno++;
+         fast.linestart = ++p;
+      }
+      else if (*p == '-' && p + 1 < end && p[1] == '-') {
+         if (is_pragma_comment(p + 2, end)) {
+            fast.pos = p;
+            return -1;   // Let flex produce the pragma tokens
+         }
+
+         const char *nl = memchr(p, '\n', end - p);
+         p = nl ?: end;
+      }
+      else
+         break;
+   }
+
+   fast.pos = p;
+
+   if (is_ascii_letter(*p))
+      return fast_identifier(p, skip_ident_chars(p + 1, end));
+   else if (is_ascii_digit(*p))
+      return fast_number(p);
+
+   const char next = p + 1 < end ? p[1] : '\0';
+
+   switch (*p) {
+   case '"':
+      return fast_string(p);
+
+   case '\'':
+      if (p + 2 < end && p[2] == '\'' && next != '\n') {
+         if (next < ' ' || next > '~')
+            return -1;
+
+         switch (fast.last_token) {
+         case tRSQUARE:
+         case tRPAREN:
+         case tALL:
+         case tID:
+            return -1;   // Flex rejects the character literal here
+         default:
+            yylval.ident = ident_new_n(p, 3);
+            return fast_token(tID, p, 3);
+         }
+      }
+      else
+         return fast_token(tTICK, p, 1);
+
+   case '(': case ')': case '{': case '}': case ',': case ';': case '+':
+   case '@': case '.': case '&': case '|': case '#': case '~': case '^':
+      return fast_token(*p, p, 1);
+
+   case '!':
+      return fast_token(tBAR, p, 1);
+
+   case '*':
+      if (next == '*')
+         return fast_token(tPOWER, p, 2);
+      else
+         return fast_token(tTIMES, p, 1);
+
+   case ':':
+      if (next == '=')
+         return fast_token(tWALRUS, p, 2);
+      else
+         return fast_token(tCOLON, p, 1);
+
+   case '<':
+      if (next == '=')
+         return fast_token(tLE, p, 2);
+      else if (next == '>')
+         return fast_token(tBOX, p, 2);
+      else if (next == '<')
+         return fast_token(tLTLT, p, 2);
+      else if (next == '-' && p + 2 < end && p[2] == '>')
+         return fast_token(tIFFIMPL, p, 3);
+      else
+         return fast_token(tLT, p, 1);
+
+   case '>':
+      if (next == '=')
+         return fast_token(tGE, p, 2);
+      else if (next == '>')
+         return fast_token(tGTGT, p, 2);
+      else
+         return fast_token(tGT, p, 1);
+
+   case '=':
+      if (next == '>')
+         return fast_token(tASSOC, p, 2);
+      else
+         return fast_token(tEQ, p, 1);
+
+   case '/':
+      if (next == '=')
+         return fast_token(tNEQ, p, 2);
+      else if (next == '*')
+         return -1;   // Delimited comment
+      else
+         return fast_token(tOVER, p, 1);
+
+   case '-':
+      if (next == '>')
+         return fast_token(tIFIMPL, p, 2);
+      else
+         return fast_token(tMINUS, p, 1);
+
+   case '[':
+      if (next == '[')
+         return fast_token(t2LSQUARE, p, 2);
+      else if (next == '*')
+         return fast_token(tTIMESRPT, p, 2);
+      else if (next == '=')
+         return fast_token(tEQRPT, p, 2);
+      else if (next == '+' && p + 2 < end && p[2] == ']')
+         return fast_token(tPLUSRPT, p, 3);
+      else if (next == '-' && p + 2 < end && p[2] == '>')
+         return fast_token(tGOTORPT, p, 3);
+      else
+         return fast_token(tLSQUARE, p, 1);
+
+   case ']':
+      if (next == ']')
+         return fast_token(t2RSQUARE, p, 2);
+      else
+         return fast_token(tRSQUARE, p, 1);
+
+   default:
+      return -1;
+   }
+}
+
+static void fast_from_flex(void)
+{
+   // Continue from the position after the last token matched by flex
+   fast.pos        = input_buf.read_ptr - scanner_unread();
+   fast.lineno     = input_buf.lineno;
+   fast.linestart  = fast.pos - input_buf.colno;
+   fast.last_token = scanner_last_token();
+   fast.synced     = fast.pos;
+   fast.flex_owns  = false;
+}
+
+static void fast_to_flex(void)
+{
+   if (fast.flex_owns)
+      return;
+   else if (fast.pos != fast.synced) {
+      // Discard the stale flex buffer and restart at the current position
+      input_buf.read_ptr = fast.pos;
+      input_buf.lineno   = fast.lineno;
+      input_buf.colno    = fast.pos - fast.linestart;
+
+      resume_scanner(fast.last_token, input_buf.colno == 0);
+   }
+
+   fast.flex_owns = true;
+}
+
+static int scan_yylex(void)
+{
+   if (fast.enabled && scanner_in_initial()) {
+      if (fast.flex_owns)
+         fast_from_flex();
+
+      const int tok = fast_yylex();
+      if (tok != -1)
+         return tok;
+   }
+
+   fast_to_flex();
+   return yylex();
+}
+
 static void pp_defines_init(void)
 {
    if (pp_defines != NULL)
@@ -454,7 +1013,8 @@ void pp_defines_iter(pp_iter_t fn, void *ctx)
 
 static int pp_yylex(void)
 {
-   const int tok = input_buf.lookahead != -1 ? input_buf.lookahead : yylex();
+   const int tok =
+      input_buf.lookahead != -1 ? input_buf.lookahead : scan_yylex();
    input_buf.lookahead = -1;
    return tok;
 }
@@ -685,7 +1245,7 @@ static void pp_nvc_pop(void)
    input_buf.file_ref = top.expandloc.file_ref;
 
    // Eat the following newline and adjust the next token location
-   input_buf.lookahead = yylex();
+   input_buf.lookahead = scan_yylex();
 
    yylloc.first_column +=
       top.expandloc.first_column + top.expandloc.column_delta + 1;
@@ -795,7 +1355,7 @@ token_t processed_yylex(void)
             else
                APOP(cond_stack);
 
-            if ((input_buf.lookahead = yylex()) == tIF)
+            if ((input_buf.lookahead = scan_yylex()) == tIF)
                input_buf.lookahead = -1;
          }
          break;
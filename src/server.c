@@ -16,6 +16,7 @@
 //
 
 #include "util.h"
+#include "array.h"
 #include "hash.h"
 #include "ident.h"
 #include "jit/jit.h"
@@ -42,8 +43,12 @@
 #define WIN32_LEAN_AND_MEAN
 #include <winsock2.h>
 #else
+#include <poll.h>
+#include <signal.h>
 #include <sys/select.h>
 #include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
 #include <netinet/in.h>
 #endif
 
@@ -69,6 +74,12 @@
 #define WS_OPCODE_PONG_FRAME   0xa
 
 #define MAX_HTTP_REQUEST 1024
+#define MAX_WS_BACKLOG   (1 << 20)
+#define MAX_COMPILE_REQ  (1 << 20)
+
+#define COMPILE_STDOUT 'O'
+#define COMPILE_STDERR 'E'
+#define COMPILE_EXIT   'X'
 
 #ifndef __MINGW32__
 #define closesocket close
@@ -98,6 +109,48 @@ typedef struct _packet_buf {
    size_t rptr;
 } packet_buf_t;
 
+typedef struct {
+   uint64_t start;
+   uint64_t end;
+   uint64_t offset;
+   uint32_t size;
+   uint32_t count;
+} trace_chunk_t;
+
+typedef struct {
+   ident_t        path;
+   A(trace_chunk_t) index;
+   packet_buf_t  *pending;
+   unsigned       npending;
+   uint64_t       first;
+   uint64_t       last;
+   char          *prev;
+} trace_column_t;
+
+typedef struct _trace_store {
+   FILE          *file;
+   char          *path;
+   uint64_t       size;
+   void          *map;
+   size_t         mapsz;
+   hash_t        *columns;
+   A(trace_column_t *) all;
+} trace_store_t;
+
+typedef void (*trace_fn_t)(uint64_t, const char *, size_t, void *);
+
+typedef struct {
+   uint64_t    start;
+   uint64_t    end;
+   trace_fn_t  fn;
+   void       *ctx;
+   char       *value;
+   size_t      valuesz;
+   size_t      valuelen;
+   uint64_t    initial;
+   bool        have_initial;
+} trace_cursor_t;
+
 typedef struct {
    debug_server_t *(*new_server)(void);
    void (*free_server)(debug_server_t *);
@@ -116,11 +169,26 @@ typedef struct _debug_server {
    tree_t                top;
    packet_buf_t         *packetbuf;
    const char           *init_cmd;
+   trace_store_t        *trace;
+   uint64_t              now;
 } debug_server_t;
 
+typedef struct {
+   ident_t   path;
+   uint32_t  id;
+   bool      dirty;
+   char     *sent;
+   char     *latest;
+} wave_signal_t;
+
 typedef struct {
    debug_server_t  server;
    web_socket_t   *websocket;
+   hash_t         *wavemap;
+   A(wave_signal_t *) waves;
+   A(wave_signal_t *) dirty;
+   bool            delta_values;
+   bool            held_time_step;
 } http_server_t;
 
 typedef struct {
@@ -239,6 +307,13 @@ void ws_flush(web_socket_t *ws)
       if (nbytes == 0)
          break;
       else if (nbytes < 0) {
+#ifdef __MINGW32__
+         if (WSAGetLastError() == WSAEWOULDBLOCK)
+            break;   // Try again when the socket is writable
+#else
+         if (errno == EAGAIN || errno == EWOULDBLOCK)
+            break;   // Try again when the socket is writable
+#endif
          ws->closing = true;
          break;
       }
@@ -427,6 +502,15 @@ static void pb_pack_u64(packet_buf_t *pb, uint64_t value)
    pb->buf[pb->wptr++] = value & 0xff;
 }
 
+static void pb_pack_uleb(packet_buf_t *pb, uint64_t value)
+{
+   do {
+      pb_grow(pb, 1);
+      pb->buf[pb->wptr++] = (value & 0x7f) | (value > 0x7f ? 0x80 : 0);
+      value >>= 7;
+   } while (value > 0);
+}
+
 static void pb_pack_bytes(packet_buf_t *pb, const void *data, size_t len)
 {
    pb_grow(pb, len);
@@ -452,6 +536,385 @@ static void pb_pack_ident(packet_buf_t *pb, ident_t ident)
    pb_pack_bytes(pb, istr(ident), len);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Trace store
+//
+// Each signal added to the wave view has a column of value changes
+// split into chunks of TRACE_CHUNK_SIZE entries.  Within a chunk each
+// change is encoded as the time delta from the previous change, the
+// length of the prefix shared with the previous value, and the
+// remaining suffix bytes.  Completed chunks are appended to the trace
+// file and read back through a memory mapping.  The per-column index
+// of chunk start and end times allows a time range to be located with
+// a binary search.
+//
+// When the server exits the remaining partial chunks are flushed and
+// the index is appended to the file followed by a footer holding the
+// offset of the index and TRACE_MAGIC.  Opening an existing trace file
+// loads this index so the history of the earlier session can be
+// queried until the next simulation starts.  All integers in the index
+// and footer are big-endian.
+
+#define TRACE_CHUNK_SIZE 256
+#define TRACE_MAGIC      0x4e564354   // "NVCT"
+
+static uint64_t trace_get_uleb(const uint8_t **p)
+{
+   uint64_t value = 0;
+   for (int shift = 0;; shift += 7) {
+      const uint8_t byte = *(*p)++;
+      value |= (uint64_t)(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+         return value;
+   }
+}
+
+static trace_column_t *trace_column(trace_store_t *ts, ident_t path)
+{
+   trace_column_t *tc = hash_get(ts->columns, path);
+   if (tc == NULL) {
+      tc = xcalloc(sizeof(trace_column_t));
+      tc->path    = path;
+      tc->pending = pb_new();
+
+      hash_put(ts->columns, path, tc);
+      APUSH(ts->all, tc);
+   }
+
+   return tc;
+}
+
+static void trace_unmap(trace_store_t *ts)
+{
+   if (ts->map != NULL) {
+      unmap_file(ts->map, ts->mapsz);
+      ts->map = NULL;
+      ts->mapsz = 0;
+   }
+}
+
+static void trace_reset(trace_store_t *ts)
+{
+   trace_unmap(ts);
+
+   for (int i = 0; i < ts->all.count; i++) {
+      trace_column_t *tc = ts->all.items[i];
+      ACLEAR(tc->index);
+      tc->pending->wptr = 0;
+      tc->npending = 0;
+      free(tc->prev);
+      tc->prev = NULL;
+   }
+
+   if (fflush(ts->file) != 0 || ftruncate(fileno(ts->file), 0) != 0)
+      fatal_errno("%s", ts->path);
+
+   rewind(ts->file);
+   ts->size = 0;
+}
+
+static bool trace_load_index(trace_store_t *ts, const uint8_t *map,
+                             size_t size)
+{
+   if (size < 12 || UNPACK_BE32(map + size - 4) != TRACE_MAGIC)
+      return false;
+
+   const uint64_t offset = UNPACK_BE64(map + size - 12);
+   if (offset > size - 12)
+      return false;
+
+   const uint8_t *p = map + offset, *end = map + size - 12;
+
+   if (end - p < 4)
+      return false;
+
+   const uint32_t ncolumns = UNPACK_BE32(p);
+   p += 4;
+
+   for (uint32_t i = 0; i < ncolumns; i++) {
+      if (end - p < 2 || end - p < 2 + UNPACK_BE16(p) + 4)
+         return false;
+
+      const size_t len = UNPACK_BE16(p);
+      trace_column_t *tc = trace_column(ts, ident_new_n((char *)p + 2, len));
+      p += 2 + len;
+
+      const uint32_t nchunks = UNPACK_BE32(p);
+      p += 4;
+
+      if ((end - p) / 32 < nchunks)
+         return false;
+
+      for (uint32_t j = 0; j < nchunks; j++, p += 32) {
+         const trace_chunk_t chunk = {
+            .start  = UNPACK_BE64(p),
+            .end    = UNPACK_BE64(p + 8),
+            .offset = UNPACK_BE64(p + 16),
+            .size   = UNPACK_BE32(p + 24),
+            .count  = UNPACK_BE32(p + 28),
+         };
+
+         if (chunk.offset > offset || chunk.size > offset - chunk.offset)
+            return false;
+
+         APUSH(tc->index, chunk);
+      }
+   }
+
+   ts->size = offset;
+   return true;
+}
+
+static trace_store_t *trace_open(const char *path)
+{
+   FILE *f = fopen(path, "r+b");
+   if (f == NULL && errno == ENOENT)
+      f = fopen(path, "w+b");
+
+   if (f == NULL)
+      fatal_errno("%s", path);
+
+   trace_store_t *ts = xcalloc(sizeof(trace_store_t));
+   ts->file    = f;
+   ts->path    = xstrdup(path);
+   ts->columns = hash_new(64);
+
+   file_info_t info;
+   if (!get_handle_info(fileno(f), &info))
+      fatal_errno("%s", path);
+
+   if (info.size > 0) {
+      void *map = map_file(fileno(f), info.size);
+      const bool valid = trace_load_index(ts, map, info.size);
+      unmap_file(map, info.size);
+
+      if (!valid) {
+         warnf("%s is not a valid trace file and will be overwritten", path);
+         trace_reset(ts);
+      }
+      else if (ftruncate(fileno(f), ts->size) != 0
+               || fseek(f, ts->size, SEEK_SET) != 0)
+         fatal_errno("%s", path);
+   }
+
+   return ts;
+}
+
+static void trace_flush_chunk(trace_store_t *ts, trace_column_t *tc)
+{
+   if (tc->npending == 0)
+      return;
+
+   if (fwrite(tc->pending->buf, tc->pending->wptr, 1, ts->file) != 1)
+      fatal_errno("%s", ts->path);
+
+   const trace_chunk_t chunk = {
+      .start  = tc->first,
+      .end    = tc->last,
+      .offset = ts->size,
+      .size   = tc->pending->wptr,
+      .count  = tc->npending,
+   };
+   APUSH(tc->index, chunk);
+
+   ts->size += tc->pending->wptr;
+
+   tc->pending->wptr = 0;
+   tc->npending = 0;
+
+   free(tc->prev);
+   tc->prev = NULL;
+}
+
+static void trace_append(trace_store_t *ts, ident_t path, uint64_t now,
+                         const char *enc)
+{
+   trace_column_t *tc = trace_column(ts, path);
+
+   if (tc->npending == 0)
+      tc->first = tc->last = now;
+
+   assert(now >= tc->last);
+
+   size_t prefix = 0;
+   if (tc->prev != NULL) {
+      while (tc->prev[prefix] != '\0' && tc->prev[prefix] == enc[prefix])
+         prefix++;
+   }
+
+   const size_t suffix = strlen(enc + prefix);
+
+   pb_pack_uleb(tc->pending, now - tc->last);
+   pb_pack_uleb(tc->pending, prefix);
+   pb_pack_uleb(tc->pending, suffix);
+   pb_pack_bytes(tc->pending, enc + prefix, suffix);
+
+   free(tc->prev);
+   tc->prev = xstrdup(enc);
+   tc->last = now;
+
+   if (++tc->npending == TRACE_CHUNK_SIZE)
+      trace_flush_chunk(ts, tc);
+}
+
+static void trace_write_index(trace_store_t *ts)
+{
+   for (int i = 0; i < ts->all.count; i++)
+      trace_flush_chunk(ts, ts->all.items[i]);
+
+   packet_buf_t *pb = pb_new();
+   pb_pack_u32(pb, ts->all.count);
+
+   for (int i = 0; i < ts->all.count; i++) {
+      trace_column_t *tc = ts->all.items[i];
+      pb_pack_ident(pb, tc->path);
+      pb_pack_u32(pb, tc->index.count);
+
+      for (int j = 0; j < tc->index.count; j++) {
+         const trace_chunk_t *chunk = &(tc->index.items[j]);
+         pb_pack_u64(pb, chunk->start);
+         pb_pack_u64(pb, chunk->end);
+         pb_pack_u64(pb, chunk->offset);
+         pb_pack_u32(pb, chunk->size);
+         pb_pack_u32(pb, chunk->count);
+      }
+   }
+
+   pb_pack_u64(pb, ts->size);
+   pb_pack_u32(pb, TRACE_MAGIC);
+
+   if (fwrite(pb->buf, pb->wptr, 1, ts->file) != 1)
+      fatal_errno("%s", ts->path);
+
+   pb_free(pb);
+}
+
+static void trace_close(trace_store_t *ts)
+{
+   trace_unmap(ts);
+   trace_write_index(ts);
+
+   for (int i = 0; i < ts->all.count; i++) {
+      trace_column_t *tc = ts->all.items[i];
+      ACLEAR(tc->index);
+      pb_free(tc->pending);
+      free(tc->prev);
+      free(tc);
+   }
+   ACLEAR(ts->all);
+
+   if (fclose(ts->file) != 0)
+      fatal_errno("%s", ts->path);
+
+   hash_free(ts->columns);
+   free(ts->path);
+   free(ts);
+}
+
+static bool trace_decode_chunk(trace_cursor_t *tc, const uint8_t *p,
+                               uint64_t base, unsigned count)
+{
+   uint64_t now = base;
+   for (unsigned i = 0; i < count; i++) {
+      now += trace_get_uleb(&p);
+      const size_t prefix = trace_get_uleb(&p);
+      const size_t suffix = trace_get_uleb(&p);
+
+      if (now > tc->start && tc->have_initial) {
+         // The value buffer still holds the last change before the
+         // start of the range
+         (*tc->fn)(tc->initial, tc->value, tc->valuelen, tc->ctx);
+         tc->have_initial = false;
+      }
+
+      if (now > tc->end)
+         return false;
+
+      assert(prefix <= tc->valuelen);
+
+      if (prefix + suffix + 1 > tc->valuesz) {
+         tc->valuesz = MAX(tc->valuesz * 2, prefix + suffix + 1);
+         tc->value = xrealloc(tc->value, tc->valuesz);
+      }
+
+      memcpy(tc->value + prefix, p, suffix);
+      tc->valuelen = prefix + suffix;
+      tc->value[tc->valuelen] = '\0';
+      p += suffix;
+
+      if (now <= tc->start) {
+         tc->initial = now;
+         tc->have_initial = true;
+      }
+      else
+         (*tc->fn)(now, tc->value, tc->valuelen, tc->ctx);
+   }
+
+   return true;
+}
+
+static void trace_query(trace_store_t *ts, ident_t path, uint64_t start,
+                        uint64_t end, trace_fn_t fn, void *ctx)
+{
+   // Emits the last change at or before the start of the range
+   // followed by every change inside it
+
+   trace_column_t *col = hash_get(ts->columns, path);
+   if (col == NULL || start > end)
+      return;
+
+   if (ts->size > ts->mapsz) {
+      trace_unmap(ts);
+
+      if (fflush(ts->file) != 0)
+         fatal_errno("%s", ts->path);
+
+      ts->map = map_file(fileno(ts->file), ts->size);
+      ts->mapsz = ts->size;
+   }
+
+   // Binary search for the last chunk starting at or before the
+   // beginning of the range
+   int lo = 0, hi = col->index.count - 1, first = 0;
+   while (lo <= hi) {
+      const int mid = lo + (hi - lo) / 2;
+      if (col->index.items[mid].start <= start) {
+         first = mid;
+         lo = mid + 1;
+      }
+      else
+         hi = mid - 1;
+   }
+
+   trace_cursor_t tc = {
+      .start = start,
+      .end   = end,
+      .fn    = fn,
+      .ctx   = ctx,
+   };
+
+   bool more = true;
+   for (int i = first; more && i < col->index.count; i++) {
+      const trace_chunk_t *chunk = &(col->index.items[i]);
+      if (chunk->start > end)
+         more = false;
+      else {
+         const uint8_t *p = (const uint8_t *)ts->map + chunk->offset;
+         more = trace_decode_chunk(&tc, p, chunk->start, chunk->count);
+      }
+   }
+
+   if (more && col->npending > 0 && col->first <= end) {
+      const uint8_t *p = (const uint8_t *)col->pending->buf;
+      trace_decode_chunk(&tc, p, col->first, col->npending);
+   }
+
+   if (tc.have_initial)
+      (*fn)(tc.initial, tc.value, tc.valuelen, ctx);
+
+   free(tc.value);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Generic networking utilities
 
@@ -604,19 +1067,59 @@ static void send_file(int fd, const char *file, const char *mime)
 }
 #endif
 
-static void handle_text_frame(web_socket_t *ws, const char *text, void *context)
+typedef struct {
+   packet_buf_t *pb;
+   uint32_t      count;
+} trace_reply_t;
+
+static void trace_data_cb(uint64_t now, const char *value, size_t len,
+                          void *ctx)
 {
-   debug_server_t *server = context;
+   trace_reply_t *reply = ctx;
+   pb_pack_u64(reply->pb, now);
+   pb_pack_u32(reply->pb, len);
+   pb_pack_bytes(reply->pb, value, len);
+   reply->count++;
+}
 
-   const char *result = NULL;
-   if (shell_eval(server->shell, text, &result) && *result != '\0')
-      ws_send_text(ws, result);
+static void handle_query_trace(web_socket_t *ws, debug_server_t *server,
+                               const uint8_t *data, size_t length)
+{
+   // Payload is the signal path followed by start and end times
+   if (length < 2 || length != 2 + UNPACK_BE16(data) + 16) {
+      server_log(LOG_ERROR, "malformed trace query");
+      return;
+   }
+
+   const size_t pathlen = UNPACK_BE16(data);
+   ident_t path = ident_new_n((const char *)data + 2, pathlen);
+   const uint64_t start = UNPACK_BE64(data + 2 + pathlen);
+   const uint64_t end = UNPACK_BE64(data + 2 + pathlen + 8);
+
+   packet_buf_t *pb = fresh_packet_buffer(server);
+   pb_pack_u8(pb, S2C_TRACE_DATA);
+   pb_pack_ident(pb, path);
+
+   const size_t countptr = pb->wptr;
+   pb_pack_u32(pb, 0);   // Patched below
+
+   trace_reply_t reply = { pb, 0 };
+   if (server->trace != NULL)
+      trace_query(server->trace, path, start, end, trace_data_cb, &reply);
+   else
+      server_log(LOG_WARN, "trace store not enabled");
+
+   const uint8_t count[4] = { PACK_BE32(reply.count) };
+   memcpy(pb->buf + countptr, count, sizeof(count));
+
+   ws_send_packet(ws, pb);
 }
 
 static void handle_binary_frame(web_socket_t *ws, const void *data,
                                 size_t length, void *context)
 {
    debug_server_t *server = context;
+   http_server_t *http = container_of(server, http_server_t, server);
 
    if (length == 0) {
       server_log(LOG_WARN, "ignoring zero-length binary frame");
@@ -628,6 +1131,12 @@ static void handle_binary_frame(web_socket_t *ws, const void *data,
    case C2S_SHUTDOWN:
       server->shutdown = true;
       break;
+   case C2S_QUERY_TRACE:
+      handle_query_trace(ws, server, data + 1, length - 1);
+      break;
+   case C2S_DELTA_VALUES:
+      http->delta_values = true;
+      break;
    default:
       server_log(LOG_ERROR, "unhandled client to server opcode %02x", op);
       break;
@@ -676,6 +1185,24 @@ static void add_wave_handler(ident_t path, const char *enc, void *user)
 {
    http_server_t *http = container_of(user, http_server_t, server);
 
+   if (http->server.trace != NULL)
+      trace_append(http->server.trace, path, http->server.now, enc);
+
+   // Signals are numbered in the order they are first added and
+   // later updates refer to them by this index
+   wave_signal_t *w = hash_get(http->wavemap, path);
+   if (w == NULL) {
+      w = xcalloc(sizeof(wave_signal_t));
+      w->path = path;
+      w->id   = http->waves.count;
+
+      hash_put(http->wavemap, path, w);
+      APUSH(http->waves, w);
+   }
+
+   free(w->sent);
+   w->sent = xstrdup(enc);
+
    packet_buf_t *pb = fresh_packet_buffer(&(http->server));
    pb_pack_u8(pb, S2C_ADD_WAVE);
    pb_pack_ident(pb, path);
@@ -688,17 +1215,111 @@ static void signal_update_handler(ident_t path, uint64_t now, rt_signal_t *s,
 {
    http_server_t *http = container_of(user, http_server_t, server);
 
+   if (http->server.trace != NULL)
+      trace_append(http->server.trace, path, now, enc);
+
+   wave_signal_t *w = hash_get(http->wavemap, path);
+   if (w == NULL)
+      return;
+
+   // Only the most recent value is kept if the signal changes again
+   // before the batch is sent
+   free(w->latest);
+   w->latest = xstrdup(enc);
+
+   if (!w->dirty) {
+      w->dirty = true;
+      APUSH(http->dirty, w);
+   }
+}
+
+static bool client_backlogged(web_socket_t *ws)
+{
+   return ws->tx_wptr - ws->tx_rptr > MAX_WS_BACKLOG;
+}
+
+static void flush_signal_batch(http_server_t *http)
+{
+   // All the changes since the last batch are packed into a single
+   // frame with each value encoded as the length of the prefix shared
+   // with the previous value sent to the client followed by the
+   // remaining characters.  The prefix is always zero unless the
+   // client asked for delta values with C2S_DELTA_VALUES.
+
+   web_socket_t *ws = http->websocket;
+   if (http->dirty.count == 0 || ws == NULL)
+      return;
+
+   if (client_backlogged(ws)) {
+      ws_flush(ws);
+
+      if (client_backlogged(ws))
+         return;   // Client is falling behind, coalesce with next batch
+   }
+
    packet_buf_t *pb = fresh_packet_buffer(&(http->server));
-   pb_pack_u8(pb, S2C_SIGNAL_UPDATE);
-   pb_pack_ident(pb, path);
-   pb_pack_str(pb, enc);
-   ws_send_packet(http->websocket, pb);
+   pb_pack_u8(pb, S2C_SIGNAL_BATCH);
+   pb_pack_u64(pb, http->server.now);
+   pb_pack_u32(pb, http->dirty.count);
+
+   for (int i = 0; i < http->dirty.count; i++) {
+      wave_signal_t *w = http->dirty.items[i];
+
+      size_t prefix = 0;
+      if (w->sent != NULL && http->delta_values) {
+         while (w->sent[prefix] != '\0' && w->sent[prefix] == w->latest[prefix])
+            prefix++;
+      }
+
+      const size_t suffix = strlen(w->latest + prefix);
+      assert(prefix < UINT16_MAX && suffix < UINT16_MAX);
+
+      pb_pack_u32(pb, w->id);
+      pb_pack_u16(pb, prefix);
+      pb_pack_u16(pb, suffix);
+      pb_pack_bytes(pb, w->latest + prefix, suffix);
+
+      free(w->sent);
+      w->sent = w->latest;
+      w->latest = NULL;
+      w->dirty = false;
+   }
+
+   ATRIM(http->dirty, 0);
+
+   ws_send_packet(ws, pb);
+   ws_flush(ws);
+}
+
+static void reset_wave_signals(http_server_t *http)
+{
+   for (int i = 0; i < http->waves.count; i++) {
+      wave_signal_t *w = http->waves.items[i];
+      free(w->sent);
+      free(w->latest);
+      free(w);
+   }
+
+   ACLEAR(http->waves);
+   ACLEAR(http->dirty);
+
+   if (http->wavemap != NULL)
+      hash_free(http->wavemap);
+
+   http->wavemap = hash_new(64);
 }
 
 static void start_sim_handler(ident_t top, void *user)
 {
    http_server_t *http = container_of(user, http_server_t, server);
 
+   http->server.now = 0;
+
+   if (http->server.trace != NULL)
+      trace_reset(http->server.trace);
+
+   reset_wave_signals(http);
+
    packet_buf_t *pb = fresh_packet_buffer(&(http->server));
    pb_pack_u8(pb, S2C_START_SIM);
    pb_pack_ident(pb, top);
@@ -709,6 +1330,22 @@ static void restart_sim_handler(void *user)
 {
    http_server_t *http = container_of(user, http_server_t, server);
 
+   http->server.now = 0;
+
+   if (http->server.trace != NULL)
+      trace_reset(http->server.trace);
+
+   // Discard changes from the previous run but keep the signal
+   // numbering as the client retains its wave view
+   for (int i = 0; i < http->waves.count; i++) {
+      wave_signal_t *w = http->waves.items[i];
+      free(w->sent);
+      free(w->latest);
+      w->sent = w->latest = NULL;
+      w->dirty = false;
+   }
+   ATRIM(http->dirty, 0);
+
    packet_buf_t *pb = fresh_packet_buffer(&(http->server));
    pb_pack_u8(pb, S2C_RESTART_SIM);
    ws_send_packet(http->websocket, pb);
@@ -718,10 +1355,64 @@ static void next_time_step_handler(uint64_t now, void *user)
 {
    http_server_t *http = container_of(user, http_server_t, server);
 
+   flush_signal_batch(http);
+
+   http->server.now = now;
+
+   web_socket_t *ws = http->websocket;
+   if (ws == NULL)
+      return;
+   else if (client_backlogged(ws)) {
+      http->held_time_step = true;   // Client only needs the latest time
+      return;
+   }
+
+   http->held_time_step = false;
+
    packet_buf_t *pb = fresh_packet_buffer(&(http->server));
    pb_pack_u8(pb, S2C_NEXT_TIME_STEP);
    pb_pack_u64(pb, now);
-   ws_send_packet(http->websocket, pb);
+   ws_send_packet(ws, pb);
+}
+
+static void flush_held_updates(http_server_t *http)
+{
+   // Send the time step and signal batch that were held back while the
+   // client was falling behind once its backlog has drained
+   web_socket_t *ws = http->websocket;
+   if (ws == NULL)
+      return;
+   else if (client_backlogged(ws)) {
+      ws_flush(ws);
+
+      if (client_backlogged(ws))
+         return;
+   }
+
+   if (http->held_time_step) {
+      packet_buf_t *pb = fresh_packet_buffer(&(http->server));
+      pb_pack_u8(pb, S2C_NEXT_TIME_STEP);
+      pb_pack_u64(pb, http->server.now);
+      ws_send_packet(ws, pb);
+
+      http->held_time_step = false;
+   }
+
+   flush_signal_batch(http);
+}
+
+static void handle_text_frame(web_socket_t *ws, const char *text, void *context)
+{
+   debug_server_t *server = context;
+   http_server_t *http = container_of(server, http_server_t, server);
+
+   const char *result = NULL;
+   const bool ok = shell_eval(server->shell, text, &result);
+
+   flush_held_updates(http);
+
+   if (ok && *result != '\0')
+      ws_send_text(ws, result);
 }
 
 static void open_websocket(http_server_t *http, int fd)
@@ -739,6 +1430,8 @@ static void open_websocket(http_server_t *http, int fd)
    };
 
    http->websocket = ws_new(fd, &handler, false);
+   http->delta_values = false;
+   http->held_time_step = false;
 
    diag_set_consumer(tunnel_diag, &(http->server));
 
@@ -1027,8 +1720,10 @@ static void http_poll_sockets(debug_server_t *server, fd_set *rfd, fd_set *wfd)
    if (FD_ISSET(http->websocket->sock, rfd))
       ws_poll(http->websocket);
 
-   if (FD_ISSET(http->websocket->sock, wfd))
+   if (FD_ISSET(http->websocket->sock, wfd)) {
       ws_flush(http->websocket);
+      flush_held_updates(http);
+   }
 
    if (http->websocket->closing)
       kill_http_connection(http);
@@ -1045,6 +1740,8 @@ static void http_shutdown(debug_server_t *server)
 static debug_server_t *http_server_new(void)
 {
    http_server_t *http = xcalloc(sizeof(http_server_t));
+   reset_wave_signals(http);
+
    return &(http->server);
 }
 
@@ -1052,6 +1749,10 @@ static void http_server_free(debug_server_t *server)
 {
    http_server_t *http = container_of(server, http_server_t, server);
    assert(http->websocket == NULL);
+
+   reset_wave_signals(http);
+   hash_free(http->wavemap);
+
    free(http);
 }
 
@@ -1349,6 +2050,345 @@ static const server_proto_t cxxrtl_protocol = {
    .shutdown = cxxrtl_shutdown,
 };
 
+////////////////////////////////////////////////////////////////////////////////
+// Compile server
+//
+// Clients send a NUL-terminated JSON object containing the command line
+// arguments and working directory.  Each request is run in a process
+// forked from the server so it starts with all the libraries the server
+// loaded before accepting connections.  The output of the command is
+// sent back in frames consisting of a type byte and a 32-bit big-endian
+// length followed by the data, finishing with an exit status frame.
+
+#ifndef __MINGW32__
+
+static volatile sig_atomic_t compile_stop = 0;
+
+static void compile_stop_handler(int sig)
+{
+   compile_stop = 1;
+}
+
+static void compile_send_frame(int fd, char type, const void *data,
+                               uint32_t len)
+{
+   const uint8_t header[5] = { type, PACK_BE32(len) };
+   send_fully(fd, header, sizeof(header));
+   send_fully(fd, data, len);
+}
+
+static bool compile_recv_fully(int fd, void *data, size_t len)
+{
+   while (len > 0) {
+      ssize_t nbytes = recv(fd, data, len, 0);
+      if (nbytes == -1 && errno == EINTR)
+         continue;
+      else if (nbytes <= 0)
+         return false;
+
+      data += nbytes;
+      len -= nbytes;
+   }
+
+   return true;
+}
+
+static json_t *compile_read_request(int fd)
+{
+   size_t size = 1024, wptr = 0;
+   char *buf LOCAL = xmalloc(size);
+
+   for (;;) {
+      if (wptr == size) {
+         if (size >= MAX_COMPILE_REQ)
+            return NULL;
+         buf = xrealloc(buf, (size *= 2));
+      }
+
+      ssize_t nbytes = recv(fd, buf + wptr, size - wptr, 0);
+      if (nbytes == -1 && errno == EINTR)
+         continue;
+      else if (nbytes <= 0)
+         return NULL;
+
+      char *endp = memchr(buf + wptr, '\0', nbytes);
+      wptr += nbytes;
+
+      if (endp != NULL) {
+         json_error_t error;
+         return json_loads(buf, 0, &error);
+      }
+   }
+}
+
+static void compile_relay(int fd, int outfd, int errfd)
+{
+   struct pollfd fds[2] = {
+      { .fd = outfd, .events = POLLIN },
+      { .fd = errfd, .events = POLLIN },
+   };
+   const char types[2] = { COMPILE_STDOUT, COMPILE_STDERR };
+
+   char buf[4096];
+   while (fds[0].fd != -1 || fds[1].fd != -1) {
+      if (poll(fds, 2, -1) == -1) {
+         if (errno == EINTR)
+            continue;
+         fatal_errno("poll");
+      }
+
+      for (int i = 0; i < 2; i++) {
+         if (fds[i].fd == -1 || fds[i].revents == 0)
+            continue;
+
+         const ssize_t nbytes = read(fds[i].fd, buf, sizeof(buf));
+         if (nbytes > 0)
+            compile_send_frame(fd, types[i], buf, nbytes);
+         else if (nbytes == 0 || errno != EINTR) {
+            close(fds[i].fd);
+            fds[i].fd = -1;
+         }
+      }
+   }
+}
+
+__attribute__((noreturn))
+static void compile_serve_one(int fd, compile_fn_t fn, void *ctx)
+{
+   signal(SIGPIPE, SIG_IGN);   // Client may disconnect early
+
+   json_t *root = compile_read_request(fd);
+   json_t *args = json_object_get(root, "args");
+   json_t *cwd = json_object_get(root, "cwd");
+
+   if (!json_is_array(args) || !json_is_string(cwd)) {
+      server_log(LOG_ERROR, "malformed compile request");
+      _exit(EXIT_FAILURE);
+   }
+
+   const int nargs = json_array_size(args);
+   char **argv = xcalloc_array(nargs + 2, sizeof(char *));
+   argv[0] = PACKAGE;
+   for (int i = 0; i < nargs; i++) {
+      json_t *arg = json_array_get(args, i);
+      if (!json_is_string(arg)) {
+         server_log(LOG_ERROR, "malformed compile request");
+         _exit(EXIT_FAILURE);
+      }
+      argv[i + 1] = (char *)json_string_value(arg);
+   }
+
+   int outp[2], errp[2];
+   if (pipe(outp) != 0 || pipe(errp) != 0)
+      fatal_errno("pipe");
+
+   const pid_t pid = fork();
+   if (pid == -1)
+      fatal_errno("fork");
+   else if (pid == 0) {
+      close(fd);
+
+      signal(SIGINT, SIG_DFL);
+      signal(SIGTERM, SIG_DFL);
+      signal(SIGPIPE, SIG_DFL);
+
+      const int null = open("/dev/null", O_RDONLY);
+      if (null == -1 || dup2(null, STDIN_FILENO) == -1
+          || dup2(outp[1], STDOUT_FILENO) == -1
+          || dup2(errp[1], STDERR_FILENO) == -1)
+         _exit(EXIT_FAILURE);
+
+      close(null);
+      close(outp[0]);
+      close(outp[1]);
+      close(errp[0]);
+      close(errp[1]);
+
+      const bool color = json_is_true(json_object_get(root, "color"));
+      setenv("NVC_COLORS", color ? "always" : "never", 1);
+      term_init();
+
+      if (chdir(json_string_value(cwd)) != 0)
+         fatal_errno("cannot change directory to %s",
+                     json_string_value(cwd));
+
+      const int rc = (*fn)(nargs + 1, argv, ctx);
+      fflush(stdout);
+      exit(rc);
+   }
+
+   close(outp[1]);
+   close(errp[1]);
+
+   compile_relay(fd, outp[0], errp[0]);
+
+   int status;
+   while (waitpid(pid, &status, 0) == -1) {
+      if (errno != EINTR)
+         fatal_errno("waitpid");
+   }
+
+   int rc;
+   if (WIFEXITED(status))
+      rc = WEXITSTATUS(status);
+   else if (WIFSIGNALED(status))
+      rc = 128 + WTERMSIG(status);
+   else
+      rc = EXIT_FAILURE;
+
+   const uint8_t bytes[4] = { PACK_BE32(rc) };
+   compile_send_frame(fd, COMPILE_EXIT, bytes, sizeof(bytes));
+
+   _exit(EXIT_SUCCESS);
+}
+
+static int compile_connect(const char *path, struct sockaddr_un *addr)
+{
+   if (strlen(path) >= sizeof(addr->sun_path))
+      fatal("socket path %s is too long", path);
+
+   memset(addr, '\0', sizeof(struct sockaddr_un));
+   addr->sun_family = AF_UNIX;
+   strcpy(addr->sun_path, path);
+
+   const int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+   if (sock < 0)
+      fatal_errno("socket");
+
+   return sock;
+}
+
+void start_compile_server(const char *path, compile_fn_t fn, void *ctx,
+                          server_ready_fn_t cb, void *arg)
+{
+   struct sockaddr_un addr;
+   const int sock = compile_connect(path, &addr);
+
+   if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == 0)
+      fatal("a server is already listening on %s", path);
+
+   unlink(path);   // Stale socket from a previous server
+
+   if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+      fatal_errno("bind: %s", path);
+
+   if (listen(sock, SOMAXCONN) < 0)
+      fatal_errno("listen");
+
+   // Do not set SA_RESTART so accept is interrupted
+   struct sigaction sa = {}, old_int, old_term;
+   sa.sa_handler = compile_stop_handler;
+   sigemptyset(&sa.sa_mask);
+   sigaction(SIGINT, &sa, &old_int);
+   sigaction(SIGTERM, &sa, &old_term);
+
+   server_log(LOG_INFO, "listening on %s", path);
+
+   if (cb != NULL)
+      (*cb)(arg);
+
+   while (!compile_stop) {
+      const int fd = accept(sock, NULL, NULL);
+      if (fd < 0 && errno == EINTR)
+         continue;
+      else if (fd < 0)
+         fatal_errno("accept");
+
+      const pid_t pid = fork();
+      if (pid == 0) {
+         close(sock);
+         compile_serve_one(fd, fn, ctx);
+      }
+      else if (pid == -1)
+         server_log(LOG_ERROR, "fork: %s", last_os_error());
+
+      close(fd);
+
+      while (waitpid(-1, NULL, WNOHANG) > 0)
+         ;   // Reap finished requests
+   }
+
+   server_log(LOG_INFO, "stopping server");
+
+   close(sock);
+   unlink(path);
+
+   sigaction(SIGINT, &old_int, NULL);
+   sigaction(SIGTERM, &old_term, NULL);
+}
+
+int compile_client(const char *path, int argc, char **argv)
+{
+   struct sockaddr_un addr;
+   const int sock = compile_connect(path, &addr);
+
+   if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+      fatal_errno("cannot connect to server at %s", path);
+
+   char cwd[PATH_MAX];
+   if (getcwd(cwd, sizeof(cwd)) == NULL)
+      fatal_errno("getcwd");
+
+   json_t *args = json_array();
+   for (int i = 0; i < argc; i++)
+      json_array_append_new(args, json_string(argv[i]));
+
+   json_t *root = json_object();
+   json_object_set_new(root, "type", json_string("command"));
+   json_object_set_new(root, "cwd", json_string(cwd));
+   json_object_set_new(root, "color", json_boolean(color_terminal()));
+   json_object_set_new(root, "args", args);
+
+   char *str LOCAL = json_dumps(root, JSON_COMPACT);
+   json_decref(root);
+
+   send_fully(sock, str, strlen(str) + 1);
+
+   for (;;) {
+      uint8_t header[5];
+      if (!compile_recv_fully(sock, header, sizeof(header)))
+         fatal("server at %s closed the connection", path);
+
+      const uint32_t len = UNPACK_BE32(header + 1);
+      char *data LOCAL = xmalloc(MAX(len, 1));
+      if (!compile_recv_fully(sock, data, len))
+         fatal("server at %s closed the connection", path);
+
+      switch (header[0]) {
+      case COMPILE_STDOUT:
+         fwrite(data, len, 1, stdout);
+         fflush(stdout);
+         break;
+      case COMPILE_STDERR:
+         fwrite(data, len, 1, stderr);
+         break;
+      case COMPILE_EXIT:
+         if (len != 4)
+            fatal("malformed response from server at %s", path);
+
+         close(sock);
+         return UNPACK_BE32(data);
+      default:
+         fatal("malformed response from server at %s", path);
+      }
+   }
+}
+
+#else  // __MINGW32__
+
+void start_compile_server(const char *path, compile_fn_t fn, void *ctx,
+                          server_ready_fn_t cb, void *arg)
+{
+   fatal("the compile server is not supported on Windows");
+}
+
+int compile_client(const char *path, int argc, char **argv)
+{
+   fatal("the compile server is not supported on Windows");
+}
+
+#endif  // __MINGW32__
+
 ////////////////////////////////////////////////////////////////////////////////
 // Server event loop
 
@@ -1429,6 +2469,10 @@ void start_server(server_kind_t kind, jit_t *jit, tree_t top,
    server->banner    = !opt_get_int(OPT_UNIT_TEST);
    server->proto     = map[kind];
 
+   const char *trace_file = opt_get_str(OPT_TRACE_FILE);
+   if (trace_file != NULL)
+      server->trace = trace_open(trace_file);
+
    shell_handler_t handler = {
       .add_wave = add_wave_handler,
       .signal_update = signal_update_handler,
@@ -1491,6 +2535,9 @@ void start_server(server_kind_t kind, jit_t *jit, tree_t top,
 
    assert(server->sock == -1);
 
+   if (server->trace != NULL)
+      trace_close(server->trace);
+
    pb_free(server->packetbuf);
    shell_free(server->shell);
    (*server->proto->free_server)(server);
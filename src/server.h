@@ -27,16 +27,19 @@ typedef struct _web_socket web_socket_t;
 
 typedef enum {
    C2S_SHUTDOWN = 0x00,
+   C2S_QUERY_TRACE = 0x01,
+   C2S_DELTA_VALUES = 0x02,
 } c2s_opcode_t;
 
 typedef enum {
    S2C_ADD_WAVE = 0x00,
-   S2C_SIGNAL_UPDATE = 0x01,
    S2C_INIT_CMD = 0x02,
    S2C_START_SIM = 0x03,
    S2C_RESTART_SIM = 0x04,
    S2C_NEXT_TIME_STEP = 0x06,
    S2C_BACKCHANNEL = 0x07,
+   S2C_TRACE_DATA = 0x08,
+   S2C_SIGNAL_BATCH = 0x09,
 } s2c_opcode_t;
 
 typedef struct {
@@ -65,4 +68,10 @@ typedef enum {
 void start_server(server_kind_t kind, jit_t *jit, tree_t top,
                   server_ready_fn_t cb, void *arg, const char *init_cmd);
 
+typedef int (*compile_fn_t)(int, char **, void *);
+
+void start_compile_server(const char *path, compile_fn_t fn, void *ctx,
+                          server_ready_fn_t cb, void *arg);
+int compile_client(const char *path, int argc, char **argv);
+
 #endif   // _SERVER_H
@@ -56,6 +56,7 @@
 #define MIN_TAKE        8
 #define PARKING_BAYS    64
 #define SUSPEND_TIMEOUT 1
+#define SAFEPOINT_WAIT  50   // Microseconds before falling back to signals
 
 #if !defined __MINGW32__ && !defined __APPLE__
 #define POSIX_SUSPEND 1
@@ -211,8 +212,18 @@ typedef enum {
    MAIN_THREAD,
    USER_THREAD,
    WORKER_THREAD,
+   HELPER_THREAD,
 } thread_kind_t;
 
+typedef enum {
+   SP_RUNNING,     // Executing normally
+   SP_ARRIVING,    // Reached a safepoint and saving its registers
+   SP_PARKED,      // Waiting at a safepoint for start_world
+   SP_BLOCKED,     // Blocked in the runtime with registers saved
+   SP_STOPPED,     // Was blocked when the world stopped
+   SP_SUSPENDED,   // Suspended asynchronously by stop_world
+} safepoint_state_t;
+
 struct _nvc_thread {
    unsigned        id;
    thread_kind_t   kind;
@@ -223,6 +234,8 @@ struct _nvc_thread {
    void           *arg;
    int             victim;
    uint32_t        rngstate;
+   int             safepoint;
+   struct cpu_state cpu;
 #ifdef __MINGW32__
    HANDLE          handle;
    void           *retval;
@@ -268,12 +281,30 @@ static nvc_lock_t       stop_lock = 0;
 static stop_world_fn_t  stop_callback = NULL;
 static void            *stop_arg = NULL;
 
+static helper_fn_t      helper_fn = NULL;
+static void            *helper_arg = NULL;
+static int              helper_count = 0;
+static int              helper_done = 0;
+static unsigned         helper_gen = 0;
+static unsigned         helper_start[MAX_THREADS];
+static int              num_helpers = 0;
+
+int __nvc_safepoint_pending __attribute__((aligned(64))) = 0;
+
 #ifdef __MINGW32__
 static CONDITION_VARIABLE wake_workers = CONDITION_VARIABLE_INIT;
 static CRITICAL_SECTION   wakelock;
+static CONDITION_VARIABLE wake_helpers = CONDITION_VARIABLE_INIT;
+static CRITICAL_SECTION   helperlock;
+static CONDITION_VARIABLE safepoint_cond = CONDITION_VARIABLE_INIT;
+static CRITICAL_SECTION   safepoint_lock;
 #else
 static pthread_cond_t     wake_workers = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t    wakelock = PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP;
+static pthread_cond_t     wake_helpers = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t    helperlock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t     safepoint_cond = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t    safepoint_lock = PTHREAD_MUTEX_INITIALIZER;
 #endif
 
 #ifdef POSIX_SUSPEND
@@ -389,11 +420,16 @@ static void join_worker_threads(void)
    }
    platform_mutex_unlock(&wakelock);
 
+   platform_mutex_lock(&helperlock);
+   platform_cond_broadcast(&wake_helpers);
+   platform_mutex_unlock(&helperlock);
+
    for (int i = 0; i < join_list.count; i++) {
       nvc_thread_t *t = join_list.items[i];
 
       switch (relaxed_load(&t->kind)) {
       case WORKER_THREAD:
+      case HELPER_THREAD:
          thread_join(t);
          continue;  // Freed thread struct
       case USER_THREAD:
@@ -489,6 +525,10 @@ void thread_init(void)
 #ifdef __MINGW32__
    InitializeCriticalSectionAndSpinCount(&wakelock, LOCK_SPINS);
    InitializeConditionVariable(&wake_workers);
+   InitializeCriticalSectionAndSpinCount(&helperlock, LOCK_SPINS);
+   InitializeConditionVariable(&wake_helpers);
+   InitializeCriticalSectionAndSpinCount(&safepoint_lock, LOCK_SPINS);
+   InitializeConditionVariable(&safepoint_cond);
 
    for (int i = 0; i < PARKING_BAYS; i++) {
       parking_bay_t *bay = &(parking_bays[i]);
@@ -655,10 +695,55 @@ static inline parking_bay_t *parking_bay_for(void *cookie)
    return &(parking_bays[mix_bits_64(cookie) % PARKING_BAYS]);
 }
 
+static bool enter_blocking(void)
+{
+#if ASAN_ENABLED
+   // The stop_world callback would record the wrong fake stack
+   return false;
+#else
+   if (my_thread == NULL)
+      return false;
+
+   capture_registers(&(my_thread->cpu));
+
+   // Fails if stop_world is about to suspend this thread with a signal
+   return atomic_cas(&(my_thread->safepoint), SP_RUNNING, SP_BLOCKED);
+#endif
+}
+
+static void leave_blocking(bool blocked)
+{
+   if (!blocked)
+      return;
+   else if (atomic_cas(&(my_thread->safepoint), SP_BLOCKED, SP_RUNNING))
+      return;
+
+   // The world was stopped while this thread was blocked
+   platform_mutex_lock(&safepoint_lock);
+   {
+      while (!atomic_cas(&(my_thread->safepoint), SP_BLOCKED, SP_RUNNING))
+         platform_cond_wait(&safepoint_cond, &safepoint_lock);
+   }
+   platform_mutex_unlock(&safepoint_lock);
+}
+
+void thread_sleep_blocked(int usec)
+{
+   // Sleep without delaying stop_world: the caller must not touch the
+   // managed heap until this returns
+   const bool blocked = enter_blocking();
+   usleep(usec);
+   leave_blocking(blocked);
+}
+
 static void thread_park(void *cookie, park_fn_t fn)
 {
    parking_bay_t *bay = parking_bay_for(cookie);
 
+   // Must not hold the parking bay mutex when leaving the blocking
+   // region as the thread calling stop_world may need it
+   const bool blocked = enter_blocking();
+
    platform_mutex_lock(&(bay->mutex));
    {
       if ((*fn)(bay, cookie)) {
@@ -669,6 +754,8 @@ static void thread_park(void *cookie, park_fn_t fn)
       }
    }
    platform_mutex_unlock(&(bay->mutex));
+
+   leave_blocking(blocked);
 }
 
 static void thread_unpark(void *cookie, unpark_fn_t fn)
@@ -1097,12 +1184,16 @@ static void *worker_thread(void *arg)
       else if (my_thread->spins++ < 2)
          spin_wait();
       else {
+         const bool blocked = enter_blocking();
+
          platform_mutex_lock(&wakelock);
          {
             if (!relaxed_load(&should_stop))
                platform_cond_wait(&wake_workers, &wakelock);
          }
          platform_mutex_unlock(&wakelock);
+
+         leave_blocking(blocked);
       }
    } while (likely(!relaxed_load(&should_stop)));
 
@@ -1116,7 +1207,9 @@ static void create_workers(int needed)
    if (relaxed_load(&should_stop))
       return;
 
-   while (relaxed_load(&running_threads) < MIN(max_workers, needed)) {
+   // Helper threads only run while the world is stopped
+   while (relaxed_load(&running_threads) - relaxed_load(&num_helpers)
+          < MIN(max_workers, needed)) {
       static int counter = 0;
       char *name = xasprintf("worker thread %d", atomic_add(&counter, 1));
       SCOPED_LOCK(stop_lock);   // Avoid races with stop_world
@@ -1290,6 +1383,104 @@ static void suspend_handler(int sig, siginfo_t *info, void *context)
 }
 #endif
 
+void safepoint_slow(void)
+{
+   if (my_thread == NULL)
+      return;
+   else if (!atomic_cas(&(my_thread->safepoint), SP_RUNNING, SP_ARRIVING))
+      return;   // About to be suspended with a signal
+   else if (!atomic_load(&__nvc_safepoint_pending)) {
+      atomic_store(&(my_thread->safepoint), SP_RUNNING);
+      return;
+   }
+
+   struct cpu_state cpu;
+   capture_registers(&cpu);
+
+   stop_world_fn_t callback = atomic_load(&stop_callback);
+   void *arg = atomic_load(&stop_arg);
+
+   (*callback)(my_thread->id, &cpu, arg);
+
+   platform_mutex_lock(&safepoint_lock);
+   {
+      atomic_store(&(my_thread->safepoint), SP_PARKED);
+
+      while (relaxed_load(&(my_thread->safepoint)) == SP_PARKED)
+         platform_cond_wait(&safepoint_cond, &safepoint_lock);
+   }
+   platform_mutex_unlock(&safepoint_lock);
+}
+
+static void wait_for_safepoints(stop_world_fn_t callback, void *arg)
+{
+   // Threads running generated code poll __nvc_safepoint_pending at loop
+   // back-edges and calls and threads blocked in the runtime have
+   // already saved their registers: anything else that does not reach
+   // a safepoint quickly is marked to be suspended asynchronously
+   atomic_store(&__nvc_safepoint_pending, 1);
+
+   const uint64_t deadline = get_timestamp_us() + SAFEPOINT_WAIT;
+
+   const int maxthread = relaxed_load(&max_thread_id);
+   for (int i = 0; i <= maxthread; i++) {
+      nvc_thread_t *thread = atomic_load(&threads[i]);
+      if (thread == NULL || thread == my_thread)
+         continue;
+      else if (thread->kind == HELPER_THREAD)
+         continue;   // Never touches the heap outside stop_world
+
+      for (;;) {
+         const int state = atomic_load(&(thread->safepoint));
+         if (state == SP_PARKED)
+            break;
+         else if (state == SP_BLOCKED) {
+            if (atomic_cas(&(thread->safepoint), SP_BLOCKED, SP_STOPPED)) {
+               (*callback)(thread->id, &(thread->cpu), arg);
+               break;
+            }
+         }
+         else if (state == SP_RUNNING && get_timestamp_us() > deadline) {
+            if (atomic_cas(&(thread->safepoint), SP_RUNNING, SP_SUSPENDED))
+               break;
+         }
+         else
+            progressive_backoff();
+      }
+   }
+}
+
+static void release_safepoints(void)
+{
+   const int maxthread = relaxed_load(&max_thread_id);
+
+   platform_mutex_lock(&safepoint_lock);
+   {
+      atomic_store(&__nvc_safepoint_pending, 0);
+
+      for (int i = 0; i <= maxthread; i++) {
+         nvc_thread_t *thread = atomic_load(&threads[i]);
+         if (thread == NULL || thread == my_thread)
+            continue;
+
+         switch (relaxed_load(&(thread->safepoint))) {
+         case SP_PARKED:
+         case SP_SUSPENDED:
+            atomic_store(&(thread->safepoint), SP_RUNNING);
+            break;
+         case SP_STOPPED:
+            atomic_store(&(thread->safepoint), SP_BLOCKED);
+            break;
+         default:
+            break;
+         }
+      }
+
+      platform_cond_broadcast(&safepoint_cond);
+   }
+   platform_mutex_unlock(&safepoint_lock);
+}
+
 void stop_world(stop_world_fn_t callback, void *arg)
 {
    nvc_lock(&stop_lock);
@@ -1297,12 +1488,16 @@ void stop_world(stop_world_fn_t callback, void *arg)
    atomic_store(&stop_callback, callback);
    atomic_store(&stop_arg, arg);
 
+   wait_for_safepoints(callback, arg);
+
 #ifdef __MINGW32__
    const int maxthread = relaxed_load(&max_thread_id);
    for (int i = 0; i <= maxthread; i++) {
       nvc_thread_t *thread = atomic_load(&threads[i]);
       if (thread == NULL || thread == my_thread)
          continue;
+      else if (relaxed_load(&(thread->safepoint)) != SP_SUSPENDED)
+         continue;   // Stopped at a safepoint
 
       if (SuspendThread(thread->handle) != 0)
          fatal_errno("SuspendThread");
@@ -1323,6 +1518,8 @@ void stop_world(stop_world_fn_t callback, void *arg)
       nvc_thread_t *thread = atomic_load(&threads[i]);
       if (thread == NULL || thread == my_thread)
          continue;
+      else if (relaxed_load(&(thread->safepoint)) != SP_SUSPENDED)
+         continue;   // Stopped at a safepoint
 
       assert(thread->port != MACH_PORT_NULL);
 
@@ -1371,6 +1568,8 @@ void stop_world(stop_world_fn_t callback, void *arg)
       nvc_thread_t *thread = atomic_load(&threads[i]);
       if (thread == NULL || thread == my_thread)
          continue;
+      else if (relaxed_load(&(thread->safepoint)) != SP_SUSPENDED)
+         continue;   // Stopped at a safepoint
 
       PTHREAD_CHECK(pthread_kill, thread->handle, SIGSUSPEND);
       signalled++;
@@ -1407,6 +1606,8 @@ void start_world(void)
       nvc_thread_t *thread = atomic_load(&threads[i]);
       if (thread == NULL || thread == my_thread)
          continue;
+      else if (relaxed_load(&(thread->safepoint)) != SP_SUSPENDED)
+         continue;   // Stopped at a safepoint
 
       if (ResumeThread(thread->handle) != 1)
          fatal_errno("ResumeThread");
@@ -1416,6 +1617,8 @@ void start_world(void)
       nvc_thread_t *thread = atomic_load(&threads[i]);
       if (thread == NULL || thread == my_thread)
          continue;
+      else if (relaxed_load(&(thread->safepoint)) != SP_SUSPENDED)
+         continue;   // Stopped at a safepoint
 
       kern_return_t kern_result;
       do {
@@ -1433,6 +1636,8 @@ void start_world(void)
       nvc_thread_t *thread = atomic_load(&threads[i]);
       if (thread == NULL || thread == my_thread)
          continue;
+      else if (relaxed_load(&(thread->safepoint)) != SP_SUSPENDED)
+         continue;   // Stopped at a safepoint
 
       PTHREAD_CHECK(pthread_kill, thread->handle, SIGRESUME);
       signalled++;
@@ -1452,9 +1657,75 @@ void start_world(void)
    assert(sem_trywait(&stop_sem) == -1 && errno == EAGAIN);
 #endif
 
+   release_safepoints();
+
    nvc_unlock(&stop_lock);
 }
 
+static void *helper_thread(void *arg)
+{
+   const int id = (intptr_t)arg;
+   unsigned gen = load_acquire(&helper_start[id]);
+
+   for (;;) {
+      platform_mutex_lock(&helperlock);
+      {
+         while (relaxed_load(&helper_gen) == gen && !relaxed_load(&should_stop))
+            platform_cond_wait(&wake_helpers, &helperlock);
+      }
+      platform_mutex_unlock(&helperlock);
+
+      if (relaxed_load(&should_stop))
+         return NULL;
+
+      gen = load_acquire(&helper_gen);
+
+      const int count = relaxed_load(&helper_count);
+      if (id < count)
+         (*helper_fn)(id, count, helper_arg);
+
+      atomic_add(&helper_done, 1);
+   }
+}
+
+void stop_world_parallel(int max, helper_fn_t fn, void *arg)
+{
+   assert_lock_held(&stop_lock);
+
+   const int count = MAX(1, MIN(max, max_workers));
+
+   // The stop lock is already held so helper threads can be started
+   // here without racing with stop_world
+   while (num_helpers < count - 1) {
+      const int id = num_helpers + 1;
+      store_release(&helper_start[id], helper_gen);
+
+      char *name = xasprintf("helper thread %d", id);
+      nvc_thread_t *thread = thread_new(helper_thread, (void *)(intptr_t)id,
+                                        HELPER_THREAD, name);
+      thread_start(thread);
+      atomic_add(&num_helpers, 1);
+   }
+
+   const int nhelpers = relaxed_load(&num_helpers);
+
+   platform_mutex_lock(&helperlock);
+   {
+      helper_fn = fn;
+      helper_arg = arg;
+      relaxed_store(&helper_count, count);
+      relaxed_store(&helper_done, 0);
+      store_release(&helper_gen, helper_gen + 1);
+      platform_cond_broadcast(&wake_helpers);
+   }
+   platform_mutex_unlock(&helperlock);
+
+   (*fn)(0, count, arg);
+
+   while (load_acquire(&helper_done) < nhelpers)
+      spin_wait();
+}
+
 void thread_wx_mode(wx_mode_t mode)
 {
 #ifdef __APPLE__
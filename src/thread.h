@@ -59,6 +59,7 @@ void thread_init(void);
 int thread_id(void);
 bool thread_attached(void);
 void thread_sleep(int usec);
+void thread_sleep_blocked(int usec);
 
 typedef void *(*thread_fn_t)(void *);
 
@@ -111,6 +112,19 @@ typedef void (*stop_world_fn_t)(int, struct cpu_state *, void *);
 void stop_world(stop_world_fn_t callback, void *arg);
 void start_world(void);
 
+typedef void (*helper_fn_t)(int, int, void *);
+void stop_world_parallel(int max, helper_fn_t fn, void *arg);
+
+// Non-zero while stop_world is waiting for threads to reach a safepoint
+extern int __nvc_safepoint_pending;
+
+void safepoint_slow(void);
+
+#define safepoint_poll() do {                                 \
+      if (unlikely(relaxed_load(&__nvc_safepoint_pending)))   \
+         safepoint_slow();                                    \
+   } while (0)
+
 typedef enum { WX_WRITE, WX_EXECUTE } wx_mode_t;
 void thread_wx_mode(wx_mode_t mode);
 
@@ -467,10 +467,13 @@ struct _vlog_node {
    object_t object;
 };
 
+static item_map_t item_map[T_LAST_TREE_KIND];
+
 object_class_t tree_object = {
    .name           = "tree",
    .change_allowed = change_allowed,
    .has_map        = has_map,
+   .item_map       = item_map,
    .kind_text_map  = kind_text_map,
    .tag            = OBJECT_TAG_TREE,
    .last_kind      = T_LAST_TREE_KIND,
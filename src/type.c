@@ -95,10 +95,13 @@ struct _tree {
    object_t object;
 };
 
+static item_map_t item_map[T_LAST_TYPE_KIND];
+
 object_class_t type_object = {
    .name           = "type",
    .change_allowed = change_allowed,
    .has_map        = has_map,
+   .item_map       = item_map,
    .kind_text_map  = kind_text_map,
    .tag            = OBJECT_TAG_TYPE,
    .last_kind      = T_LAST_TYPE_KIND
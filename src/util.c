@@ -1910,6 +1910,28 @@ void *map_file(int fd, size_t size)
    return ptr;
 }
 
+void *map_shared_file(int fd, size_t size)
+{
+   // Writable mapping visible to other processes mapping the same file
+#ifdef __MINGW32__
+   HANDLE handle = CreateFileMapping((HANDLE) _get_osfhandle(fd), NULL,
+                                     PAGE_READWRITE, 0, size, NULL);
+   if (!handle)
+      fatal_errno("CreateFileMapping");
+
+   void *ptr = MapViewOfFileEx(handle, FILE_MAP_ALL_ACCESS, 0,
+                               0, (SIZE_T) size, (LPVOID) NULL);
+   CloseHandle(handle);
+   if (ptr == NULL)
+      fatal_errno("MapViewOfFileEx");
+#else
+   void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (ptr == MAP_FAILED)
+      fatal_errno("mmap");
+#endif
+   return ptr;
+}
+
 void unmap_file(void *ptr, size_t size)
 {
 #ifdef __MINGW32__
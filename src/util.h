@@ -387,6 +387,7 @@ void file_write_lock(int fd);
 void file_unlock(int fd);
 
 void *map_file(int fd, size_t size);
+void *map_shared_file(int fd, size_t size);
 void unmap_file(void *ptr, size_t size);
 void get_libexec_dir(text_buf_t *tb);
 void get_lib_dir(text_buf_t *tb);
@@ -100,6 +100,7 @@ typedef struct tag_abstractRegion {
    vhpiStringT       FullCaseName;
    vhpiStringT       FullName;
    jit_handle_t      handle;
+   shash_t          *names;
 } c_abstractRegion;
 
 typedef struct {
@@ -494,6 +495,7 @@ typedef struct {
    vhpiCbDataT   data;
    vhpiHandleT   handle;
    rt_watch_t   *watch;
+   bool          pending;
 } c_callback;
 
 DEF_CLASS(callback, vhpiCallbackK, refcounted.object);
@@ -529,7 +531,10 @@ typedef enum {
 
 typedef struct {
    c_vhpiObject *obj;
-   handle_kind_t kind;
+   union {
+      handle_kind_t kind;        // When in use
+      uint32_t      next_free;   // Free list link when obj is NULL
+   };
    uint32_t      generation;
 } handle_slot_t;
 
@@ -546,13 +551,17 @@ typedef struct _vhpi_context {
    jit_t           *jit;
    handle_slot_t   *handles;
    unsigned         num_handles;
-   unsigned         free_hint;
+   uint32_t         free_list;    // Index of first free slot plus one
    vhpiObjectListT  foreignfs;
    jit_scalar_t    *args;
    tlab_t          *tlab;
    vhpiHandleListT  callbacks;
+   vhpiHandleListT  batch;
+   bool             batch_scheduled;
+   A(vhpiValueChangeT) changes;
    mem_pool_t      *pool;
    vhpiObjectListT  recycle;
+   vhpiObjectListT  indexed;
 } vhpi_context_t;
 
 static c_typeDecl *cached_typeDecl(type_t type, c_vhpiObject *obj);
@@ -614,36 +623,38 @@ static vhpiHandleT handle_for(c_vhpiObject *obj, handle_kind_t kind)
 
    vhpi_context_t *c = vhpi_context();
 
-   uint32_t index = c->free_hint;
-   if (index >= c->num_handles || c->handles[index].obj != NULL) {
-      for (index = 0; index < c->num_handles; index++) {
-         if (c->handles[index].obj == NULL
-             && c->handles[index].generation < HANDLE_MAX_INDEX)
-            break;
-      }
+   uint32_t index;
+   if (c->free_list > 0) {
+      index = c->free_list - 1;
+      c->free_list = c->handles[index].next_free;
    }
-
-   if (unlikely(index > HANDLE_MAX_INDEX)) {
+   else if (unlikely(c->num_handles >= HANDLE_MAX_INDEX)) {
       vhpi_error(vhpiFailure, NULL, "too many active handles");
       return NULL;
    }
-   else if (index == c->num_handles) {
+   else {
+      index = c->num_handles;
+
       const int new_size = MAX(c->num_handles * 2, 128);
       c->handles = xrealloc_array(c->handles, new_size, sizeof(handle_slot_t));
       c->num_handles = new_size;
 
-      for (int i = index; i < new_size; i++) {
+      // Thread the new slots after the one being returned onto the
+      // free list in ascending order
+      for (int i = index + 1; i < new_size; i++) {
          c->handles[i].obj = NULL;
+         c->handles[i].next_free = i + 1 < new_size ? i + 2 : 0;
          c->handles[i].generation = 1;
       }
+
+      c->handles[index].generation = 1;
+      c->free_list = index + 2;
    }
 
    handle_slot_t *slot = &(c->handles[index]);
    slot->obj  = obj;
    slot->kind = kind;
 
-   c->free_hint = index + 1;
-
    c_refcounted *rc = is_refcounted(obj);
    if (rc != NULL)
       rc->refcount++;
@@ -671,7 +682,10 @@ static void drop_handle(vhpi_context_t *c, vhpiHandleT handle)
    slot->obj = NULL;
    slot->generation++;
 
-   c->free_hint = slot - c->handles;
+   if (slot->generation < HANDLE_MAX_INDEX) {
+      slot->next_free = c->free_list;
+      c->free_list = slot - c->handles + 1;
+   }
 
    c_refcounted *rc = is_refcounted(obj);
    if (rc != NULL) {
@@ -1565,6 +1579,100 @@ static void vhpi_signal_event_cb(uint64_t now, rt_signal_t *signal,
    (cb->data.cb_rtn)(&(cb->data));
 }
 
+static c_callback *batch_callback(vhpi_context_t *c, vhpiHandleT handle)
+{
+   handle_slot_t *slot = decode_handle(c, handle);
+   if (slot == NULL)
+      return NULL;   // Removed since the event
+
+   return is_callback(slot->obj);
+}
+
+static void vhpi_batch_cb(rt_model_t *m, void *user)
+{
+   vhpi_context_t *c = user;
+   c->batch_scheduled = false;
+
+   vhpiTimeT time;
+   vhpi_get_time(&time, NULL);
+
+   // Make one call for each distinct callback function in the order the
+   // first event for it was recorded: callbacks registered or events
+   // recorded by the user function are picked up by the same loop
+   for (int i = 0; i < c->batch.count; i++) {
+      c_callback *first = batch_callback(c, c->batch.items[i]);
+      if (first == NULL)
+         continue;
+
+      void (*fn)(const vhpiCbDataT *) = first->data.cb_rtn;
+
+      ATRIM(c->changes, 0);
+
+      for (int j = i; j < c->batch.count; j++) {
+         c_callback *cb = batch_callback(c, c->batch.items[j]);
+         if (cb == NULL || cb->data.cb_rtn != fn)
+            continue;
+
+         cb->pending = false;
+         c->batch.items[j] = NULL;
+
+         if (cb->State != vhpiEnable)
+            continue;
+
+         if (cb->data.value != NULL)
+            vhpi_get_value(cb->data.obj, cb->data.value);
+
+         const vhpiValueChangeT change = {
+            .obj       = cb->data.obj,
+            .value     = cb->data.value,
+            .user_data = cb->data.user_data,
+         };
+         APUSH(c->changes, change);
+      }
+
+      if (c->changes.count == 0)
+         continue;
+
+      vhpiValueT value = {
+         .format    = vhpiPtrVal,
+         .bufSize   = c->changes.count * sizeof(vhpiValueChangeT),
+         .numElems  = c->changes.count,
+         .value.ptr = c->changes.items,
+      };
+
+      vhpiCbDataT data = {
+         .reason = vhpiCbValueChangeBatch,
+         .cb_rtn = fn,
+         .time   = &time,
+         .value  = &value,
+      };
+
+      (*fn)(&data);
+   }
+
+   ATRIM(c->batch, 0);
+}
+
+static void vhpi_batch_event_cb(uint64_t now, rt_signal_t *signal,
+                                rt_watch_t *watch, void *user)
+{
+   vhpi_context_t *c = vhpi_context();
+
+   c_callback *cb = batch_callback(c, user);
+   if (cb == NULL || cb->State != vhpiEnable || cb->pending)
+      return;
+
+   // Defer the call until the end of the time step when all the
+   // changes can be delivered together
+   cb->pending = true;
+   APUSH(c->batch, cb->handle);
+
+   if (!c->batch_scheduled) {
+      model_set_phase_cb(c->model, END_TIME_STEP, vhpi_batch_cb, c);
+      c->batch_scheduled = true;
+   }
+}
+
 static void vhpi_global_cb(rt_model_t *m, void *user)
 {
    vhpiHandleT handle = user;
@@ -2058,6 +2166,54 @@ static bool vhpi_name_cmp(c_vhpiObject *obj, const char *str)
    return strcasecmp((char *)vhpi_get_case_name(obj), str) == 0;
 }
 
+static char *upper_key(const char *name)
+{
+   char *key = xstrdup(name);
+   for (char *p = key; *p; p++)
+      *p = toupper_iso88591(*p);
+
+   return key;
+}
+
+static void region_index_name(c_abstractRegion *r, c_vhpiObject *obj)
+{
+   const char *name = (char *)vhpi_get_case_name(obj);
+   if (name == NULL)
+      return;
+
+   char *key LOCAL = upper_key(name);
+
+   // The first declaration with a given name takes precedence
+   if (shash_get(r->names, key) == NULL)
+      shash_put(r->names, key, obj);
+}
+
+static c_vhpiObject *region_find_name(c_abstractRegion *r, const char *name)
+{
+   if (r->names == NULL) {
+      // Build the index on the first lookup as regions are usually
+      // searched many times by name or not at all
+      vhpiObjectListT *decls = expand_lazy_list(&(r->object), &(r->decls));
+      vhpiObjectListT *stmts = expand_lazy_list(&(r->object), &(r->stmts));
+
+      r->names = shash_new(MAX(16, (decls->count + stmts->count) * 2));
+
+      for (int i = 0; i < decls->count; i++)
+         region_index_name(r, decls->items[i]);
+
+      for (int i = 0; i < stmts->count; i++) {
+         if (is_abstractRegion(stmts->items[i]) != NULL)
+            region_index_name(r, stmts->items[i]);
+      }
+
+      APUSH(vhpi_context()->indexed, &(r->object));
+   }
+
+   char *key LOCAL = upper_key(name);
+
+   return shash_get(r->names, key);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Public API
 
@@ -2179,6 +2335,7 @@ vhpiHandleT vhpi_register_cb(vhpiCbDataT *cb_data_p, int32_t flags)
       }
 
    case vhpiCbValueChange:
+   case vhpiCbValueChangeBatch:
       {
          c_vhpiObject *obj = from_handle(cb_data_p->obj);
          if (obj == NULL)
@@ -2219,8 +2376,11 @@ vhpiHandleT vhpi_register_cb(vhpiCbDataT *cb_data_p, int32_t flags)
          const int slots = scope != NULL ? vhpi_count_subsignals(m, scope) : 1;
 
          cb->handle = internal_handle_for(&(cb->refcounted.object));
-         cb->watch = watch_new(m, vhpi_signal_event_cb, cb->handle,
-                               WATCH_EVENT, slots);
+         sig_event_fn_t fn = vhpi_signal_event_cb;
+         if (cb->Reason == vhpiCbValueChangeBatch)
+            fn = vhpi_batch_event_cb;
+
+         cb->watch = watch_new(m, fn, cb->handle, WATCH_EVENT, slots);
 
          if (signal != NULL)
             cb->watch = model_set_event_cb(m, signal, cb->watch);
@@ -2257,7 +2417,8 @@ int vhpi_remove_cb(vhpiHandleT handle)
 
    vhpi_context_t *c = vhpi_context();
 
-   if (cb->Reason == vhpiCbValueChange) {
+   if (cb->Reason == vhpiCbValueChange
+       || cb->Reason == vhpiCbValueChangeBatch) {
       watch_free(c->model, cb->watch);
       cb->watch = NULL;
 
@@ -2549,25 +2710,10 @@ vhpiHandleT vhpi_handle_by_name(const char *name, vhpiHandleT scope)
       c_iterator it = {};
       c_abstractRegion *region = is_abstractRegion(where);
       if (region != NULL) {
-         vhpiObjectListT *decls = expand_lazy_list(where, &(region->decls));
-         for (int i = 0; i < decls->count; i++) {
-            if (vhpi_name_cmp(decls->items[i], elem)) {
-               where = decls->items[i];
-               found = true;
-               break;
-            }
-         }
-
-         if (!found) {
-            vhpiObjectListT *stmts = expand_lazy_list(where, &(region->stmts));
-            for (int i = 0; i < stmts->count; i++) {
-               c_abstractRegion *r = is_abstractRegion(stmts->items[i]);
-               if (r != NULL && vhpi_name_cmp(stmts->items[i], elem)) {
-                  where = &(r->object);
-                  found = true;
-                  break;
-               }
-            }
+         c_vhpiObject *child = region_find_name(region, elem);
+         if (child != NULL) {
+            where = child;
+            found = true;
          }
       }
       else if (init_iterator(&it, vhpiSelectedNames, where)) {
@@ -3429,6 +3575,73 @@ int vhpi_get_value(vhpiHandleT expr, vhpiValueT *value_p)
    }
 }
 
+DLLEXPORT
+int vhpi_get_value_view(vhpiHandleT object, vhpiValueViewT *view_p)
+{
+   vhpi_clear_error();
+
+   VHPI_TRACE("object=%s view_p=%p", handle_pp(object), view_p);
+
+   c_vhpiObject *obj = from_handle(object);
+   if (obj == NULL)
+      return -1;
+
+   switch (vhpi_get_prefix_kind(obj)) {
+   case vhpiSigDeclK:
+   case vhpiPortDeclK:
+      break;
+   default:
+      vhpi_error(vhpiError, &(obj->loc), "class kind %s cannot be used with "
+                 "vhpi_get_value_view", vhpi_class_str(obj->kind));
+      return -1;
+   }
+
+   int offset = 0;
+   rt_signal_t *signal;
+   c_typeDecl *td;
+   c_prefixedName *pn = is_prefixedName(obj);
+   if (pn != NULL) {
+      td = pn->name.expr.Type;
+
+      c_indexedName *in = is_indexedName(obj);
+      if (in != NULL)
+         offset = in->offset;
+
+      if (!td->homogeneous)
+         signal = NULL;
+      else if ((signal = vhpi_get_signal_prefixedName(pn)) == NULL)
+         return -1;
+   }
+   else {
+      c_objDecl *decl = cast_objDecl(obj);
+      if (decl == NULL)
+         return -1;
+
+      td = decl->Type;
+
+      if (!td->homogeneous)
+         signal = NULL;
+      else if ((signal = vhpi_get_signal_objDecl(decl)) == NULL)
+         return -1;
+   }
+
+   if (signal == NULL || td->format == (vhpiFormatT)-1) {
+      vhpi_error(vhpiError, &(obj->loc), "type %s does not have a contiguous "
+                 "value representation", type_pp(td->type));
+      return -1;
+   }
+
+   const int size = signal_size(signal);
+
+   view_p->data       = signal_value(signal) + offset * size;
+   view_p->format     = td->format;
+   view_p->numElems   = td->numElems;
+   view_p->elemSize   = size;
+   view_p->generation = signal_generation(signal);
+
+   return 0;
+}
+
 DLLEXPORT
 int vhpi_put_value(vhpiHandleT handle,
                    vhpiValueT *value_p,
@@ -5172,10 +5385,18 @@ void vhpi_context_free(vhpi_context_t *c)
    for (int i = 0; i < c->callbacks.count; i++)
       drop_handle(c, c->callbacks.items[i]);
    ACLEAR(c->callbacks);
+   ACLEAR(c->batch);
+   ACLEAR(c->changes);
 
    ACLEAR(c->packages);
    ACLEAR(c->recycle);
 
+   for (int i = 0; i < c->indexed.count; i++) {
+      c_abstractRegion *r = is_abstractRegion(c->indexed.items[i]);
+      shash_free(r->names);
+   }
+   ACLEAR(c->indexed);
+
    if (opt_get_int(OPT_PLI_DEBUG))
       vhpi_check_leaks(c);
 
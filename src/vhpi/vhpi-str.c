@@ -497,6 +497,7 @@ const char *vhpi_cb_reason_str(int reason)
    case vhpiCbSigInterrupt: return "vhpiCbSigInterrupt";
    case vhpiCbTimeOut: return "vhpiCbTimeOut";
    case vhpiCbRepTimeOut: return "vhpiCbRepTimeOut";
+   case vhpiCbValueChangeBatch: return "vhpiCbValueChangeBatch";
    case vhpiCbSensitivity: return "vhpiCbSensitivity";
    default: return vhpi_fallback_str(reason);
    }
@@ -976,6 +976,33 @@ typedef struct vhpiCbDataS
 #define vhpiCbRepTimeOut           1048 /* repetitive */
 #define vhpiCbSensitivity          1049 /* repetitive */
 
+/* NVC extension: registered per object like vhpiCbValueChange but at
+   the end of each time step with events the callback function is
+   called once with value->format set to vhpiPtrVal, value->numElems
+   set to the number of changes, and value->value.ptr pointing to an
+   array of vhpiValueChangeT */
+#define vhpiCbValueChangeBatch     1100 /* repetitive */
+
+typedef struct vhpiValueChangeS
+{
+  vhpiHandleT obj;             /* object with an event */
+  vhpiValueT *value;           /* value from registration, now updated */
+  void *user_data;             /* user data from registration */
+} vhpiValueChangeT;
+
+/* NVC extension: describes the storage of a signal's effective value
+   which remains valid and is updated in place for the rest of the
+   simulation */
+typedef struct vhpiValueViewS
+{
+  const void *data;            /* first element of the effective value */
+  vhpiFormatT format;          /* format of the value as vhpi_get_value */
+  int32_t numElems;            /* number of scalar elements */
+  size_t elemSize;             /* size of each element in bytes */
+  const uint32_t *generation;  /* incremented on every event on the
+                                  signal containing this value */
+} vhpiValueViewT;
+
 /************************* CALLBACK FLAGS ***************************/
 #define vhpiReturnCb  0x00000001
 #define vhpiDisableCb 0x00000010
@@ -1079,6 +1106,10 @@ typedef enum {
 XXTERN int vhpi_get_value (vhpiHandleT expr,
                            vhpiValueT *value_p);
 
+/* NVC extension */
+XXTERN int vhpi_get_value_view (vhpiHandleT object,
+                                vhpiValueViewT *view_p);
+
 XXTERN int vhpi_put_value (vhpiHandleT object,
                            vhpiValueT *value_p,
                            vhpiPutValueModeT mode);
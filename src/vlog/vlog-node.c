@@ -342,10 +342,13 @@ static const change_allowed_t change_allowed[] = {
    { -1, -1 }
 };
 
+static item_map_t item_map[V_LAST_NODE_KIND];
+
 object_class_t vlog_object = {
    .name           = "vlog",
    .change_allowed = change_allowed,
    .has_map        = has_map,
+   .item_map       = item_map,
    .kind_text_map  = kind_text_map,
    .tag            = OBJECT_TAG_VLOG,
    .last_kind      = V_LAST_NODE_KIND,
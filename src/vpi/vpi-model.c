@@ -74,6 +74,8 @@ typedef struct {
    vlog_node_t  where;
    jit_handle_t handle;
    vpiLazyList  decls;
+   vpiLazyList  nets;
+   vpiLazyList  regs;
 } c_abstractScope;
 
 typedef struct {
@@ -175,9 +177,12 @@ typedef enum {
 } handle_kind_t;
 
 typedef struct {
-   c_vpiObject  *obj;
-   handle_kind_t kind;
-   uint32_t      generation;
+   c_vpiObject *obj;
+   union {
+      handle_kind_t kind;        // Valid when allocated
+      uint32_t      next_free;   // Index plus one of next free slot
+   };
+   uint32_t     generation;
 } handle_slot_t;
 
 STATIC_ASSERT(sizeof(handle_slot_t) <= 16);
@@ -190,7 +195,7 @@ typedef struct _vpi_context {
    jit_t         *jit;
    handle_slot_t *handles;
    unsigned       num_handles;
-   unsigned       free_hint;
+   uint32_t       free_list;
    vpiHandleList  systasks;
    vpiObjectList  syscalls;
    c_sysTfCall   *call;
@@ -203,6 +208,8 @@ typedef struct _vpi_context {
 
 static c_vpiObject *build_expr(vlog_node_t v, c_abstractScope *scope);
 static void vpi_lazy_decls(c_vpiObject *obj);
+static void vpi_lazy_nets(c_vpiObject *obj);
+static void vpi_lazy_regs(c_vpiObject *obj);
 static c_refcounted *is_refcounted(c_vpiObject *obj);
 
 static vpi_context_t *global_context = NULL;   // TODO: thread local
@@ -243,36 +250,37 @@ static vpiHandle handle_for(c_vpiObject *obj, handle_kind_t kind)
 
    vpi_context_t *c = vpi_context();
 
-   uint32_t index = c->free_hint;
-   if (index >= c->num_handles || c->handles[index].obj != NULL) {
-      for (index = 0; index < c->num_handles; index++) {
-         if (c->handles[index].obj == NULL
-             && c->handles[index].generation < HANDLE_MAX_INDEX)
-            break;
+   if (c->free_list == 0) {
+      const uint32_t old_size = c->num_handles;
+      if (unlikely(old_size > HANDLE_MAX_INDEX)) {
+         vpi_error(vpiSystem, NULL, "too many active handles");
+         return NULL;
       }
-   }
 
-   if (unlikely(index > HANDLE_MAX_INDEX)) {
-      vpi_error(vpiSystem, NULL, "too many active handles");
-      return NULL;
-   }
-   else if (index == c->num_handles) {
-      const int new_size = MAX(c->num_handles * 2, 128);
+      const int new_size = MAX(old_size * 2, 128);
       c->handles = xrealloc_array(c->handles, new_size, sizeof(handle_slot_t));
       c->num_handles = new_size;
 
-      for (int i = index; i < new_size; i++) {
+      // Thread the new slots onto the free list in ascending order
+      for (int i = old_size; i < new_size; i++) {
          c->handles[i].obj = NULL;
+         c->handles[i].next_free = i + 1 < new_size ? i + 2 : 0;
          c->handles[i].generation = 1;
       }
+
+      c->free_list = old_size + 1;
    }
 
+   const uint32_t index = c->free_list - 1;
+
    handle_slot_t *slot = &(c->handles[index]);
+   assert(slot->obj == NULL);
+
+   c->free_list = slot->next_free;
+
    slot->obj  = obj;
    slot->kind = kind;
 
-   c->free_hint = index + 1;
-
    c_refcounted *rc = is_refcounted(obj);
    if (rc != NULL)
       rc->refcount++;
@@ -300,7 +308,12 @@ static void drop_handle(vpi_context_t *c, vpiHandle handle)
    slot->obj = NULL;
    slot->generation++;
 
-   c->free_hint = slot - c->handles;
+   // Retire the slot once the generation counter is exhausted so stale
+   // handles can never alias a new object
+   if (slot->generation < HANDLE_MAX_INDEX) {
+      slot->next_free = c->free_list;
+      c->free_list = slot - c->handles + 1;
+   }
 
    c_refcounted *rc = is_refcounted(obj);
    if (rc != NULL) {
@@ -368,6 +381,7 @@ static c_abstractScope *is_abstractScope(c_vpiObject *obj)
 {
    switch (obj->type) {
    case vpiModule:
+   case vpiGenScope:
       return container_of(obj, c_abstractScope, object);
    default:
       return NULL;
@@ -416,11 +430,12 @@ static void *recyle_object(size_t size, PLI_INT32 type)
 {
    vpi_context_t *c = vpi_context();
 
-   for (int i = 0; i < c->recycle.count; i++) {
+   // Search from the end as the most recently freed object is usually
+   // an iterator of the same type when scanning in a loop
+   for (int i = c->recycle.count - 1; i >= 0; i--) {
       c_vpiObject *obj = c->recycle.items[i];
       if (obj->type == type) {
-         for (int j = i; j < c->recycle.count - 1; j++)
-            c->recycle.items[j] = c->recycle.items[j + 1];
+         c->recycle.items[i] = c->recycle.items[c->recycle.count - 1];
          ATRIM(c->recycle, c->recycle.count - 1);
 
          memset(obj, '\0', size);
@@ -514,6 +529,8 @@ static void init_abstractScope(c_abstractScope *scope, vlog_node_t v)
    scope->where      = v;
    scope->handle     = JIT_HANDLE_INVALID;
    scope->decls.fn   = vpi_lazy_decls;
+   scope->nets.fn    = vpi_lazy_nets;
+   scope->regs.fn    = vpi_lazy_regs;
 }
 
 static void build_net(vlog_node_t v, c_abstractScope *scope)
@@ -526,7 +543,7 @@ static void build_net(vlog_node_t v, c_abstractScope *scope)
 
 static void build_reg(vlog_node_t v, c_abstractScope *scope)
 {
-   c_reg *reg = new_object(sizeof(c_reg), vpiNet);
+   c_reg *reg = new_object(sizeof(c_reg), vpiReg);
    init_abstractDecl(&(reg->decl), v, scope);
 
    vpi_list_add(&scope->decls.list, &(reg->decl.object));
@@ -653,6 +670,20 @@ static bool init_iterator(c_iterator *it, PLI_INT32 type, c_vpiObject *obj)
       }
    }
 
+   c_abstractScope *scope = obj ? is_abstractScope(obj) : NULL;
+   if (scope != NULL) {
+      switch (type) {
+      case vpiNet:
+         it->list = expand_lazy_list(obj, &(scope->nets));
+         return true;
+      case vpiReg:
+         it->list = expand_lazy_list(obj, &(scope->regs));
+         return true;
+      default:
+         return false;
+      }
+   }
+
    return false;
 }
 
@@ -708,6 +739,24 @@ static c_abstractScope *cached_scope(tree_t block, rt_scope_t *s)
    return as;
 }
 
+static c_module *enclosing_module(c_abstractScope *scope)
+{
+   // Generate scopes are nested inside the module instance
+   for (;;) {
+      c_module *m = is_module(&(scope->object));
+      if (m != NULL)
+         return m;
+
+      c_genScope *g = cast_genScope(&(scope->object));
+
+      rt_scope_t *parent = g->rtscope->parent;
+      if (parent == NULL)
+         return NULL;
+
+      scope = cached_scope(parent->where, parent);
+   }
+}
+
 static jit_t *vpi_get_jit(vpi_context_t *c)
 {
    if (c->jit != NULL)
@@ -761,6 +810,43 @@ static void vpi_lazy_decls(c_vpiObject *obj)
    }
 }
 
+static void vpi_filter_decls(c_abstractScope *s, vpiObjectList *list,
+                             PLI_INT32 type)
+{
+   // Cache the subset of declarations with the given type so repeated
+   // iteration does not have to filter the full list each time
+   vpiObjectList *decls = expand_lazy_list(&(s->object), &(s->decls));
+
+   int count = 0;
+   for (int i = 0; i < decls->count; i++) {
+      if (decls->items[i]->type == type)
+         count++;
+   }
+
+   vpi_list_reserve(list, count);
+
+   for (int i = 0; i < decls->count; i++) {
+      if (decls->items[i]->type == type)
+         vpi_list_add(list, decls->items[i]);
+   }
+}
+
+static void vpi_lazy_nets(c_vpiObject *obj)
+{
+   c_abstractScope *s = is_abstractScope(obj);
+   assert(s != NULL);
+
+   vpi_filter_decls(s, &(s->nets.list), vpiNet);
+}
+
+static void vpi_lazy_regs(c_vpiObject *obj)
+{
+   c_abstractScope *s = is_abstractScope(obj);
+   assert(s != NULL);
+
+   vpi_filter_decls(s, &(s->regs.list), vpiReg);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Public API
 
@@ -824,6 +910,36 @@ vpiHandle vpi_handle(PLI_INT32 type, vpiHandle refHandle)
          else
             return NULL;
       }
+
+      return NULL;
+   }
+
+   c_vpiObject *obj = from_handle(refHandle);
+   if (obj == NULL)
+      return NULL;
+
+   c_tfCall *call = is_tfCall(obj);
+   if (call != NULL) {
+      switch (type) {
+      case vpiScope:
+         return user_handle_for(&(call->scope->object));
+      }
+   }
+
+   c_abstractDecl *decl = is_abstractDecl(obj);
+   if (decl != NULL) {
+      switch (type) {
+      case vpiScope:
+         return user_handle_for(&(decl->scope->object));
+      case vpiModule:
+         {
+            c_module *m = enclosing_module(decl->scope);
+            if (m == NULL)
+               return NULL;
+
+            return user_handle_for(&(m->scope.object));
+         }
+      }
    }
 
    return NULL;
@@ -842,6 +958,7 @@ vpiHandle vpi_iterate(PLI_INT32 type, vpiHandle refHandle)
 
    c_iterator *it = recyle_object(sizeof(c_iterator), vpiIterator);
    if (!init_iterator(it, type, obj)) {
+      APUSH(vpi_context()->recycle, &(it->refcounted.object));
       vpi_error(vpiError, obj ? &(obj->loc) : NULL,
                 "relation %s not supported for handle %s",
                 vpi_method_str(type), handle_pp(refHandle));
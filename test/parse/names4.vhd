@@ -0,0 +1,31 @@
+package names4 is
+    type t is (a, b);
+    function "+" (l, r : t) return t;
+end package;
+
+package body names4 is
+    function "+" (l, r : t) return t is
+    begin
+        return l;
+    end function;
+
+    function f1 (x : integer) return integer is
+    begin
+        return x + x;                   -- Predefined "+"
+    end function;
+
+    function "+" (l, r : integer) return integer is
+    begin
+        return l;
+    end function;
+
+    function f2 (x : integer) return integer is
+    begin
+        return x + x;                   -- Hides predefined "+"
+    end function;
+
+    function f3 (x : t) return t is
+    begin
+        return x + x;
+    end function;
+end package body;
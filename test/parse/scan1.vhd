@@ -0,0 +1,7 @@
+package scan1 is
+    constant C1 : integer := 16#ff#;  constant C2 : integer := 42;
+    constant C3 : bit_vector := X"0f";  constant C4 : string := "a""b";
+    constant \ext\ : integer := 1_000;  constant C5 : real := 1.5;
+    constant C6 : integer := 7;         -- pragma foo
+    constant C7 : integer := C6 + C1;
+end package;
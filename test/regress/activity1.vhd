@@ -0,0 +1,35 @@
+entity activity1 is
+end entity;
+
+architecture test of activity1 is
+    signal clk   : bit := '0';
+    signal count : natural := 0;
+    signal quiet : bit := '0';
+begin
+
+    clkgen: process is
+    begin
+        for i in 1 to 10 loop
+            clk <= not clk;
+            wait for 5 ns;
+        end loop;
+        wait;
+    end process;
+
+    counter: process (clk) is
+    begin
+        if clk = '1' then
+            count <= count + 1;
+        end if;
+        quiet <= '0';                   -- Transaction but never an event
+    end process;
+
+    check: process is
+    begin
+        wait for 50 ns;
+        assert count = 5;
+        assert quiet = '0';
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,28 @@
+set -xe
+
+nvc -a $TESTDIR/regress/activity1.vhd -e activity1 \
+    -r --profile-activity=activity2.json
+
+# Check the structure of the JSON profile and the exact counters, the
+# order of processes depends on their execution time
+test "$(head -n1 activity2.json)" = "{"
+test "$(tail -n1 activity2.json)" = "}"
+grep -Fx '  "signals": [' activity2.json
+grep -Fx '  ],' activity2.json
+grep -Fx '  "processes": [' activity2.json
+grep -Fx '  ]' activity2.json
+
+grep -Fx '    { "name": ":activity1:clk", "transactions": 10, "events": 10 },' \
+     activity2.json
+grep -Fx '    { "name": ":activity1:count", "transactions": 5, "events": 5 },' \
+     activity2.json
+grep -Fx '    { "name": ":activity1:quiet", "transactions": 11, "events": 0 }' \
+     activity2.json
+
+grep -F '{ "name": ":activity1:clkgen", "wakeups": 0, "runs": 11, ' \
+     activity2.json
+grep -F '{ "name": ":activity1:counter", "wakeups": 10, "runs": 11, ' \
+     activity2.json
+grep -F '{ "name": ":activity1:check", "wakeups": 0, "runs": 2, ' \
+     activity2.json
+test "$(grep -c '"time_ns": [0-9]* }' activity2.json)" = 3
@@ -0,0 +1,49 @@
+library nvc;
+use nvc.channel.all;
+
+entity channel1 is
+end entity;
+
+architecture test of channel1 is
+begin
+
+    process is
+        variable ch    : t_channel;
+        variable buf   : t_word_vector(1 to 4);
+        variable len   : natural;
+        variable valid : boolean;
+    begin
+        ch := channel_open("channel1.q", depth => 4, width => 4);
+
+        channel_try_recv(ch, buf, len, valid);
+        assert not valid;
+
+        for i in 1 to 4 loop
+            assert channel_try_send(ch, (i, i * 2));
+        end loop;
+        assert not channel_try_send(ch, (0 => 5));   -- Full
+
+        wait for 1 ns;                  -- Model runs at end of time step
+
+        for i in 1 to 4 loop
+            channel_try_recv(ch, buf, len, valid);
+            assert valid;
+            assert len = 2;
+            assert buf(1) = i + 1;
+            assert buf(2) = i * 2 + 1;
+        end loop;
+
+        channel_try_recv(ch, buf, len, valid);
+        assert not valid;
+
+        channel_send(ch, (0 => 42));
+        wait for 1 ns;
+        channel_recv(ch, buf, len);
+        assert len = 1;
+        assert buf(1) = 43;
+
+        channel_close(ch);
+        wait;
+    end process;
+
+end architecture;
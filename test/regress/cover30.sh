@@ -0,0 +1,42 @@
+set -xe
+
+# Test indexed coverage database format
+for p in 0 1; do
+  nvc -a $TESTDIR/regress/cover27.vhd -e -gG_PAR=$p --cover=statement \
+      --cover-file=cover30_$p.ncdb cover27 -r
+  nvc -e -gG_PAR=$p --cover=statement --cover-file=cover30_$p.ncdx cover27 -r
+done
+
+[ -f cover30_0.ncdx ]
+
+# Merging indexed databases must give the same result as the default format
+nvc --cover-merge -o merged.ncdb cover30_0.ncdb cover30_1.ncdb
+nvc --cover-merge -o merged.ncdx cover30_0.ncdx cover30_1.ncdx
+nvc --cover-merge -o mixed.ncdb cover30_0.ncdx cover30_1.ncdb
+
+nvc --cover-export --format=xml -o a.xml merged.ncdb
+nvc --cover-export --format=xml -o b.xml merged.ncdx
+nvc --cover-export --format=xml -o c.xml mixed.ncdb
+
+diff -u a.xml b.xml
+diff -u a.xml c.xml
+
+# Databases with the same layout take the indexed fast path which must
+# apply the same per-kind merge rules, including when limited to a scope
+for i in 0 1; do
+  nvc -e -gG_PAR=0 --cover=statement,toggle,branch \
+      --cover-file=same_$i.ncdb cover27 -r
+  nvc -e -gG_PAR=0 --cover=statement,toggle,branch \
+      --cover-file=same_$i.ncdx cover27 -r
+done
+
+nvc --cover-merge -o same.ncdb same_0.ncdb same_1.ncdb
+nvc --cover-merge -o same.ncdx same_0.ncdx same_1.ncdx
+nvc --cover-export --format=xml -o d.xml same.ncdb
+nvc --cover-export --format=xml -o e.xml same.ncdx
+diff -u d.xml e.xml
+
+scope=WORK.COVER27.T_FOR_GEN\(1\)
+nvc --cover-report --scope=$scope -o html_ncdb same_0.ncdb same_1.ncdb
+nvc --cover-report --scope=$scope -o html_ncdx same_0.ncdx same_1.ncdx
+diff -r html_ncdb html_ncdx
@@ -0,0 +1,39 @@
+set -xe
+
+# Merging enough databases to use several parallel jobs must give the
+# same result as merging them one at a time
+nvc -a $TESTDIR/regress/cover27.vhd
+
+files=
+for i in $(seq 0 11); do
+  nvc -e -gG_PAR=$((i % 2)) --cover=statement,branch \
+      --cover-file=cover31_$i.ncdb cover27 -r
+  files="$files cover31_$i.ncdb"
+done
+
+cp cover31_0.ncdb serial.ncdb
+for i in $(seq 1 11); do
+  nvc --cover-merge -o tmp.ncdb serial.ncdb cover31_$i.ncdb
+  mv tmp.ncdb serial.ncdb
+done
+
+nvc --cover-merge -o parallel.ncdb $files
+
+nvc --cover-export --format=xml -o serial.xml serial.ncdb
+nvc --cover-export --format=xml -o parallel.xml parallel.ncdb
+diff -u serial.xml parallel.xml
+
+# Intersecting keeps the items of the first database and drops any
+# item that only appears in a later one
+cp cover31_0.ncdb serial.ncdb
+for i in $(seq 1 11); do
+  nvc --cover-merge --merge-mode=intersect -o tmp.ncdb serial.ncdb \
+      cover31_$i.ncdb
+  mv tmp.ncdb serial.ncdb
+done
+
+nvc --cover-merge --merge-mode=intersect -o parallel.ncdb $files
+
+nvc --cover-export --format=xml -o serial.xml serial.ncdb
+nvc --cover-export --format=xml -o parallel.xml parallel.ncdb
+diff -u serial.xml parallel.xml
@@ -0,0 +1,59 @@
+entity counter is
+    generic ( WIDTH : natural; STEP : natural := 1 );
+    port ( clk : in bit;
+           q   : out natural );
+end entity;
+
+architecture test of counter is
+    signal count : natural range 0 to 2**WIDTH - 1;
+begin
+    process (clk) is
+    begin
+        if clk'event and clk = '1' then
+            count <= (count + STEP) mod 2**WIDTH;
+        end if;
+    end process;
+
+    q <= count;
+end architecture;
+
+-------------------------------------------------------------------------------
+
+entity elab41 is
+end entity;
+
+architecture test of elab41 is
+    type nat_array is array (natural range <>) of natural;
+
+    signal clk : bit := '0';
+    signal q1  : nat_array(1 to 4);
+    signal q2  : nat_array(1 to 4);
+begin
+
+    g1: for i in 1 to 4 generate
+        u: entity work.counter
+            generic map ( WIDTH => 4 )
+            port map ( clk, q1(i) );
+    end generate;
+
+    g2: for i in 1 to 4 generate
+        u: entity work.counter
+            generic map ( WIDTH => 3, STEP => i )
+            port map ( clk, q2(i) );
+    end generate;
+
+    stim: process is
+    begin
+        for i in 1 to 10 loop
+            clk <= '1';
+            wait for 1 ns;
+            clk <= '0';
+            wait for 1 ns;
+        end loop;
+
+        assert q1 = (10, 10, 10, 10);
+        assert q2 = (2, 4, 6, 0);
+        wait;
+    end process;
+
+end architecture;
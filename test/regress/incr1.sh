@@ -0,0 +1,67 @@
+set -xe
+
+cat >pack.vhd <<EOF
+package pack is
+  impure function get return integer;
+end package;
+EOF
+
+cat >body.vhd <<EOF
+package body pack is
+  impure function get return integer is
+  begin
+    return 1;
+  end function;
+end package body;
+EOF
+
+cat >top.vhd <<EOF
+use work.pack.all;
+
+entity incr1 is
+end entity;
+
+architecture test of incr1 is
+begin
+  p: process is
+  begin
+    report "get = " & integer'image(get);
+    wait;
+  end process;
+end architecture;
+EOF
+
+nvc -a -V pack.vhd body.vhd top.vhd 2>err
+grep "analysed file: top.vhd" err
+nvc -e incr1 -r 2>&1 | grep "get = 1"
+
+# Only the modification times have changed
+touch pack.vhd body.vhd top.vhd
+nvc -a -V pack.vhd body.vhd top.vhd 2>err
+grep "skipped unchanged file: pack.vhd" err
+grep "skipped unchanged file: body.vhd" err
+grep "skipped unchanged file: top.vhd" err
+nvc -e incr1 -r >out 2>&1
+grep "get = 1" out
+grep "older than its source" out && exit 1
+
+# Changing a package body does not affect units that use the package
+sed -i 's/return 1/return 2/' body.vhd
+nvc -a -V pack.vhd body.vhd top.vhd 2>err
+grep "analysed file: body.vhd" err
+grep "skipped unchanged file: top.vhd" err
+nvc -e incr1 -r 2>&1 | grep "get = 2"
+
+# Changing the package declaration does
+sed -i 's/end package/  constant k : integer := 5;\nend package/' pack.vhd
+nvc -a -V pack.vhd body.vhd top.vhd 2>err
+grep "analysed file: pack.vhd" err
+grep "analysed file: top.vhd" err
+nvc -e incr1 -r 2>&1 | grep "get = 2"
+
+# Unchanged files are analysed again with --no-incremental
+nvc -a -V pack.vhd body.vhd top.vhd 2>err
+grep "skipped unchanged file: top.vhd" err
+nvc -a -V --no-incremental pack.vhd body.vhd top.vhd 2>err
+grep "skipped unchanged file" err && exit 1
+grep "analysed file: top.vhd" err
@@ -0,0 +1,29 @@
+module parallel1;
+   parameter N = 16;
+
+   reg [N-1:0]  a, b;
+   wire [N-1:0] x, y;
+
+   genvar i;
+   for (i = 0; i < N; i = i + 1) begin: g
+      adder u (.a(a[i]), .b(b[i]), .x(x[i]), .y(y[i]));
+   end
+
+   initial begin
+      a = 16'h1234;
+      b = 16'hff00;
+      #1;
+      $display("%h %h", x, y);
+      if (x === (a ^ b) && y === (a & b))
+        $display("PASSED");
+      else
+        $display("FAILED");
+      $finish;
+   end
+endmodule // parallel1
+
+module adder (input a, b, output x, output reg y);
+   assign x = a ^ b;
+
+   always @(*) y = a & b;
+endmodule // adder
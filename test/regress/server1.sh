@@ -0,0 +1,61 @@
+set -xe
+
+# Skip if built without server support
+nvc --help | grep -q -- --server || exit 0
+
+cat >hello.vhd <<EOF2
+use std.textio.all;
+
+entity server1 is
+end entity;
+
+architecture test of server1 is
+begin
+  process is
+    variable l : line;
+  begin
+    write(l, string'("hello from the server"));
+    writeline(output, l);
+    wait;
+  end process;
+end architecture;
+EOF2
+
+cat >new.vhd <<EOF2
+entity server1_08 is
+end entity;
+
+architecture test of server1_08 is
+begin
+  process is
+  begin
+    report to_string(42);               -- Only in VHDL-2008
+    wait;
+  end process;
+end architecture;
+EOF2
+
+nvc --std=1993 --server --socket=server1.sock &
+pid=$!
+trap "kill $pid" EXIT
+
+for i in $(seq 50); do
+  [ -S server1.sock ] && break
+  sleep 0.1
+done
+
+# Standard output of the request is relayed to the client
+nvc --connect=server1.sock --std=1993 --work=work93 -a hello.vhd \
+    -e server1 -r >out
+grep "hello from the server" out
+
+nvc --connect=server1.sock --std=2008 --work=work08 -a hello.vhd \
+    -e server1 -r >out
+grep "hello from the server" out
+
+# The server's --std option does not apply to requests
+nvc --connect=server1.sock --work=work08 -a new.vhd
+
+nvc --connect=server1.sock --std=1993 --work=work93 -a new.vhd 2>err \
+  && exit 1
+grep -i "to_string" err
@@ -0,0 +1,77 @@
+entity vhpi17 is
+end entity;
+
+architecture test of vhpi17 is
+    signal s0, s1, s2, s3, s4, s5, s6, s7 : integer;
+    signal s8, s9, s10, s11, s12, s13, s14, s15 : integer;
+    signal s16, s17, s18, s19, s20, s21, s22, s23 : integer;
+    signal s24, s25, s26, s27, s28, s29, s30, s31 : integer;
+    signal s32, s33, s34, s35, s36, s37, s38, s39 : integer;
+    signal s40, s41, s42, s43, s44, s45, s46, s47 : integer;
+    signal s48, s49, s50, s51, s52, s53, s54, s55 : integer;
+    signal s56, s57, s58, s59, s60, s61, s62, s63 : integer;
+    signal s64, s65, s66, s67, s68, s69, s70, s71 : integer;
+    signal s72, s73, s74, s75, s76, s77, s78, s79 : integer;
+    signal s80, s81, s82, s83, s84, s85, s86, s87 : integer;
+    signal s88, s89, s90, s91, s92, s93, s94, s95 : integer;
+    signal s96, s97, s98, s99, s100, s101, s102, s103 : integer;
+    signal s104, s105, s106, s107, s108, s109, s110, s111 : integer;
+    signal s112, s113, s114, s115, s116, s117, s118, s119 : integer;
+    signal s120, s121, s122, s123, s124, s125, s126, s127 : integer;
+    signal s128, s129, s130, s131, s132, s133, s134, s135 : integer;
+    signal s136, s137, s138, s139, s140, s141, s142, s143 : integer;
+    signal s144, s145, s146, s147, s148, s149, s150, s151 : integer;
+    signal s152, s153, s154, s155, s156, s157, s158, s159 : integer;
+    signal s160, s161, s162, s163, s164, s165, s166, s167 : integer;
+    signal s168, s169, s170, s171, s172, s173, s174, s175 : integer;
+    signal s176, s177, s178, s179, s180, s181, s182, s183 : integer;
+    signal s184, s185, s186, s187, s188, s189, s190, s191 : integer;
+    signal s192, s193, s194, s195, s196, s197, s198, s199 : integer;
+    signal s200, s201, s202, s203, s204, s205, s206, s207 : integer;
+    signal s208, s209, s210, s211, s212, s213, s214, s215 : integer;
+    signal s216, s217, s218, s219, s220, s221, s222, s223 : integer;
+    signal s224, s225, s226, s227, s228, s229, s230, s231 : integer;
+    signal s232, s233, s234, s235, s236, s237, s238, s239 : integer;
+    signal s240, s241, s242, s243, s244, s245, s246, s247 : integer;
+    signal s248, s249, s250, s251, s252, s253, s254, s255 : integer;
+    signal s256, s257, s258, s259, s260, s261, s262, s263 : integer;
+    signal s264, s265, s266, s267, s268, s269, s270, s271 : integer;
+    signal s272, s273, s274, s275, s276, s277, s278, s279 : integer;
+    signal s280, s281, s282, s283, s284, s285, s286, s287 : integer;
+    signal s288, s289, s290, s291, s292, s293, s294, s295 : integer;
+    signal s296, s297, s298, s299, s300, s301, s302, s303 : integer;
+    signal s304, s305, s306, s307, s308, s309, s310, s311 : integer;
+    signal s312, s313, s314, s315, s316, s317, s318, s319 : integer;
+    signal s320, s321, s322, s323, s324, s325, s326, s327 : integer;
+    signal s328, s329, s330, s331, s332, s333, s334, s335 : integer;
+    signal s336, s337, s338, s339, s340, s341, s342, s343 : integer;
+    signal s344, s345, s346, s347, s348, s349, s350, s351 : integer;
+    signal s352, s353, s354, s355, s356, s357, s358, s359 : integer;
+    signal s360, s361, s362, s363, s364, s365, s366, s367 : integer;
+    signal s368, s369, s370, s371, s372, s373, s374, s375 : integer;
+    signal s376, s377, s378, s379, s380, s381, s382, s383 : integer;
+    signal s384, s385, s386, s387, s388, s389, s390, s391 : integer;
+    signal s392, s393, s394, s395, s396, s397, s398, s399 : integer;
+    signal s400, s401, s402, s403, s404, s405, s406, s407 : integer;
+    signal s408, s409, s410, s411, s412, s413, s414, s415 : integer;
+    signal s416, s417, s418, s419, s420, s421, s422, s423 : integer;
+    signal s424, s425, s426, s427, s428, s429, s430, s431 : integer;
+    signal s432, s433, s434, s435, s436, s437, s438, s439 : integer;
+    signal s440, s441, s442, s443, s444, s445, s446, s447 : integer;
+    signal s448, s449, s450, s451, s452, s453, s454, s455 : integer;
+    signal s456, s457, s458, s459, s460, s461, s462, s463 : integer;
+    signal s464, s465, s466, s467, s468, s469, s470, s471 : integer;
+    signal s472, s473, s474, s475, s476, s477, s478, s479 : integer;
+    signal s480, s481, s482, s483, s484, s485, s486, s487 : integer;
+    signal s488, s489, s490, s491, s492, s493, s494, s495 : integer;
+    signal s496, s497, s498, s499, s500, s501, s502, s503 : integer;
+    signal s504, s505, s506, s507, s508, s509, s510, s511 : integer;
+begin
+
+    b: block is
+        signal x : bit;
+    begin
+        x <= '1' after 1 ns;
+    end block;
+
+end architecture;
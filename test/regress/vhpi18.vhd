@@ -0,0 +1,12 @@
+entity vhpi18 is
+end entity;
+
+architecture test of vhpi18 is
+    signal x, y, z : integer;
+begin
+
+    x <= 1 after 1 ns, 5 after 3 ns;
+    y <= 2 after 1 ns;
+    z <= 3 after 2 ns;
+
+end architecture;
@@ -0,0 +1,12 @@
+entity vhpi19 is
+end entity;
+
+architecture test of vhpi19 is
+    signal v : bit_vector(1 to 8);
+    signal n : integer;
+begin
+
+    v <= X"01" after 1 ns, X"a5" after 2 ns, X"a5" after 3 ns, X"ff" after 4 ns;
+    n <= 42 after 1 ns, 5 after 5 ns;
+
+end architecture;
@@ -0,0 +1,29 @@
+module vpi1;
+  wire [3:0] w1;
+  wire [7:0] w2;
+  reg [1:0]  r1;
+  reg [2:0]  r2;
+
+  assign w1 = 4'h5;
+  assign w2 = 8'h12;
+
+  if (1) begin : g
+    wire [4:0] gw;
+    reg [5:0]  gr;
+
+    assign gw = 5'h3;
+
+    initial begin
+      gr = 6'h2a;
+      #1 $vpi1_check;
+    end
+  end
+
+  initial begin
+    r1 = 1;
+    r2 = 2;
+    $vpi1_check;
+    #2 $display("PASSED");
+  end
+
+endmodule // vpi1
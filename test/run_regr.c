@@ -102,6 +102,8 @@
 #define F_ARRAYS  (1 << 26)
 #define F_SEED    (1 << 27)
 #define F_PERFILE (1 << 28)
+#define F_PARALL  (1 << 29)
+#define F_ACTIV   (1 << 30)
 
 typedef struct test test_t;
 typedef struct param param_t;
@@ -441,6 +443,10 @@ static bool parse_test_list(void)
             test->flags |= F_PERFILE;
          else if (strcmp(opt, "no-collapse") == 0)
             test->flags |= F_NOCOLL;
+         else if (strcmp(opt, "parallel") == 0)
+            test->flags |= F_PARALL;
+         else if (strcmp(opt, "profile-activity") == 0)
+            test->flags |= F_ACTIV;
          else if (strcmp(opt, "dump-arrays") == 0)
             test->flags |= F_ARRAYS;
          else if (strncmp(opt, "dump-arrays=", 12) == 0) {
@@ -955,6 +961,9 @@ static bool run_test(test_t *test)
       if (test->flags & F_NOCOLL)
          push_arg(&args, "--no-collapse");
 
+      if (test->flags & F_PARALL)
+         push_arg(&args, "--parallel");
+
       if (test->flags & F_COVER) {
          if (test->cover)
             push_arg(&args, "--cover=%s", test->cover);
@@ -1016,6 +1025,9 @@ static bool run_test(test_t *test)
       if (test->flags & F_SHUFFLE)
          push_arg(&args, "--shuffle");
 
+      if (test->flags & F_ACTIV)
+         push_arg(&args, "--profile-activity");
+
       if (test->plusarg != NULL)
          push_arg(&args, "+%s", test->plusarg);
 
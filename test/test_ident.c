@@ -124,6 +124,44 @@ START_TEST(test_read_write)
 }
 END_TEST
 
+START_TEST(test_read_write_mapped)
+{
+   ident_t i1 = ident_new("goobar");
+   ident_t i2 = ident_new("foo");
+
+   fbuf_t *f = fbuf_open("test.ident", FBUF_OUT, FBUF_CS_ADLER32);
+   fail_if(f == NULL);
+
+   fbuf_set_zip(f, FBUF_ZIP_NONE);
+
+   ident_wr_ctx_t wctx = ident_write_begin(f);
+   ident_write(i1, wctx);
+   ident_write(i2, wctx);
+   ident_write_end(wctx);
+
+   write_u32(0xdeadbeef, f);
+
+   uint32_t wsum;
+   fbuf_close(f, &wsum);
+
+   f = fbuf_open("test.ident", FBUF_IN, FBUF_CS_ADLER32);
+   fail_if(f == NULL);
+
+   ident_rd_ctx_t rctx = ident_read_begin(f);
+   ck_assert_ptr_eq(ident_read(rctx), i1);
+   ck_assert_ptr_eq(ident_read(rctx), i2);
+   ident_read_end(rctx);
+
+   ck_assert_int_eq(read_u32(f), 0xdeadbeef);
+
+   uint32_t rsum;
+   fbuf_close(f, &rsum);
+   ck_assert_int_eq(rsum, wsum);
+
+   remove("test.ident");
+}
+END_TEST
+
 START_TEST(test_prefix)
 {
    ident_t a, b, c, d, e, f;
@@ -431,6 +469,7 @@ Suite *get_ident_tests(void)
    tcase_add_test(tc_core, test_istr);
    tcase_add_test(tc_core, test_rand);
    tcase_add_test(tc_core, test_read_write);
+   tcase_add_test(tc_core, test_read_write_mapped);
    tcase_add_test(tc_core, test_prefix);
    tcase_add_test(tc_core, test_char);
    tcase_add_test(tc_core, test_until);
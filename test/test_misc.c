@@ -457,6 +457,15 @@ START_TEST(test_mask)
    ck_assert(!mask_test_and_set(&m, 5));
    ck_assert(mask_test_and_set(&m, 5));
 
+   mask_clearall(&m);
+
+   ck_assert(!mask_atomic_test_and_set_range(&m, 3, 10));
+   ck_assert(mask_atomic_test_and_set_range(&m, 3, 10));
+   ck_assert_int_eq(mask_popcount(&m), 10);
+   fail_if(mask_test(&m, 2));
+   fail_unless(mask_test(&m, 12));
+   fail_if(mask_test(&m, 13));
+
    mask_free(&m);
 }
 END_TEST
@@ -748,6 +757,79 @@ START_TEST(test_stop_world)
 }
 END_TEST
 
+static int safepoint_tid = -1;
+static int safepoint_iters = 0;
+static int safepoint_done = 0;
+
+static void safepoint_cb(int thread_id, struct cpu_state *cpu, void *arg)
+{
+   // Avoid ck_assert* here as it does I/O
+   if (thread_id == relaxed_load(&safepoint_tid))
+      (*(int *)arg)++;
+}
+
+static void *safepoint_thread_fn(void *__arg)
+{
+   store_release(&safepoint_tid, thread_id());
+
+   while (!relaxed_load(&safepoint_done)) {
+      safepoint_poll();
+      relaxed_add(&safepoint_iters, 1);
+   }
+
+   return NULL;
+}
+
+START_TEST(test_safepoint)
+{
+   nvc_thread_t *t = thread_create(safepoint_thread_fn, NULL, "safepoint");
+
+   while (relaxed_load(&safepoint_iters) == 0)
+      thread_sleep(100);
+
+   for (int i = 0; i < 10; i++) {
+      int calls = 0;
+      stop_world(safepoint_cb, &calls);
+
+      const int before = relaxed_load(&safepoint_iters);
+      thread_sleep(1000);
+      const int after = relaxed_load(&safepoint_iters);
+
+      start_world();
+
+      ck_assert_int_eq(calls, 1);
+      ck_assert_int_eq(before, after);
+   }
+
+   store_release(&safepoint_done, 1);
+   thread_join(t);
+}
+END_TEST
+
+static void stop_world_parallel_cb(int id, int count, void *arg)
+{
+   // Avoid ck_assert* here as it does I/O
+   assert(id < count);
+   atomic_add(&(((int *)arg)[id]), 1);
+}
+
+START_TEST(test_stop_world_parallel)
+{
+   int hits[MAX_THREADS] = {};
+
+   for (int i = 0; i < 10; i++) {
+      stop_world(stop_world_cb, (void *)0xdeadbeef);
+      stop_world_parallel(4, stop_world_parallel_cb, hits);
+      start_world();
+   }
+
+   ck_assert_int_eq(hits[0], 10);
+
+   for (int i = 1; i < MAX_THREADS; i++)
+      ck_assert(hits[i] == 0 || hits[i] == 10);
+}
+END_TEST
+
 static void *barrier_fn(void *__arg)
 {
    barrier_t *b = __arg;
@@ -927,6 +1009,8 @@ Suite *get_misc_tests(void)
    tcase_add_test(tc_thread, test_async);
 #ifndef __SANITIZE_THREAD__
    tcase_add_test(tc_thread, test_stop_world);
+   tcase_add_test(tc_thread, test_safepoint);
+   tcase_add_test(tc_thread, test_stop_world_parallel);
 #endif
    tcase_add_test(tc_thread, test_barrier);
    suite_add_tcase(s, tc_thread);
@@ -19,6 +19,7 @@
 #include "rt/mspace.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 START_TEST(test_sanity)
 {
@@ -269,6 +270,59 @@ START_TEST(test_tlab)
 }
 END_TEST
 
+static void fill_tlab(tlab_t *t, size_t bytes)
+{
+   for (int i = 0; i < bytes / 1024; i++) {
+      char *tmp = tlab_alloc(t, 1024);
+      ck_assert_ptr_nonnull(tmp);
+      tmp[0] = i;
+   }
+}
+
+START_TEST(test_tlab_grow)
+{
+   mspace_t *m = mspace_new(1024 * 1024);
+
+   tlab_t *t = tlab_acquire(m);
+   const uint32_t initial = t->limit;
+
+   // Each iteration behaves like a process that allocates more
+   // temporaries than fit in the TLAB before it is reset at the end of
+   // the run, which spills the rest into the heap
+   for (int i = 0; i < 100; i++) {
+      fill_tlab(t, 2 * TLAB_SIZE - 1024);
+      tlab_reset(t);
+   }
+
+   // The TLAB should have grown in place on the overflow path after a
+   // collection freed mostly spilled data
+   ck_assert_int_gt(t->limit, initial);
+
+   mspace_stats_t stats;
+   mspace_stats(m, &stats);
+   ck_assert_int_gt(stats.collections, 0);
+
+   const unsigned before = stats.collections;
+
+   for (int i = 0; i < 100; i++) {
+      fill_tlab(t, 2 * TLAB_SIZE - 1024);
+      tlab_reset(t);
+   }
+
+   // The same temporaries now fit entirely within the TLAB
+   mspace_stats(m, &stats);
+   ck_assert_int_eq(stats.collections, before);
+
+   // TLABs acquired later start at the larger size
+   tlab_t *t2 = tlab_acquire(m);
+   ck_assert_int_eq(t2->limit, t->limit);
+
+   tlab_release(t2);
+   tlab_release(t);
+   mspace_destroy(m);
+}
+END_TEST
+
 START_TEST(test_end_ptr)
 {
    mspace_t *m = mspace_new(5 * 1024);
@@ -294,6 +348,91 @@ START_TEST(test_end_ptr)
 }
 END_TEST
 
+START_TEST(test_size_classes)
+{
+   mspace_t *m = mspace_new(64 * 1024);
+
+   mptr_t p = mptr_new(m, "test");
+   char **objs = mspace_alloc(m, 64 * sizeof(char *));
+   *mptr_get(p) = objs;
+
+   for (int i = 0; i < 64; i++) {
+      const size_t size = 1 + (i * 37) % 1500;
+      objs[i] = mspace_alloc(m, size);
+      memset(objs[i], i, size);
+   }
+
+   // Mixed sizes split and reuse fragments across several collections
+   for (int i = 0; i < 5000; i++) {
+      char *garbage = mspace_alloc(m, 1 + rand() % 2000);
+      ck_assert_ptr_nonnull(garbage);
+      *garbage = 0xde;
+   }
+
+   for (int i = 0; i < 64; i++) {
+      const size_t size = 1 + (i * 37) % 1500;
+      for (size_t j = 0; j < size; j++)
+         ck_assert_int_eq(objs[i][j], i);
+   }
+
+   mptr_free(m, &p);
+   mspace_destroy(m);
+}
+END_TEST
+
+struct tree {
+   struct tree *left;
+   struct tree *right;
+   int          value;
+};
+
+__attribute__((noinline))
+static struct tree *build_tree(mspace_t *m, int depth, int *counter)
+{
+   if (depth == 0)
+      return NULL;
+
+   struct tree *t = mspace_alloc(m, sizeof(struct tree));
+   t->value = (*counter)++;
+   t->left  = build_tree(m, depth - 1, counter);
+   t->right = build_tree(m, depth - 1, counter);
+   return t;
+}
+
+static int check_tree(struct tree *t, int64_t *sum)
+{
+   if (t == NULL)
+      return 0;
+
+   *sum += t->value;
+   return 1 + check_tree(t->left, sum) + check_tree(t->right, sum);
+}
+
+START_TEST(test_parallel_mark)
+{
+   mspace_t *m = mspace_new(8 * 1024 * 1024);
+
+   // Enough live objects that marking is handed off to helper threads
+   mptr_t p = mptr_new(m, "tree");
+   int counter = 0;
+   *mptr_get(p) = build_tree(m, 16, &counter);
+
+   generate_garbage(m, 500000, 5 * sizeof(int));
+
+   int64_t sum = 0;
+   ck_assert_int_eq(check_tree(*mptr_get(p), &sum), counter);
+   ck_assert_int_eq(sum, (int64_t)counter * (counter - 1) / 2);
+
+   mspace_stats_t stats;
+   mspace_stats(m, &stats);
+   ck_assert_int_gt(stats.collections, 0);
+   ck_assert_int_le(stats.p50_us, stats.max_us);
+
+   mptr_free(m, &p);
+   mspace_destroy(m);
+}
+END_TEST
+
 Suite *get_mspace_tests(void)
 {
    Suite *s = suite_create("mspace");
@@ -307,7 +446,10 @@ Suite *get_mspace_tests(void)
    tcase_add_test(tc, test_oom);
    tcase_add_test(tc, test_linked_list);
    tcase_add_test(tc, test_tlab);
+   tcase_add_test(tc, test_tlab_grow);
    tcase_add_test(tc, test_end_ptr);
+   tcase_add_test(tc, test_size_classes);
+   tcase_add_test(tc, test_parallel_mark);
    suite_add_tcase(s, tc);
 
    return s;
@@ -7367,6 +7367,149 @@ START_TEST(test_protect1)
 }
 END_TEST
 
+START_TEST(test_scan1)
+{
+   input_from_file(TESTDIR "/parse/scan1.vhd");
+
+   tree_t p = parse_and_check(T_PACKAGE);
+   fail_unless(tree_decls(p) == 8);
+
+   tree_t c1 = tree_value(tree_decl(p, 0));
+   fail_unless(tree_kind(c1) == T_LITERAL);
+   ck_assert_int_eq(tree_ival(c1), 255);
+
+   tree_t c2 = tree_value(tree_decl(p, 1));
+   fail_unless(tree_kind(c2) == T_LITERAL);
+   ck_assert_int_eq(tree_ival(c2), 42);
+
+   const loc_t *l = tree_loc(c2);
+   ck_assert_int_eq(l->first_line, 2);
+   ck_assert_int_eq(l->first_column, 63);
+   ck_assert_int_eq(l->column_delta, 1);
+
+   fail_unless(tree_ident(tree_decl(p, 4)) == ident_new("\\ext\\"));
+
+   tree_t c5 = tree_value(tree_decl(p, 5));
+   fail_unless(tree_kind(c5) == T_LITERAL);
+   fail_unless(tree_dval(c5) == 1.5);
+
+   l = tree_loc(c5);
+   ck_assert_int_eq(l->first_line, 4);
+   ck_assert_int_eq(l->first_column, 62);
+   ck_assert_int_eq(l->column_delta, 2);
+
+   tree_t c7 = tree_value(tree_decl(p, 7));
+   fail_unless(tree_kind(c7) == T_FCALL);
+
+   l = tree_loc(tree_value(tree_param(c7, 1)));
+   ck_assert_int_eq(l->first_line, 6);
+   ck_assert_int_eq(l->first_column, 34);
+   ck_assert_int_eq(l->column_delta, 1);
+
+   fail_unless(parse() == NULL);
+
+   fail_if_errors();
+}
+END_TEST
+
+START_TEST(test_names4)
+{
+   input_from_file(TESTDIR "/parse/names4.vhd");
+
+   tree_t p = parse();
+   fail_if(p == NULL);
+   fail_unless(tree_kind(p) == T_PACKAGE);
+   lib_put(lib_work(), p);
+
+   tree_t b = parse();
+   fail_if(b == NULL);
+   fail_unless(tree_kind(b) == T_PACK_BODY);
+
+   // The overload set for "+" must be recomputed after each new
+   // declaration in the package body
+   tree_t f1 = tree_value(tree_stmt(tree_decl(b, 1), 0));
+   fail_unless(tree_kind(f1) == T_FCALL);
+   fail_unless(tree_flags(tree_ref(f1)) & TREE_F_PREDEFINED);
+
+   tree_t plus = tree_decl(b, 2);
+   fail_unless(tree_kind(plus) == T_FUNC_BODY);
+
+   tree_t f2 = tree_value(tree_stmt(tree_decl(b, 3), 0));
+   fail_unless(tree_kind(f2) == T_FCALL);
+   fail_unless(tree_ref(f2) == plus);
+
+   tree_t f3 = tree_value(tree_stmt(tree_decl(b, 4), 0));
+   fail_unless(tree_kind(f3) == T_FCALL);
+   fail_unless(tree_ref(f3) == tree_decl(b, 0));
+
+   fail_unless(parse() == NULL);
+
+   fail_if_errors();
+}
+END_TEST
+
+START_TEST(test_scan2)
+{
+   // The hand-written scanner must produce the same tokens as flex
+   // including pragma comments which are always passed to flex
+   static const char *files[] = { "scan1.vhd", "synth.vhd" };
+
+   extern loc_t yylloc;
+   extern yylval_t yylval;
+
+   int npragmas = 0;
+   for (int i = 0; i < ARRAY_LEN(files); i++) {
+      LOCAL_TEXT_BUF tb = tb_new();
+      tb_printf(tb, TESTDIR "/parse/%s", files[i]);
+
+      token_t tokens[2][256];
+      loc_t locs[2][256];
+      int ntokens[2];
+
+      for (int fast = 0; fast < 2; fast++) {
+         opt_set_int(OPT_FAST_SCAN, fast);
+         input_from_file(tb_get(tb));
+
+         int n = 0;
+         token_t tok;
+         do {
+            ck_assert_int_lt(n, 256);
+            tok = processed_yylex();
+            tokens[fast][n] = tok;
+            locs[fast][n++] = yylloc;
+            free_token(tok, &yylval);
+         } while (tok != tEOF);
+
+         ntokens[fast] = n;
+      }
+
+      ck_assert_int_eq(ntokens[0], ntokens[1]);
+
+      for (int j = 0; j < ntokens[0]; j++) {
+         ck_assert_str_eq(token_str(tokens[1][j]), token_str(tokens[0][j]));
+         fail_unless(loc_eq(&(locs[1][j]), &(locs[0][j])));
+
+         switch (tokens[0][j]) {
+         case tSYNTHOFF:
+         case tSYNTHON:
+         case tTRANSLATEOFF:
+         case tTRANSLATEON:
+         case tCOVERAGEOFF:
+         case tCOVERAGEON:
+            npragmas++;
+            break;
+         }
+      }
+   }
+
+   ck_assert_int_eq(npragmas, 4);
+
+   opt_set_int(OPT_FAST_SCAN, 1);
+
+   fail_if_errors();
+}
+END_TEST
+
 Suite *get_parse_tests(void)
 {
    Suite *s = suite_create("parse");
@@ -7554,6 +7697,9 @@ Suite *get_parse_tests(void)
    tcase_add_test(tc_core, test_issue1249);
    tcase_add_test(tc_core, test_issue1271);
    tcase_add_test(tc_core, test_protect1);
+   tcase_add_test(tc_core, test_scan1);
+   tcase_add_test(tc_core, test_scan2);
+   tcase_add_test(tc_core, test_names4);
    suite_add_tcase(s, tc_core);
 
    return s;
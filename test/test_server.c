@@ -35,6 +35,7 @@
 #define WIN32_LEAN_AND_MEAN
 #include <winsock2.h>
 #else
+#include <signal.h>
 #include <sys/socket.h>
 #include <sys/wait.h>
 #include <netinet/in.h>
@@ -333,14 +334,14 @@ static void wave_binary_frame(web_socket_t *ws, const void *data, size_t len,
       break;
 
    case 5:
-      ck_assert_int_eq(len, 9);
-      ck_assert_int_eq(bytes[0], S2C_SIGNAL_UPDATE);
-      ck_assert_int_eq(bytes[1] << 8 | bytes[2], 2);
-      ck_assert_int_eq(bytes[3], '/');
-      ck_assert_int_eq(bytes[4], 'x');
-      ck_assert_int_eq(bytes[5] << 8 | bytes[6], 2);
-      ck_assert_int_eq(bytes[7], 'b');
-      ck_assert_int_eq(bytes[8], '1');
+      ck_assert_int_eq(len, 22);
+      ck_assert_int_eq(bytes[0], S2C_SIGNAL_BATCH);
+      ck_assert_int_eq(UNPACK_BE64(bytes + 1), 1000000);
+      ck_assert_int_eq(UNPACK_BE32(bytes + 9), 1);
+      ck_assert_int_eq(UNPACK_BE32(bytes + 13), 0);   // Signal index
+      ck_assert_int_eq(bytes[17] << 8 | bytes[18], 1);   // Prefix "b"
+      ck_assert_int_eq(bytes[19] << 8 | bytes[20], 1);
+      ck_assert_int_eq(bytes[21], '1');
       break;
 
    case 6:
@@ -371,6 +372,9 @@ START_TEST(test_wave)
    };
    web_socket_t *ws = ws_new(sock, &handler, true);
 
+   const uint8_t delta[1] = { C2S_DELTA_VALUES };
+   ws_send_binary(ws, delta, sizeof(delta));
+
    ws_send_text(ws, "add wave /x");
    ws_flush(ws);
 
@@ -398,6 +402,161 @@ START_TEST(test_wave)
 }
 END_TEST
 
+static void trace_binary_frame(web_socket_t *ws, const void *data, size_t len,
+                               void *context)
+{
+   int *state = context;
+   const uint8_t *bytes = data;
+
+   if (bytes[0] != S2C_TRACE_DATA)
+      return;
+
+   ck_assert_int_eq(bytes[1] << 8 | bytes[2], 2);
+   ck_assert_mem_eq(bytes + 3, "/x", 2);
+   ck_assert_int_eq(UNPACK_BE32(bytes + 5), 2);
+
+   const uint8_t *p = bytes + 9;
+
+   switch ((*state)++) {
+   case 0:
+   case 2:
+      ck_assert_int_eq(len, 37);
+      ck_assert_int_eq(UNPACK_BE64(p), 0);
+      ck_assert_int_eq(UNPACK_BE32(p + 8), 2);
+      ck_assert_mem_eq(p + 12, "b0", 2);
+      ck_assert_int_eq(UNPACK_BE64(p + 14), 1000000);
+      ck_assert_mem_eq(p + 26, "b1", 2);
+      break;
+
+   case 1:
+      ck_assert_int_eq(len, 37);
+      ck_assert_int_eq(UNPACK_BE64(p), 1000000);
+      ck_assert_mem_eq(p + 12, "b1", 2);
+      ck_assert_int_eq(UNPACK_BE64(p + 14), 2000000);
+      ck_assert_mem_eq(p + 26, "b0", 2);
+      break;
+
+   default:
+      ck_abort_msg("unexpected trace data in state %d", *state - 1);
+   }
+}
+
+static void query_trace(web_socket_t *ws, const char *path, uint64_t start,
+                        uint64_t end)
+{
+   const size_t len = strlen(path);
+   uint8_t *packet LOCAL = xmalloc(3 + len + 16);
+   packet[0] = C2S_QUERY_TRACE;
+   packet[1] = len >> 8;
+   packet[2] = len & 0xff;
+   memcpy(packet + 3, path, len);
+
+   const uint8_t times[16] = { PACK_BE64(start), PACK_BE64(end) };
+   memcpy(packet + 3 + len, times, sizeof(times));
+
+   ws_send_binary(ws, packet, 3 + len + 16);
+   ws_flush(ws);
+}
+
+START_TEST(test_trace)
+{
+   input_from_file(TESTDIR "/shell/wave1.vhd");
+
+   tree_t top = run_elab();
+
+   char *tmp LOCAL = nvc_temp_file();
+   opt_set_str(OPT_TRACE_FILE, tmp);
+
+   pid_t pid = fork_server(SERVER_HTTP, top, NULL);
+   int sock = open_connection();
+   websocket_upgrade(sock);
+
+   int state = 0;
+   ws_handler_t handler = {
+      .text_frame = wave_text_frame,
+      .binary_frame = trace_binary_frame,
+      .context = &state
+   };
+   web_socket_t *ws = ws_new(sock, &handler, true);
+
+   ws_send_text(ws, "add wave /x");
+   ws_send_text(ws, "run 3 ns");
+   ws_flush(ws);
+
+   query_trace(ws, "/x", 0, 1500000);
+
+   while (state == 0)
+      ws_poll(ws);
+
+   query_trace(ws, "/x", 1500000, 3000000);
+
+   while (state == 1)
+      ws_poll(ws);
+
+   shutdown_server(ws);
+   ws_free(ws);
+
+   close(sock);
+   join_server(pid);
+
+   opt_set_str(OPT_TRACE_FILE, NULL);
+
+   // The trace file is kept with the chunk index at the end
+   FILE *f = fopen(tmp, "rb");
+   ck_assert_ptr_nonnull(f);
+
+   ck_assert_int_eq(fseek(f, 0, SEEK_END), 0);
+   const long size = ftell(f);
+   ck_assert_int_ge(size, 12);
+
+   uint8_t *contents LOCAL = xmalloc(size);
+   rewind(f);
+   ck_assert_int_eq(fread(contents, size, 1, f), 1);
+   fclose(f);
+
+   ck_assert_int_eq(UNPACK_BE32(contents + size - 4), 0x4e564354);
+
+   const uint64_t index = UNPACK_BE64(contents + size - 12);
+   ck_assert_int_lt(index, size - 12);
+
+   const uint8_t *p = contents + index;
+   ck_assert_int_eq(UNPACK_BE32(p), 1);             // Columns
+   ck_assert_int_eq(p[4] << 8 | p[5], 2);
+   ck_assert_mem_eq(p + 6, "/x", 2);
+   ck_assert_int_eq(UNPACK_BE32(p + 8), 1);         // Chunks
+   ck_assert_int_eq(UNPACK_BE64(p + 12), 0);        // Start time
+   ck_assert_int_eq(UNPACK_BE64(p + 20), 2000000);  // End time
+   ck_assert_int_eq(UNPACK_BE64(p + 28), 0);        // Offset
+   ck_assert_int_eq(UNPACK_BE32(p + 36), index);    // Size
+   ck_assert_int_eq(UNPACK_BE32(p + 40), 3);        // Changes
+
+   // A new server opened on the same file can query the old history
+   // without running the simulation again
+   opt_set_str(OPT_TRACE_FILE, tmp);
+
+   pid = fork_server(SERVER_HTTP, NULL, NULL);
+   sock = open_connection();
+   websocket_upgrade(sock);
+
+   ws = ws_new(sock, &handler, true);
+
+   query_trace(ws, "/x", 0, 1500000);
+
+   while (state == 2)
+      ws_poll(ws);
+
+   shutdown_server(ws);
+   ws_free(ws);
+
+   close(sock);
+   join_server(pid);
+
+   opt_set_str(OPT_TRACE_FILE, NULL);
+
+   remove(tmp);
+}
+END_TEST
+
 static void pong_handler(web_socket_t *ws, const void *data, size_t len,
                          void *user)
 {
@@ -593,6 +752,69 @@ START_TEST(test_bad_command)
 }
 END_TEST
 
+static int compile_request(int argc, char **argv, void *ctx)
+{
+   FILE *f = fopen("compile_server.out", "w");
+   fail_if(f == NULL);
+
+   for (int i = 1; i < argc; i++)
+      fprintf(f, "%s;", argv[i]);
+
+   fclose(f);
+
+   printf("hello from %s\n", (char *)ctx);
+   return 40 + argc;
+}
+
+START_TEST(test_compile)
+{
+#ifdef __MINGW32__
+   ck_abort_msg("not supported on Windows");
+#else
+   int rfd, wfd;
+   open_pipe(&rfd, &wfd);
+
+   pid_t pid = fork();
+   if (pid == 0) {
+      close(rfd);
+
+      start_compile_server("test.sock", compile_request, "server",
+                           server_ready_cb, (void *)(intptr_t)wfd);
+
+      exit(0);
+   }
+   else if (pid < 0)
+      fatal_errno("fork");
+
+   close(wfd);
+
+   uint8_t token[1];
+   if (read(rfd, token, 1) != 1)
+      fatal_errno("read pipe");
+
+   close(rfd);
+
+   char *args[] = { "-a", "foo.vhd" };
+   ck_assert_int_eq(compile_client("test.sock", 2, args), 43);
+
+   FILE *f = fopen("compile_server.out", "r");
+   fail_if(f == NULL);
+
+   char buf[64];
+   fail_if(fgets(buf, sizeof(buf), f) == NULL);
+   ck_assert_str_eq(buf, "-a;foo.vhd;");
+
+   fclose(f);
+   remove("compile_server.out");
+
+   kill(pid, SIGTERM);
+   join_server(pid);
+
+   ck_assert_int_eq(access("test.sock", F_OK), -1);
+#endif
+}
+END_TEST
+
 Suite *get_server_tests(void)
 {
    Suite *s = suite_create("server");
@@ -602,9 +824,11 @@ Suite *get_server_tests(void)
    tcase_add_test(tc, test_dirty_close);
    tcase_add_test(tc, test_second_connection);
    tcase_add_test(tc, test_wave);
+   tcase_add_test(tc, test_trace);
    tcase_add_test(tc, test_ping);
    tcase_add_test(tc, test_greeting);
    tcase_add_test(tc, test_bad_command);
+   tcase_add_test(tc, test_compile);
    suite_add_tcase(s, tc);
 
    return s;
@@ -0,0 +1,98 @@
+#include "vhpi_test.h"
+#include "nvc_channel.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __MINGW32__
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#endif
+
+static nvc_channel_t *channel = NULL;
+static int            messages = 0;
+
+static nvc_channel_t *attach_channel(const char *path)
+{
+   // Acts as a foreign model mapping the file created by the simulator
+   int fd = open(path, O_RDWR);
+   if (fd < 0)
+      return NULL;
+
+   struct stat st;
+   if (fstat(fd, &st) != 0 || st.st_size < sizeof(nvc_channel_t)) {
+      close(fd);
+      return NULL;
+   }
+
+#ifdef __MINGW32__
+   HANDLE handle = CreateFileMapping((HANDLE)_get_osfhandle(fd), NULL,
+                                     PAGE_READWRITE, 0, st.st_size, NULL);
+   fail_if(handle == NULL);
+
+   void *map = MapViewOfFileEx(handle, FILE_MAP_ALL_ACCESS, 0, 0,
+                               st.st_size, NULL);
+   CloseHandle(handle);
+   fail_if(map == NULL);
+#else
+   void *map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    fd, 0);
+   fail_if(map == MAP_FAILED);
+#endif
+
+   close(fd);
+
+   nvc_channel_t *ch = map;
+   fail_unless(nvc_channel_valid(ch));
+   fail_unless(ch->depth == 4);
+   fail_unless(ch->width == 4);
+   fail_unless(st.st_size == nvc_channel_size(ch->depth, ch->width));
+
+   return ch;
+}
+
+static void end_of_time_step(const vhpiCbDataT *cb_data)
+{
+   if (channel == NULL && (channel = attach_channel("channel1.q")) == NULL)
+      return;
+
+   // Reply to each message with every word incremented
+   uint32_t count;
+   const int32_t *words;
+   while ((words = nvc_channel_front(channel, NVC_CHANNEL_TO_MODEL, &count))) {
+      int32_t reply[4];
+      fail_unless(count <= 4);
+      for (int i = 0; i < count; i++)
+         reply[i] = words[i] + 1;
+
+      nvc_channel_release(channel, NVC_CHANNEL_TO_MODEL);
+
+      fail_unless(nvc_channel_push(channel, NVC_CHANNEL_TO_SIM, reply, count));
+      messages++;
+   }
+}
+
+static void end_of_sim(const vhpiCbDataT *cb_data)
+{
+   vhpi_printf("model received %d messages", messages);
+   fail_unless(messages == 5);
+}
+
+void channel1_startup(void)
+{
+   vhpiCbDataT cb_data1 = {
+      .reason = vhpiCbRepEndOfTimeStep,
+      .cb_rtn = end_of_time_step,
+   };
+   VHPI_CHECK(vhpi_register_cb(&cb_data1, 0));
+
+   vhpiCbDataT cb_data2 = {
+      .reason = vhpiCbEndOfSimulation,
+      .cb_rtn = end_of_sim,
+   };
+   VHPI_CHECK(vhpi_register_cb(&cb_data2, 0));
+}
@@ -0,0 +1,113 @@
+#include "vhpi_test.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define NSIGNALS 512
+#define ROUNDS   4
+#define WINDOW   16
+
+// Handles encode a slot index in the low half and a generation count
+// in the high half
+#define HANDLE_INDEX(h) \
+   ((uintptr_t)(h) & ((UINTMAX_C(1) << (sizeof(vhpiHandleT) * 4)) - 1))
+
+static void check_stale_handle(void)
+{
+   vhpiHandleT root = VHPI_CHECK(vhpi_handle(vhpiRootInst, NULL));
+   fail_if(root == NULL);
+
+   vhpiHandleT s0 = VHPI_CHECK(vhpi_handle_by_name("S0", root));
+   fail_if(s0 == NULL);
+   fail_unless(vhpi_release_handle(s0) == 0);
+
+   // The slot freed above is the next one to be reused
+   vhpiHandleT s1 = VHPI_CHECK(vhpi_handle_by_name("S1", root));
+   fail_if(s1 == NULL);
+   fail_unless(HANDLE_INDEX(s1) == HANDLE_INDEX(s0));
+   fail_if(s1 == s0);
+
+   vhpiErrorInfoT info;
+
+   // The released handle must not refer to the new object
+   fail_unless(vhpi_get_str(vhpiNameP, s0) == NULL);
+   fail_unless(vhpi_check_error(&info));
+
+   fail_unless(vhpi_release_handle(s0) == 1);
+   fail_unless(vhpi_check_error(&info));
+
+   check_string(VHPI_CHECK(vhpi_get_str(vhpiNameP, s1)), "S1");
+
+   vhpi_release_handle(s1);
+   vhpi_release_handle(root);
+}
+
+static void check_slot_reuse(void)
+{
+   vhpiHandleT root = VHPI_CHECK(vhpi_handle(vhpiRootInst, NULL));
+   fail_if(root == NULL);
+
+   // Look up every signal by name repeatedly while keeping a small
+   // window of live handles: released slots must be reused rather than
+   // growing the handle table
+   uintptr_t min_index = UINTPTR_MAX, max_index = 0;
+   vhpiHandleT window[WINDOW] = {};
+   for (int round = 0; round < ROUNDS; round++) {
+      for (int i = 0; i < NSIGNALS; i++) {
+         char name[16];
+         snprintf(name, sizeof(name), "S%d", i);
+
+         vhpiHandleT h = VHPI_CHECK(vhpi_handle_by_name(name, root));
+         fail_if(h == NULL);
+
+         if (round == 0)
+            check_string(vhpi_get_str(vhpiNameP, h), name);
+
+         if (window[i % WINDOW] != NULL)
+            vhpi_release_handle(window[i % WINDOW]);
+         window[i % WINDOW] = h;
+
+         const uintptr_t index = HANDLE_INDEX(h);
+         if (index < min_index) min_index = index;
+         if (index > max_index) max_index = index;
+      }
+   }
+
+   for (int i = 0; i < WINDOW; i++)
+      vhpi_release_handle(window[i]);
+
+   // At most WINDOW handles plus the one just looked up are live
+   fail_unless(max_index - min_index <= WINDOW);
+
+   // Hierarchical lookups that release their handle keep reusing the
+   // same slot
+   vhpiHandleT first = VHPI_CHECK(vhpi_handle_by_name("vhpi17.b.x", NULL));
+   fail_if(first == NULL);
+   check_string(VHPI_CHECK(vhpi_get_str(vhpiNameP, first)), "X");
+   vhpi_release_handle(first);
+
+   for (int i = 0; i < NSIGNALS; i++) {
+      vhpiHandleT x = VHPI_CHECK(vhpi_handle_by_name("vhpi17.b.x", NULL));
+      fail_if(x == NULL);
+      fail_unless(HANDLE_INDEX(x) == HANDLE_INDEX(first));
+      vhpi_release_handle(x);
+   }
+
+   vhpi_release_handle(root);
+}
+
+static void start_of_sim(const vhpiCbDataT *cb_data)
+{
+   check_stale_handle();
+   check_slot_reuse();
+}
+
+void vhpi17_startup(void)
+{
+   vhpiCbDataT cb_data = {
+      .reason = vhpiCbStartOfSimulation,
+      .cb_rtn = start_of_sim,
+   };
+   VHPI_CHECK(vhpi_register_cb(&cb_data, 0));
+}
@@ -0,0 +1,92 @@
+#include "vhpi_test.h"
+
+#include <stdint.h>
+
+static int ncalls = 0;
+static vhpiValueT values[3];
+
+static void batch_cb(const vhpiCbDataT *cb_data)
+{
+   fail_unless(cb_data->reason == vhpiCbValueChangeBatch);
+   fail_if(cb_data->value == NULL);
+   fail_unless(cb_data->value->format == vhpiPtrVal);
+
+   const vhpiValueChangeT *changes = cb_data->value->value.ptr;
+   const int nchanges = cb_data->value->numElems;
+
+   vhpi_printf("%d changes at %u fs", nchanges, cb_data->time->low);
+
+   for (int i = 0; i < nchanges; i++) {
+      const vhpiCharT *name =
+         VHPI_CHECK(vhpi_get_str(vhpiNameP, changes[i].obj));
+      vhpi_printf("%s = %d", name, changes[i].value->value.intg);
+
+      const int index = (intptr_t)changes[i].user_data;
+      fail_unless(changes[i].value == &(values[index]));
+   }
+
+   switch (ncalls++) {
+   case 0:
+      fail_unless(nchanges == 2);
+      fail_unless(values[0].value.intg == 1);
+      fail_unless(values[1].value.intg == 2);
+      break;
+   case 1:
+      fail_unless(nchanges == 1);
+      fail_unless(changes[0].user_data == (void *)2);
+      fail_unless(values[2].value.intg == 3);
+      break;
+   case 2:
+      fail_unless(nchanges == 1);
+      fail_unless(changes[0].user_data == (void *)0);
+      fail_unless(values[0].value.intg == 5);
+      break;
+   default:
+      vhpi_assert(vhpiFailure, "unexpected batch callback");
+   }
+}
+
+static void end_of_sim(const vhpiCbDataT *cb_data)
+{
+   fail_unless(ncalls == 3);
+}
+
+static void start_of_sim(const vhpiCbDataT *cb_data)
+{
+   vhpiHandleT root = VHPI_CHECK(vhpi_handle(vhpiRootInst, NULL));
+
+   static const char *names[] = { "x", "y", "z" };
+   for (int i = 0; i < 3; i++) {
+      vhpiHandleT h = VHPI_CHECK(vhpi_handle_by_name(names[i], root));
+
+      values[i].format = vhpiIntVal;
+
+      vhpiCbDataT cb_data = {
+         .reason    = vhpiCbValueChangeBatch,
+         .cb_rtn    = batch_cb,
+         .obj       = h,
+         .value     = &(values[i]),
+         .user_data = (void *)(intptr_t)i,
+      };
+      VHPI_CHECK(vhpi_register_cb(&cb_data, 0));
+
+      vhpi_release_handle(h);
+   }
+
+   vhpi_release_handle(root);
+}
+
+void vhpi18_startup(void)
+{
+   vhpiCbDataT cb_data1 = {
+      .reason = vhpiCbStartOfSimulation,
+      .cb_rtn = start_of_sim,
+   };
+   VHPI_CHECK(vhpi_register_cb(&cb_data1, 0));
+
+   vhpiCbDataT cb_data2 = {
+      .reason = vhpiCbEndOfSimulation,
+      .cb_rtn = end_of_sim,
+   };
+   VHPI_CHECK(vhpi_register_cb(&cb_data2, 0));
+}
@@ -0,0 +1,105 @@
+#include "vhpi_test.h"
+
+#include <stdint.h>
+#include <string.h>
+
+static vhpiHandleT v_handle, n_handle;
+static vhpiValueViewT v_view, n_view;
+static uint32_t v_gen, n_gen;
+static int v_changes, n_changes;
+
+static void end_of_time_step(const vhpiCbDataT *cb_data)
+{
+   if (*v_view.generation != v_gen) {
+      v_gen = *v_view.generation;
+      v_changes++;
+   }
+
+   if (*n_view.generation != n_gen) {
+      n_gen = *n_view.generation;
+      n_changes++;
+   }
+
+   // The view must always agree with vhpi_get_value
+   vhpiEnumT bits[8];
+   vhpiValueT value = {
+      .format = vhpiLogicVecVal,
+      .bufSize = sizeof(bits),
+      .value.enumvs = bits,
+   };
+   fail_unless(VHPI_CHECK(vhpi_get_value(v_handle, &value)) == 0);
+
+   const uint8_t *data = v_view.data;
+   for (int i = 0; i < 8; i++)
+      fail_unless(data[i] == bits[i]);
+
+   vhpiValueT intval = { .format = vhpiIntVal };
+   VHPI_CHECK(vhpi_get_value(n_handle, &intval));
+   fail_unless(*(const int32_t *)n_view.data == intval.value.intg);
+}
+
+static void end_of_sim(const vhpiCbDataT *cb_data)
+{
+   vhpi_printf("v changed %d times, n changed %d times", v_changes,
+               n_changes);
+
+   // The transaction at 3 ns does not change the value
+   fail_unless(v_changes == 3);
+   fail_unless(n_changes == 2);
+
+   vhpi_release_handle(v_handle);
+   vhpi_release_handle(n_handle);
+}
+
+static void start_of_sim(const vhpiCbDataT *cb_data)
+{
+   vhpiHandleT root = VHPI_CHECK(vhpi_handle(vhpiRootInst, NULL));
+
+   v_handle = VHPI_CHECK(vhpi_handle_by_name("v", root));
+   n_handle = VHPI_CHECK(vhpi_handle_by_name("n", root));
+
+   fail_unless(VHPI_CHECK(vhpi_get_value_view(v_handle, &v_view)) == 0);
+   fail_unless(v_view.format == vhpiLogicVecVal);
+   fail_unless(v_view.numElems == 8);
+   fail_unless(v_view.elemSize == 1);
+
+   fail_unless(VHPI_CHECK(vhpi_get_value_view(n_handle, &n_view)) == 0);
+   fail_unless(n_view.format == vhpiIntVal);
+   fail_unless(n_view.numElems == 1);
+   fail_unless(n_view.elemSize == 4);
+
+   v_gen = *v_view.generation;
+   n_gen = *n_view.generation;
+
+   // A view of a single element points into the same storage
+   vhpiHandleT v3 = VHPI_CHECK(vhpi_handle_by_index(vhpiIndexedNames,
+                                                    v_handle, 2));
+   vhpiValueViewT v3_view;
+   fail_unless(VHPI_CHECK(vhpi_get_value_view(v3, &v3_view)) == 0);
+   fail_unless(v3_view.data == (const uint8_t *)v_view.data + 2);
+   fail_unless(v3_view.generation == v_view.generation);
+   vhpi_release_handle(v3);
+
+   vhpi_release_handle(root);
+
+   vhpiCbDataT cb_data1 = {
+      .reason = vhpiCbRepEndOfTimeStep,
+      .cb_rtn = end_of_time_step,
+   };
+   VHPI_CHECK(vhpi_register_cb(&cb_data1, 0));
+
+   vhpiCbDataT cb_data2 = {
+      .reason = vhpiCbEndOfSimulation,
+      .cb_rtn = end_of_sim,
+   };
+   VHPI_CHECK(vhpi_register_cb(&cb_data2, 0));
+}
+
+void vhpi19_startup(void)
+{
+   vhpiCbDataT cb_data = {
+      .reason = vhpiCbStartOfSimulation,
+      .cb_rtn = start_of_sim,
+   };
+   VHPI_CHECK(vhpi_register_cb(&cb_data, 0));
+}
@@ -57,6 +57,11 @@ static const vhpi_test_t tests[] = {
    { "issue1240", issue1240_startup },
    { "vhpi16",    vhpi16_startup },
    { "issue1301", NULL },
+   { "vhpi17",    vhpi17_startup },
+   { "vhpi18",    vhpi18_startup },
+   { "vhpi19",    vhpi19_startup },
+   { "channel1",  channel1_startup },
+   { "vpi1",      vpi1_startup },
    { NULL,        NULL },
 };
 
@@ -55,6 +55,11 @@ void vhpi13_startup(void);
 void vhpi14_startup(void);
 void vhpi15_startup(void);
 void vhpi16_startup(void);
+void vhpi17_startup(void);
+void vhpi18_startup(void);
+void vhpi19_startup(void);
+void channel1_startup(void);
+void vpi1_startup(void);
 void issue744_startup(void);
 void issue762_startup(void);
 void issue978_startup(void);
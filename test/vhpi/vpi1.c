@@ -0,0 +1,86 @@
+#include "vhpi_test.h"
+#include "vpi_user.h"
+
+static int count_decls(vpiHandle scope, PLI_INT32 type, int *total_size)
+{
+   vpiHandle it = vpi_iterate(type, scope);
+   fail_if(it == NULL);
+
+   int count = 0;
+   for (vpiHandle h; (h = vpi_scan(it)); count++) {
+      fail_unless(vpi_get(vpiType, h) == type);
+
+      *total_size += vpi_get(vpiSize, h);
+
+      // The declaration must refer back to the scope it was found in
+      vpiHandle s = vpi_handle(vpiScope, h);
+      fail_if(s == NULL);
+      fail_unless(vpi_get(vpiType, s) == vpi_get(vpiType, scope));
+      vpi_release_handle(s);
+
+      // The module is the enclosing module instance even for
+      // declarations inside a generate scope
+      vpiHandle m = vpi_handle(vpiModule, h);
+      fail_if(m == NULL);
+      fail_unless(vpi_get(vpiType, m) == vpiModule);
+      vpi_release_handle(m);
+
+      vpi_release_handle(h);
+   }
+
+   vpi_release_handle(it);
+   return count;
+}
+
+static PLI_INT32 vpi1_check(PLI_BYTE8 *user_data)
+{
+   vpiHandle call = vpi_handle(vpiSysTfCall, NULL);
+   fail_if(call == NULL);
+   fail_unless(vpi_get(vpiType, call) == vpiSysTaskCall);
+
+   vpiHandle scope = vpi_handle(vpiScope, call);
+   fail_if(scope == NULL);
+
+   int net_size = 0, reg_size = 0;
+   const int nnets = count_decls(scope, vpiNet, &net_size);
+   const int nregs = count_decls(scope, vpiReg, &reg_size);
+
+   switch (vpi_get(vpiType, scope)) {
+   case vpiModule:
+      // wire [3:0] w1, wire [7:0] w2, reg [1:0] r1, reg [2:0] r2
+      fail_unless(nnets == 2);
+      fail_unless(net_size == 12);
+      fail_unless(nregs == 2);
+      fail_unless(reg_size == 5);
+      break;
+   case vpiGenScope:
+      // wire [4:0] gw, reg [5:0] gr
+      fail_unless(nnets == 1);
+      fail_unless(net_size == 5);
+      fail_unless(nregs == 1);
+      fail_unless(reg_size == 6);
+      break;
+   default:
+      vhpi_assert(vhpiFailure, "unexpected scope type %d",
+                  vpi_get(vpiType, scope));
+   }
+
+   // Iterating a second time must give the same result
+   int size2 = 0;
+   fail_unless(count_decls(scope, vpiReg, &size2) == nregs);
+   fail_unless(size2 == reg_size);
+
+   vpi_release_handle(scope);
+   vpi_release_handle(call);
+   return 0;
+}
+
+void vpi1_startup(void)
+{
+   s_vpi_systf_data tf_data = {
+      .type   = vpiSysTask,
+      .tfname = "$vpi1_check",
+      .calltf = vpi1_check,
+   };
+   vpi_register_systf(&tf_data);
+}